@@ -0,0 +1,118 @@
+#include "driver/i2c_dma.h"
+
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+// This driver writes a transaction to an I2C device without CPU. Bytes are
+// queued as 16-bit words for IC_DATA_CMD register, because the upper bits of
+// the register control STOP and RESTART conditions and an 8-bit DMA write
+// would be replicated into them. DMA feeds the words to TX FIFO by DREQ, and
+// the I2C IRQ detects STOP condition to notify completion.
+//
+// The IRQ is unmasked only while a transaction is in progress, so blocking
+// functions of hardware_i2c can be used on the same controller between
+// transactions.
+
+static i2c_dma_t *instances[NUM_I2CS] = {0};
+
+static void i2c_dma_handle_irq(uint index) {
+    i2c_dma_t *d = instances[index];
+    if (d == NULL) {
+        return;
+    }
+    i2c_hw_t *hw = i2c_get_hw(d->i2c);
+    uint32_t stat = hw->intr_stat;
+    if (stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // The controller flushed TX FIFO by NACK or so. Stop DMA before
+        // clearing the abort, which releases TX FIFO.
+        dma_channel_abort(d->dma_chan);
+        (void)hw->clr_tx_abrt;
+        d->failed = true;
+    }
+    if (stat & I2C_IC_INTR_STAT_R_STOP_DET_BITS) {
+        (void)hw->clr_stop_det;
+        hw->intr_mask = 0;
+        d->busy = false;
+        if (d->completed != NULL) {
+            d->completed(d, !d->failed);
+        }
+    }
+}
+
+static void __isr on_i2c0_irq() {
+    i2c_dma_handle_irq(0);
+}
+
+static void __isr on_i2c1_irq() {
+    i2c_dma_handle_irq(1);
+}
+
+void i2c_dma_init(i2c_dma_t *d, i2c_inst_t *i2c, uint16_t *buf, uint buf_size) {
+    uint index = i2c_get_index(i2c);
+    d->i2c = i2c;
+    d->buf = buf;
+    d->buf_size = buf_size;
+    d->len = 0;
+    d->busy = false;
+    d->failed = false;
+
+    // setup DMA to feed TX FIFO.
+    d->dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(d->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+    dma_channel_configure(d->dma_chan, &c, &i2c_get_hw(i2c)->data_cmd, buf,
+            0, false);
+
+    i2c_hw_t *hw = i2c_get_hw(i2c);
+    hw->intr_mask = 0;
+    hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+
+    instances[index] = d;
+    uint irq = index == 0 ? I2C0_IRQ : I2C1_IRQ;
+    irq_set_exclusive_handler(irq, index == 0 ? on_i2c0_irq : on_i2c1_irq);
+    irq_set_enabled(irq, true);
+}
+
+bool i2c_dma_begin(i2c_dma_t *d) {
+    if (d->busy) {
+        return false;
+    }
+    d->len = 0;
+    return true;
+}
+
+void i2c_dma_put_buf(i2c_dma_t *d, const uint8_t *src, uint len) {
+    uint n = len;
+    if (d->len + n > d->buf_size) {
+        n = d->len < d->buf_size ? d->buf_size - d->len : 0;
+    }
+    uint16_t *dst = d->buf + d->len;
+    for (uint i = 0; i < n; i++) {
+        dst[i] = src[i];
+    }
+    d->len += len;
+}
+
+bool i2c_dma_start(i2c_dma_t *d, uint8_t addr) {
+    if (d->busy || d->len == 0 || d->len > d->buf_size) {
+        return false;
+    }
+    d->buf[d->len - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    i2c_hw_t *hw = i2c_get_hw(d->i2c);
+    // target address can be changed only while the controller is disabled.
+    hw->enable = 0;
+    hw->tar = addr;
+    hw->enable = 1;
+    (void)hw->clr_stop_det;
+    (void)hw->clr_tx_abrt;
+
+    d->failed = false;
+    d->busy = true;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+    dma_channel_transfer_from_buffer_now(d->dma_chan, d->buf, d->len);
+    return true;
+}
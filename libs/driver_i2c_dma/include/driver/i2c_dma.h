@@ -0,0 +1,70 @@
+#pragma once
+
+#include <pico/types.h>
+
+#include "hardware/i2c.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+typedef struct i2c_dma_s i2c_dma_t;
+
+typedef void (*i2c_dma_completed_cb)(i2c_dma_t *d, bool ok);
+
+struct i2c_dma_s {
+    void *user;
+    i2c_dma_completed_cb completed;
+
+    i2c_inst_t *i2c;
+    uint dma_chan;
+
+    // Words for IC_DATA_CMD register. Lower 8 bits are data, and STOP bit is
+    // added to the last word by i2c_dma_start().
+    uint16_t *buf;
+    uint buf_size;
+    uint len;
+
+    volatile bool busy;
+    volatile bool failed;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// i2c_dma_init prepares a DMA channel and IRQ handler for writes to an I2C
+// controller. The I2C controller should be initialized by i2c_init() before.
+// buf is used to build transactions, and must have buf_size words.
+void i2c_dma_init(i2c_dma_t *d, i2c_inst_t *i2c, uint16_t *buf, uint buf_size);
+
+// i2c_dma_begin discards queued bytes to build a new transaction. It returns
+// false when the previous transaction is in progress.
+bool i2c_dma_begin(i2c_dma_t *d);
+
+// i2c_dma_put_buf queues bytes to the transaction being built.
+void i2c_dma_put_buf(i2c_dma_t *d, const uint8_t *src, uint len);
+
+// i2c_dma_start starts to write queued bytes to the device in background.
+// Completion is notified by d->completed from IRQ, and d->busy becomes false.
+// It returns false when busy, nothing queued or the buffer overflowed.
+bool i2c_dma_start(i2c_dma_t *d, uint8_t addr);
+
+// i2c_dma_busy returns true while a transaction is in progress.
+static inline bool i2c_dma_busy(i2c_dma_t *d) {
+    return d->busy;
+}
+
+// i2c_dma_put queues a byte to the transaction being built.
+static inline void i2c_dma_put(i2c_dma_t *d, uint8_t b) {
+    if (d->len < d->buf_size) {
+        d->buf[d->len] = b;
+    }
+    d->len++;
+}
+
+#ifdef __cplusplus
+}
+#endif
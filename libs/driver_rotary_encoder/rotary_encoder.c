@@ -1,6 +1,12 @@
 #include "driver/rotary_encoder.h"
 #include "hardware/gpio.h"
 
+#include "flight/recorder.h"
+#include "perf/hot.h"
+#include "perf/probe.h"
+
+PERF_PROBE_DEFINE(re_task);
+
 // This driver encodes the states of the A and B pins of the rotary encoder
 // into a 2-bit word and checks the past 4 words of history and the current 1
 // word to determine if the rotation was successful and the direction of the
@@ -54,7 +60,8 @@ void rotary_encoder_init(rotary_encoder_t *re, uint a, uint b) {
     re->changedAt = 0;
 }
 
-int8_t rotary_encoder_task(rotary_encoder_t *re, uint64_t now) {
+int8_t PERF_HOT_FUNC(rotary_encoder_task)(rotary_encoder_t *re, uint64_t now) {
+    PERF_PROBE_SCOPE(re_task);
     // All GPIO bits are inverted beforehand, and then the desired A and B bits
     // are extracted and combined as a 2-bit word.
     uint32_t curr = ~gpio_get_all();
@@ -83,6 +90,7 @@ int8_t rotary_encoder_task(rotary_encoder_t *re, uint64_t now) {
                 break;
         }
     }
+    FLIGHT_RECORDER_PUT(ENCODER, re->pinA, word, delta);
     re->history = re->history << 2 | word;
     re->changedAt = now;
     if (delta != 0 && re->changed != NULL) {
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <pico/types.h>
+
+#include "hardware/i2c.h"
+#include "driver/i2c_dma.h"
+#include "gfx/bitmap.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Max width of panels. Asynchronous transfers are built in a DMA buffer per
+// I2C controller, which holds a page of this width.
+#ifndef SSD1306_MAX_WIDTH
+#define SSD1306_MAX_WIDTH           128
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Constants
+
+#define SSD1306_I2C_ADDR            _u(0x3C)
+
+// commands (see datasheet)
+#define SSD1306_SET_MEM_MODE        _u(0x20)
+#define SSD1306_SET_COL_ADDR        _u(0x21)
+#define SSD1306_SET_PAGE_ADDR       _u(0x22)
+#define SSD1306_SET_HORIZ_SCROLL    _u(0x26)    // | 0x01 to scroll left
+#define SSD1306_SET_SCROLL          _u(0x2E)
+
+#define SSD1306_SET_DISP_START_LINE _u(0x40)
+
+#define SSD1306_SET_CONTRAST        _u(0x81)
+#define SSD1306_SET_CHARGE_PUMP     _u(0x8D)
+
+#define SSD1306_SET_SEG_REMAP       _u(0xA0)
+#define SSD1306_SET_ENTIRE_ON       _u(0xA4)
+#define SSD1306_SET_ALL_ON          _u(0xA5)
+#define SSD1306_SET_NORM_DISP       _u(0xA6)
+#define SSD1306_SET_INV_DISP        _u(0xA7)
+#define SSD1306_SET_MUX_RATIO       _u(0xA8)
+#define SSD1306_SET_DISP            _u(0xAE)
+#define SSD1306_SET_COM_OUT_DIR     _u(0xC0)
+#define SSD1306_SET_COM_OUT_DIR_FLIP _u(0xC0)
+
+#define SSD1306_SET_DISP_OFFSET     _u(0xD3)
+#define SSD1306_SET_DISP_CLK_DIV    _u(0xD5)
+#define SSD1306_SET_PRECHARGE       _u(0xD9)
+#define SSD1306_SET_COM_PIN_CFG     _u(0xDA)
+#define SSD1306_SET_VCOM_DESEL      _u(0xDB)
+
+#define SSD1306_PAGE_HEIGHT         _u(8)
+
+// GDDRAM has 64 rows whatever the panel height is. The display start line
+// selects the RAM row shown at top of the panel, and rows wrap around.
+#define SSD1306_RAM_PAGES           _u(8)
+#define SSD1306_RAM_HEIGHT          (SSD1306_RAM_PAGES * SSD1306_PAGE_HEIGHT)
+
+// Frame buffers have a byte before them, which is reserved for the I2C
+// control byte to send a whole frame in a transaction.
+#define SSD1306_BUF_PREFIX_LEN      1
+
+// SSD1306_BUF_LEN returns bytes of a frame buffer of a panel.
+#define SSD1306_BUF_LEN(w, h)       ((w) * (((h) + SSD1306_PAGE_HEIGHT - 1) / SSD1306_PAGE_HEIGHT))
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+typedef struct ssd1306_s ssd1306_t;
+
+typedef void (*ssd1306_completed_cb)(ssd1306_t *d, bool ok);
+
+struct ssd1306_s {
+    // Set these before ssd1306_init(). Panels on a same I2C controller share
+    // it one transfer at a time, and panels on different controllers transfer
+    // concurrently.
+    i2c_inst_t *i2c;
+    uint8_t addr;
+    uint8_t width;
+    uint8_t height;
+
+    // fb must have SSD1306_BUF_PREFIX_LEN + SSD1306_BUF_LEN(width, height)
+    // bytes, and shadow SSD1306_BUF_LEN(width, height) bytes.
+    uint8_t *fb;
+    uint8_t *shadow;
+
+    void *user;
+    ssd1306_completed_cb completed;
+
+    // Below are set by ssd1306_init().
+
+    // Frame buffer to draw, after the prefix of fb. shadow holds what the
+    // panel shows.
+    uint8_t *buf;
+    uint8_t  pages;
+    uint     buf_len;
+
+    i2c_dma_t *dma;
+
+    // The shadow span being sent by ssd1306_render_diff_async().
+    uint8_t *diff_span;
+    int      diff_span_len;
+    // A page which ssd1306_render_diff_async() sends whole.
+    int      diff_force_page;
+
+    // The display start line, and where ssd1306_scroll_step_async() moves
+    // it to. The frame buffer is mapped to RAM from the target.
+    uint8_t  start_line;
+    uint8_t  start_line_target;
+
+    // Pages being scrolled horizontally, hscroll_end < 0 when stopped.
+    int      hscroll_start;
+    int      hscroll_end;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ssd1306_init initializes a panel, and clears the frame buffer and the
+// shadow. The I2C controller must be initialized by i2c_init() before. It
+// waits for completion, like other functions without "_async".
+void ssd1306_init(ssd1306_t *d);
+
+// ssd1306_init_async initializes a panel as ssd1306_init does, but sends the
+// commands in background, and leaves the frame buffer to
+// ssd1306_render_diff_async(). It returns false while the controller is
+// busy.
+bool ssd1306_init_async(ssd1306_t *d);
+
+// ssd1306_busy returns true while an asynchronous transfer is in progress on
+// the I2C controller of the panel, which may be for another panel.
+bool ssd1306_busy(ssd1306_t *d);
+
+void ssd1306_send_cmd(ssd1306_t *d, uint8_t cmd);
+void ssd1306_send_cmd_list(ssd1306_t *d, const uint8_t *buf, int num);
+
+// ssd1306_render sends the whole frame buffer, and updates the shadow.
+void ssd1306_render(ssd1306_t *d);
+
+// ssd1306_render_bitmap writes a bitmap generated by gfx_add_bitmap() to the
+// window at col and page of RAM, decompressing it into I2C TX FIFO on the
+// fly. The shadow is not updated.
+void ssd1306_render_bitmap(ssd1306_t *d, const gfx_bitmap_t *b, uint8_t col, uint8_t page);
+
+// ssd1306_scroll starts or stops horizontal scroll of the whole panel, to
+// right.
+void ssd1306_scroll(ssd1306_t *d, bool on);
+
+// Asynchronous transport. Commands and spans are copied to a DMA buffer and
+// written in background, so callers can modify their frame buffer right
+// after the call and never wait for I2C. These return false while the
+// controller is busy.
+bool ssd1306_send_cmd_async(ssd1306_t *d, uint8_t cmd);
+bool ssd1306_send_cmd_list_async(ssd1306_t *d, const uint8_t *buf, int num);
+
+// ssd1306_render_diff_async compares the frame buffer with the shadow, and
+// sends one span of changed columns in a page. It returns false when the
+// panel is up to date, otherwise call it again to send the rest. Pages of
+// the frame buffer are written to RAM pages translated by the display start
+// line.
+bool ssd1306_render_diff_async(ssd1306_t *d);
+
+// Animations by the controller. These cost a few command bytes per step
+// instead of re-rendering frames.
+//
+// ssd1306_hscroll_start_async makes the controller rotate pages start_page to
+// end_page of the panel horizontally, every interval (the raw value of the
+// command, 0x07 is 2 frames) until ssd1306_scroll_stop_async. RAM can't be
+// written while scrolling, so it fails while another scroll is in progress.
+bool ssd1306_hscroll_start_async(ssd1306_t *d, uint8_t start_page, uint8_t end_page, bool left, uint8_t interval);
+
+// ssd1306_scroll_stop_async stops horizontal scroll. Scrolled pages are
+// inverted in the shadow, because they must be written again.
+bool ssd1306_scroll_stop_async(ssd1306_t *d);
+
+// ssd1306_scroll_up starts to scroll the panel up by a page with the display
+// start line, like a terminal. It moves the frame buffer and the shadow up by
+// a page, and clears the bottom page of the frame buffer to draw a new line
+// in it. The next ssd1306_render_diff_async sends the bottom page to the RAM
+// page below the visible rows, then each ssd1306_scroll_step_async moves the
+// start line a row until the line is shown. So a new line costs a page of
+// data. It returns false while the previous scroll is in progress.
+//
+// On 64 rows panels there is no RAM below the visible rows, so the new line
+// replaces the top line before scrolling in.
+bool ssd1306_scroll_up(ssd1306_t *d);
+
+// ssd1306_scroll_step_async moves the display start line a row, and returns
+// true until the line written by ssd1306_scroll_up is fully shown.
+bool ssd1306_scroll_step_async(ssd1306_t *d);
+
+#ifdef __cplusplus
+}
+#endif
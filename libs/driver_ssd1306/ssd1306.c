@@ -0,0 +1,444 @@
+/**
+ * Copyright (c) 2021 Raspberry Pi (Trading) Ltd.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "driver/ssd1306.h"
+
+// This driver is derived from the ssd1306_i2c example of pico-examples, and
+// drives any number of panels by instances.
+//
+// Each I2C controller has an i2c_dma_t and a DMA buffer, shared by the panels
+// on it. Asynchronous transfers of a panel fail while another panel on the
+// same controller is being written, and the panels on another controller
+// are written concurrently. Blocking functions wait for the asynchronous
+// transfer on the controller before writing.
+
+// Room for the control bytes and the commands to set a render area, ahead of
+// a page.
+#define SSD1306_ASYNC_BUF_LEN       (SSD1306_MAX_WIDTH + 16)
+
+// Changed columns closer than this are sent as one span, because starting
+// another span costs the same bytes for the window commands.
+#define SSD1306_SPAN_MERGE_GAP      13
+
+// Room for the commands of ssd1306_init_cmds().
+#define SSD1306_INIT_CMDS_MAX       32
+
+typedef struct {
+    bool initialized;
+    i2c_dma_t dma;
+    uint16_t buf[SSD1306_ASYNC_BUF_LEN];
+} ssd1306_bus_t;
+
+static ssd1306_bus_t buses[NUM_I2CS];
+
+static void ssd1306_on_completed(i2c_dma_t *dma, bool ok) {
+    ssd1306_t *d = dma->user;
+    if (d == NULL) {
+        return;
+    }
+    if (!ok && d->diff_span != NULL) {
+        // The panel may not show the span. Invert the shadow to send it
+        // again.
+        for (int i = 0; i < d->diff_span_len; i++) {
+            d->diff_span[i] = ~d->diff_span[i];
+        }
+    }
+    d->diff_span = NULL;
+    if (d->completed != NULL) {
+        d->completed(d, ok);
+    }
+}
+
+static i2c_dma_t *ssd1306_bus_dma(i2c_inst_t *i2c) {
+    ssd1306_bus_t *bus = &buses[i2c_get_index(i2c)];
+    if (!bus->initialized) {
+        bus->dma.user = NULL;
+        bus->dma.completed = ssd1306_on_completed;
+        i2c_dma_init(&bus->dma, i2c, bus->buf, count_of(bus->buf));
+        bus->initialized = true;
+    }
+    return &bus->dma;
+}
+
+static inline uint8_t ssd1306_ram_page(ssd1306_t *d, int page) {
+    return (page + d->start_line_target / SSD1306_PAGE_HEIGHT) % SSD1306_RAM_PAGES;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Blocking transport
+
+// Bytes of a transaction are written to TX FIFO directly, so the control byte
+// and following bytes need no buffer to join them, and data can be produced
+// on the fly.
+
+static void ssd1306_stream_begin(ssd1306_t *d, uint8_t control) {
+    while (i2c_dma_busy(d->dma)) {
+        tight_loop_contents();
+    }
+    i2c_hw_t *hw = i2c_get_hw(d->i2c);
+    hw->enable = 0;
+    hw->tar = d->addr;
+    hw->enable = 1;
+    (void)hw->clr_stop_det;
+    hw->data_cmd = control;
+}
+
+static inline void ssd1306_stream_put(ssd1306_t *d, uint8_t data, bool last) {
+    uint32_t data_cmd = data;
+    if (last) {
+        data_cmd |= I2C_IC_DATA_CMD_STOP_BITS;
+    }
+    while (i2c_get_write_available(d->i2c) == 0) {
+        tight_loop_contents();
+    }
+    i2c_get_hw(d->i2c)->data_cmd = data_cmd;
+}
+
+static void ssd1306_stream_end(ssd1306_t *d) {
+    // STOP condition is generated on both completion and abort (NACK).
+    i2c_hw_t *hw = i2c_get_hw(d->i2c);
+    while ((hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS) == 0) {
+        tight_loop_contents();
+    }
+    (void)hw->clr_stop_det;
+    (void)hw->clr_tx_abrt;
+}
+
+static void ssd1306_write_stream(ssd1306_t *d, uint8_t control, const uint8_t *buf, int len) {
+    ssd1306_stream_begin(d, control);
+    for (int i = 0; i < len; i++) {
+        ssd1306_stream_put(d, buf[i], i == len - 1);
+    }
+    ssd1306_stream_end(d);
+}
+
+void ssd1306_send_cmd(ssd1306_t *d, uint8_t cmd) {
+    ssd1306_send_cmd_list(d, &cmd, 1);
+}
+
+void ssd1306_send_cmd_list(ssd1306_t *d, const uint8_t *buf, int num) {
+    // Co = 0, D/C = 0 => all following bytes are commands
+    ssd1306_write_stream(d, 0x00, buf, num);
+}
+
+static void ssd1306_set_window(ssd1306_t *d, uint8_t col0, uint8_t col1, uint8_t page0, uint8_t page1) {
+    uint8_t cmds[] = {
+        SSD1306_SET_COL_ADDR,
+        col0,
+        col1,
+        SSD1306_SET_PAGE_ADDR,
+        page0,
+        page1
+    };
+    ssd1306_send_cmd_list(d, cmds, count_of(cmds));
+}
+
+void ssd1306_render(ssd1306_t *d) {
+    // in horizontal addressing mode, the column address pointer auto-increments
+    // and then wraps around to the next page, so we can send the entire frame
+    // buffer in one gooooooo!
+    ssd1306_set_window(d, 0, d->width - 1, 0, d->pages - 1);
+    while (i2c_dma_busy(d->dma)) {
+        tight_loop_contents();
+    }
+    // put the control byte into the prefix of the frame buffer.
+    // Co = 0, D/C = 1 => all following bytes are data
+    d->fb[0] = 0x40;
+    i2c_write_blocking(d->i2c, d->addr, d->fb, d->buf_len + 1, false);
+    memcpy(d->shadow, d->buf, d->buf_len);
+    d->start_line = d->start_line_target = 0;
+    ssd1306_send_cmd(d, SSD1306_SET_DISP_START_LINE);
+}
+
+void ssd1306_render_bitmap(ssd1306_t *d, const gfx_bitmap_t *b, uint8_t col, uint8_t page) {
+    if (b->width == 0 || b->height == 0) {
+        return;
+    }
+    ssd1306_set_window(d, col, col + b->width - 1, page, page + ((b->height + 7) >> 3) - 1);
+
+    // decompress bytes straight into TX FIFO, without copying to RAM.
+    gfx_bitmap_reader_t r;
+    gfx_bitmap_reader_init(&r, b);
+    uint32_t len = gfx_bitmap_len(b);
+    ssd1306_stream_begin(d, 0x40);
+    for (uint32_t i = 0; i < len; i++) {
+        ssd1306_stream_put(d, gfx_bitmap_reader_next(&r), i == len - 1);
+    }
+    ssd1306_stream_end(d);
+}
+
+// ssd1306_setup initializes fields of a panel, and clears the frame buffer.
+static void ssd1306_setup(ssd1306_t *d) {
+    d->buf = d->fb + SSD1306_BUF_PREFIX_LEN;
+    d->pages = (d->height + SSD1306_PAGE_HEIGHT - 1) / SSD1306_PAGE_HEIGHT;
+    d->buf_len = SSD1306_BUF_LEN(d->width, d->height);
+    d->dma = ssd1306_bus_dma(d->i2c);
+    d->diff_span = NULL;
+    d->diff_span_len = 0;
+    d->diff_force_page = -1;
+    d->start_line = 0;
+    d->start_line_target = 0;
+    d->hscroll_start = 0;
+    d->hscroll_end = -1;
+    memset(d->buf, 0, d->buf_len);
+}
+
+// ssd1306_init_cmds copies the commands to initialize a panel to cmds of
+// SSD1306_INIT_CMDS_MAX, and returns the number of them.
+static int ssd1306_init_cmds(ssd1306_t *d, uint8_t *cmds) {
+    // Some of these commands are not strictly necessary as the reset
+    // process defaults to some of these but they are shown here
+    // to demonstrate what the initialization sequence looks like
+    // Some configuration values are recommended by the board manufacturer
+
+    const uint8_t init[] = {
+        SSD1306_SET_DISP,               // set display off
+        /* memory mapping */
+        SSD1306_SET_MEM_MODE,           // set memory address mode 0 = horizontal, 1 = vertical, 2 = page
+        0x00,                           // horizontal addressing mode
+        /* resolution and layout */
+        SSD1306_SET_DISP_START_LINE,    // set display start line to 0
+        SSD1306_SET_SEG_REMAP | 0x01,   // set segment re-map, column address 127 is mapped to SEG0
+        SSD1306_SET_MUX_RATIO,          // set multiplex ratio
+        d->height - 1,                  // Display height - 1
+        SSD1306_SET_COM_OUT_DIR | 0x08, // set COM (common) output scan direction. Scan from bottom up, COM[N-1] to COM0
+        SSD1306_SET_DISP_OFFSET,        // set display offset
+        0x00,                           // no offset
+        SSD1306_SET_COM_PIN_CFG,        // set COM (common) pins hardware configuration. Board specific magic number.
+                                        // 0x02 Works for 128x32, 0x12 Possibly works for 128x64. Other options 0x22, 0x32
+        d->height > 32 ? 0x12 : 0x02,
+        /* timing and driving scheme */
+        SSD1306_SET_DISP_CLK_DIV,       // set display clock divide ratio
+        0x80,                           // div ratio of 1, standard freq
+        SSD1306_SET_PRECHARGE,          // set pre-charge period
+        0xF1,                           // Vcc internally generated on our board
+        SSD1306_SET_VCOM_DESEL,         // set VCOMH deselect level
+        0x30,                           // 0.83xVcc
+        /* display */
+        SSD1306_SET_CONTRAST,           // set contrast control
+        0xFF,
+        SSD1306_SET_ENTIRE_ON,          // set entire display on to follow RAM content
+        SSD1306_SET_NORM_DISP,           // set normal (not inverted) display
+        SSD1306_SET_CHARGE_PUMP,        // set charge pump
+        0x14,                           // Vcc internally generated on our board
+        SSD1306_SET_SCROLL | 0x00,      // deactivate horizontal scrolling if set. This is necessary as memory writes will corrupt if scrolling was enabled
+        SSD1306_SET_DISP | 0x01, // turn display on
+    };
+    static_assert(sizeof(init) <= SSD1306_INIT_CMDS_MAX, "SSD1306_INIT_CMDS_MAX is too small");
+    memcpy(cmds, init, sizeof(init));
+    return sizeof(init);
+}
+
+void ssd1306_init(ssd1306_t *d) {
+    ssd1306_setup(d);
+    uint8_t cmds[SSD1306_INIT_CMDS_MAX];
+    ssd1306_send_cmd_list(d, cmds, ssd1306_init_cmds(d, cmds));
+    ssd1306_render(d);
+}
+
+bool ssd1306_init_async(ssd1306_t *d) {
+    d->dma = ssd1306_bus_dma(d->i2c);
+    if (ssd1306_busy(d)) {
+        return false;
+    }
+    ssd1306_setup(d);
+    // RAM of the panel is unknown, so the shadow differs from the frame
+    // buffer everywhere, and ssd1306_render_diff_async() sends all of it.
+    memset(d->shadow, 0xff, d->buf_len);
+    uint8_t cmds[SSD1306_INIT_CMDS_MAX];
+    return ssd1306_send_cmd_list_async(d, cmds, ssd1306_init_cmds(d, cmds));
+}
+
+void ssd1306_scroll(ssd1306_t *d, bool on) {
+    // configure horizontal scrolling
+    uint8_t cmds[] = {
+        SSD1306_SET_HORIZ_SCROLL | 0x00,
+        0x00, // dummy byte
+        0x00, // start page 0
+        0x00, // time interval
+        d->pages - 1, // end page
+        0x00, // dummy byte
+        0xFF, // dummy byte
+        SSD1306_SET_SCROLL | (on ? 0x01 : 0) // Start/stop scrolling
+    };
+
+    ssd1306_send_cmd_list(d, cmds, count_of(cmds));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Asynchronous transport
+
+bool ssd1306_busy(ssd1306_t *d) {
+    return i2c_dma_busy(d->dma);
+}
+
+static bool ssd1306_begin_async(ssd1306_t *d) {
+    if (!i2c_dma_begin(d->dma)) {
+        return false;
+    }
+    d->dma->user = d;
+    return true;
+}
+
+static void ssd1306_put_cmd_async(ssd1306_t *d, uint8_t cmd) {
+    // Co = 1, D/C = 0 => a command follows, and then another control byte.
+    // This allows commands and data in one transaction.
+    i2c_dma_put(d->dma, 0x80);
+    i2c_dma_put(d->dma, cmd);
+}
+
+bool ssd1306_send_cmd_async(ssd1306_t *d, uint8_t cmd) {
+    if (!ssd1306_begin_async(d)) {
+        return false;
+    }
+    ssd1306_put_cmd_async(d, cmd);
+    return i2c_dma_start(d->dma, d->addr);
+}
+
+bool ssd1306_send_cmd_list_async(ssd1306_t *d, const uint8_t *buf, int num) {
+    if (!ssd1306_begin_async(d)) {
+        return false;
+    }
+    // Co = 0, D/C = 0 => all following bytes are commands
+    i2c_dma_put(d->dma, 0x00);
+    i2c_dma_put_buf(d->dma, buf, num);
+    return i2c_dma_start(d->dma, d->addr);
+}
+
+bool ssd1306_render_diff_async(ssd1306_t *d) {
+    if (ssd1306_busy(d)) {
+        return true;
+    }
+    for (int page = 0; page < d->pages; page++) {
+        uint8_t *b = d->buf + page * d->width;
+        uint8_t *s = d->shadow + page * d->width;
+        int start = 0;
+        int end = d->width - 1;
+        if (page != d->diff_force_page) {
+            while (start < d->width && b[start] == s[start]) {
+                start++;
+            }
+            if (start >= d->width) {
+                continue;
+            }
+            end = start;
+            for (int i = start + 1; i < d->width && i - end <= SSD1306_SPAN_MERGE_GAP; i++) {
+                if (b[i] != s[i]) {
+                    end = i;
+                }
+            }
+        }
+        int len = end - start + 1;
+        uint8_t ram_page = ssd1306_ram_page(d, page);
+        if (!ssd1306_begin_async(d)) {
+            return true;
+        }
+        ssd1306_put_cmd_async(d, SSD1306_SET_COL_ADDR);
+        ssd1306_put_cmd_async(d, start);
+        ssd1306_put_cmd_async(d, end);
+        ssd1306_put_cmd_async(d, SSD1306_SET_PAGE_ADDR);
+        ssd1306_put_cmd_async(d, ram_page);
+        ssd1306_put_cmd_async(d, ram_page);
+        // Co = 0, D/C = 1 => rest of the transaction is data.
+        i2c_dma_put(d->dma, 0x40);
+        i2c_dma_put_buf(d->dma, b + start, len);
+        // The completion IRQ may come before i2c_dma_start() returns, on a
+        // NACK of the address, so the span is set up before.
+        memcpy(s + start, b + start, len);
+        d->diff_span = s + start;
+        d->diff_span_len = len;
+        if (!i2c_dma_start(d->dma, d->addr)) {
+            // Nothing was sent. Invert the shadow to send it again.
+            for (int i = 0; i < len; i++) {
+                s[start + i] = ~b[start + i];
+            }
+            d->diff_span = NULL;
+            d->diff_span_len = 0;
+            return true;
+        }
+        if (page == d->diff_force_page) {
+            d->diff_force_page = -1;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool ssd1306_hscroll_start_async(ssd1306_t *d, uint8_t start_page, uint8_t end_page, bool left, uint8_t interval) {
+    if (d->hscroll_end >= 0 || start_page > end_page || end_page >= d->pages) {
+        return false;
+    }
+    // The range is in RAM pages, so it must not wrap around.
+    uint8_t ram_start = ssd1306_ram_page(d, start_page);
+    uint8_t ram_end = ssd1306_ram_page(d, end_page);
+    if (ram_start > ram_end) {
+        return false;
+    }
+    uint8_t cmds[] = {
+        SSD1306_SET_HORIZ_SCROLL | (left ? 0x01 : 0x00),
+        0x00, // dummy byte
+        ram_start,
+        interval & 0x07,
+        ram_end,
+        0x00, // dummy byte
+        0xFF, // dummy byte
+        SSD1306_SET_SCROLL | 0x01,
+    };
+    if (!ssd1306_send_cmd_list_async(d, cmds, count_of(cmds))) {
+        return false;
+    }
+    d->hscroll_start = start_page;
+    d->hscroll_end = end_page;
+    return true;
+}
+
+bool ssd1306_scroll_stop_async(ssd1306_t *d) {
+    if (!ssd1306_send_cmd_async(d, SSD1306_SET_SCROLL | 0x00)) {
+        return false;
+    }
+    for (int page = d->hscroll_start; page <= d->hscroll_end; page++) {
+        uint8_t *s = d->shadow + page * d->width;
+        for (int i = 0; i < d->width; i++) {
+            s[i] = ~s[i];
+        }
+    }
+    d->hscroll_end = -1;
+    return true;
+}
+
+bool ssd1306_scroll_up(ssd1306_t *d) {
+    if (d->start_line != d->start_line_target || d->hscroll_end >= 0 || ssd1306_busy(d)) {
+        return false;
+    }
+    const int last = d->buf_len - d->width;
+    memmove(d->buf, d->buf + d->width, last);
+    memset(d->buf + last, 0, d->width);
+    // The panel will show the same after scrolling, except the bottom page.
+    memmove(d->shadow, d->shadow + d->width, last);
+    d->diff_force_page = d->pages - 1;
+    d->start_line_target = (d->start_line_target + SSD1306_PAGE_HEIGHT) % SSD1306_RAM_HEIGHT;
+    return true;
+}
+
+bool ssd1306_scroll_step_async(ssd1306_t *d) {
+    if (d->start_line == d->start_line_target) {
+        return false;
+    }
+    // wait for the new line to be written.
+    if (d->diff_force_page >= 0) {
+        return true;
+    }
+    uint8_t next = (d->start_line + 1) % SSD1306_RAM_HEIGHT;
+    if (ssd1306_send_cmd_async(d, SSD1306_SET_DISP_START_LINE | next)) {
+        d->start_line = next;
+    }
+    return d->start_line != d->start_line_target;
+}
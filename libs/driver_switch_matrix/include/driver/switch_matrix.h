@@ -2,10 +2,17 @@
 
 #include <pico/types.h>
 
+// Number of histogram buckets of bounce intervals. Bucket 0 counts bounces
+// shorter than 128us, bucket i counts bounces in [2^(i+6), 2^(i+7)) us, and
+// the last bucket also collects everything longer.
+#ifndef SWITCH_MATRIX_BOUNCE_HIST_NUM
+    #define SWITCH_MATRIX_BOUNCE_HIST_NUM 8
+#endif
+
 typedef struct switch_matrix_s switch_matrix_t;
 
 typedef void (*switch_matrix_changed_cb)(switch_matrix_t *sm, uint64_t when, uint state_index, bool on);
-typedef void (*switch_matrix_suppressed_cb)(switch_matrix_t *sm, uint8_t when, uint state_index, bool on, uint64_t last_changed);
+typedef void (*switch_matrix_suppressed_cb)(switch_matrix_t *sm, uint64_t when, uint state_index, bool on, uint64_t last_changed);
 
 typedef struct {
     uint8_t  p0;
@@ -14,9 +21,31 @@ typedef struct {
     uint64_t last:63;
 } switch_matrix_state_t;
 
+// Pins of a switch, for the compile-time pin table of switch_matrix_fixed
+// (driver/switch_matrix.hpp).
+typedef struct {
+    uint8_t p0;
+    uint8_t p1;
+} switch_matrix_pin_t;
+
+// Statistics of a switch. A bounce is a change suppressed by debouncing, and
+// its interval is the time from the last accepted change.
+typedef struct {
+    uint32_t presses;
+    uint32_t bounces;
+    uint32_t min_bounce;
+    uint16_t bounce_hist[SWITCH_MATRIX_BOUNCE_HIST_NUM];
+    // Sum of hold times of released presses in microseconds.
+    uint32_t releases;
+    uint64_t hold_sum;
+} switch_matrix_stats_t;
+
 struct switch_matrix_s {
     int num;
+    // NULL when switches are scanned by switch_matrix_fixed.
     switch_matrix_state_t *states;
+    // Optional, an entry per state to collect statistics.
+    switch_matrix_stats_t *stats;
 
     void *user;
     switch_matrix_changed_cb changed;
@@ -30,10 +59,87 @@ struct switch_matrix_s {
     uint64_t last;
 };
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 void switch_matrix_init(switch_matrix_t *sm);
 
 void switch_matrix_task(switch_matrix_t *sm, uint64_t now);
 
+// switch_matrix_scan scans now, regardless of scan_interval, for a scheduler
+// which runs it periodically.
+void switch_matrix_scan(switch_matrix_t *sm, uint64_t now);
+
+// switch_matrix_reset_stats clears stats of all states.
+void switch_matrix_reset_stats(switch_matrix_t *sm);
+
+// switch_matrix_mean_hold returns the mean hold time of a switch in
+// microseconds.
+static inline uint32_t switch_matrix_mean_hold(const switch_matrix_stats_t *st) {
+    return st->releases > 0 ? (uint32_t)(st->hold_sum / st->releases) : 0;
+}
+
+// switch_matrix_idle_enter drives all p0 pins low, so pressing any switch
+// pulls its p1 pin low without scanning. It returns the mask of p1 pins to
+// watch for wake up.
+uint32_t switch_matrix_idle_enter(switch_matrix_t *sm);
+
+// switch_matrix_idle_exit releases p0 pins, and makes next
+// switch_matrix_task scan immediately to catch the switch which woke up.
+void switch_matrix_idle_exit(switch_matrix_t *sm);
+
 void switch_matrix_changed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on);
 
 void switch_matrix_suppressed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on, uint64_t last_changed);
+
+// switch_matrix_stats_changed counts a change accepted after elapsed us.
+static inline void switch_matrix_stats_changed(switch_matrix_stats_t *st, bool on, uint64_t elapsed) {
+    if (on) {
+        st->presses++;
+    } else {
+        // elapsed is the hold time, since the press.
+        st->releases++;
+        st->hold_sum += elapsed;
+    }
+}
+
+// switch_matrix_stats_bounced counts a change suppressed after elapsed us.
+static inline void switch_matrix_stats_bounced(switch_matrix_stats_t *st, uint64_t elapsed) {
+    // elapsed is shorter than debounce_interval, which fits in 32 bits.
+    uint32_t us = (uint32_t)elapsed;
+    st->bounces++;
+    if (us < st->min_bounce) {
+        st->min_bounce = us;
+    }
+    uint b = us < 128 ? 0 : 32 - __builtin_clz(us >> 7);
+    if (b >= SWITCH_MATRIX_BOUNCE_HIST_NUM) {
+        b = SWITCH_MATRIX_BOUNCE_HIST_NUM - 1;
+    }
+    if (st->bounce_hist[b] < UINT16_MAX) {
+        st->bounce_hist[b]++;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+// SWITCH_MATRIX_FIXED_DECLARE declares functions of a switch_matrix_fixed
+// defined by SWITCH_MATRIX_FIXED_DEFINE in a C++ file. They take the place of
+// switch_matrix_init, switch_matrix_task, switch_matrix_scan,
+// switch_matrix_idle_enter and switch_matrix_idle_exit.
+#ifdef __cplusplus
+#define SWITCH_MATRIX_FIXED_DECLARE(name) \
+    extern "C" { SWITCH_MATRIX_FIXED_DECLARE_(name) }
+#else
+#define SWITCH_MATRIX_FIXED_DECLARE(name) \
+    SWITCH_MATRIX_FIXED_DECLARE_(name)
+#endif
+
+#define SWITCH_MATRIX_FIXED_DECLARE_(name) \
+    void name##_init(switch_matrix_t *sm); \
+    void name##_task(switch_matrix_t *sm, uint64_t now); \
+    void name##_scan(switch_matrix_t *sm, uint64_t now); \
+    uint32_t name##_idle_enter(switch_matrix_t *sm); \
+    void name##_idle_exit(switch_matrix_t *sm);
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include "driver/switch_matrix.h"
+#include "hardware/gpio.h"
+
+#include "pico/stdlib.h"
+
+#include "flight/recorder.h"
+#include "perf/hot.h"
+#include "perf/probe.h"
+
+// switch_matrix_fixed scans a switch matrix whose pins are known at compile
+// time. The pin table is a constexpr array of switch_matrix_pin_t, which
+// keymapc.py generates as KEYMAP_<NAME>_PINS:
+//
+//     static constexpr switch_matrix_pin_t pins[] = KEYMAP_YUIOP29RE_PINS;
+//     SWITCH_MATRIX_FIXED_DEFINE(sm1_fixed, pins)
+//
+// Rows, masks and the bit of each switch are resolved by the compiler, so a
+// scan is an unrolled sequence of selecting a row, reading the pins and
+// shifting bits of its switches into a bitmap. Debounced states are a bitmap
+// too, and only switches which differ from it are debounced, which is none on
+// most scans.
+//
+// switch_matrix_t still holds the configuration, callbacks and stats, and
+// switch_matrix_changed and switch_matrix_suppressed are called as
+// switch_matrix_task does, in the order of state index. states of it is not
+// used, and may be NULL.
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+#if PERF_PROBE_ENABLED
+inline perf_probe_t perf_probe_sm_scan_fixed = { "sm_scan_fixed" };
+#endif
+
+template <std::size_t N>
+constexpr uint32_t switch_matrix_fixed_mask(const switch_matrix_pin_t (&pins)[N], bool p1) {
+    uint32_t mask = 0;
+    for (const switch_matrix_pin_t &pin : pins) {
+        mask |= 1u << (p1 ? pin.p1 : pin.p0);
+    }
+    return mask;
+}
+
+// switch_matrix_fixed_rows returns p0 pins in the order of first appearance.
+template <const auto &Pins, std::size_t NumRows>
+constexpr std::array<uint8_t, NumRows> switch_matrix_fixed_rows() {
+    std::array<uint8_t, NumRows> rows{};
+    uint32_t seen = 0;
+    std::size_t n = 0;
+    for (const switch_matrix_pin_t &pin : Pins) {
+        if ((seen & (1u << pin.p0)) == 0) {
+            seen |= 1u << pin.p0;
+            rows[n++] = pin.p0;
+        }
+    }
+    return rows;
+}
+
+template <std::size_t NumRows>
+constexpr uint switch_matrix_fixed_row_of(const std::array<uint8_t, NumRows> &rows, uint8_t p0) {
+    uint r = 0;
+    while (rows[r] != p0) {
+        r++;
+    }
+    return r;
+}
+
+template <const auto &Pins>
+class switch_matrix_fixed {
+public:
+    static constexpr uint num = std::size(Pins);
+    static_assert(num > 0 && num <= 64, "switch_matrix_fixed takes 1 to 64 switches");
+
+    // init initializes the pins, and the configuration of sm to defaults as
+    // switch_matrix_init does.
+    void init(switch_matrix_t *sm) {
+        for (uint32_t m = p0_mask | p1_mask; m != 0; m &= m - 1) {
+            uint gpio = __builtin_ctz(m);
+            gpio_init(gpio);
+            gpio_set_dir(gpio, GPIO_IN);
+            gpio_pull_up(gpio);
+            gpio_put(gpio, false);
+        }
+        sm->num = num;
+        switch_matrix_init(sm);
+        on_ = 0;
+        for (uint i = 0; i < num; i++) {
+            last_[i] = 0;
+        }
+    }
+
+    __attribute__((always_inline)) void task(switch_matrix_t *sm, uint64_t now) {
+        if (now - sm->last < sm->scan_interval) {
+            return;
+        }
+        scan(sm, now);
+    }
+
+    // scan scans now, as switch_matrix_scan does.
+    __attribute__((always_inline)) void scan(switch_matrix_t *sm, uint64_t now) {
+        sm->last = now;
+        PERF_PROBE_BEGIN(sm_scan_fixed);
+        uint64_t raw = scan_rows(sm, std::make_index_sequence<num_rows>());
+        for (uint64_t changed = raw ^ on_; changed != 0; changed &= changed - 1) {
+            uint i = __builtin_ctzll(changed);
+            set_state(sm, now, i, (raw >> i) & 1);
+        }
+        PERF_PROBE_END(sm_scan_fixed);
+    }
+
+    // idle_enter and idle_exit work as switch_matrix_idle_enter and
+    // switch_matrix_idle_exit.
+    uint32_t idle_enter(switch_matrix_t *sm) {
+        // p0 pins were initialized to output low when selected.
+        gpio_set_dir_out_masked(p0_mask);
+        return p1_mask & ~p0_mask;
+    }
+
+    void idle_exit(switch_matrix_t *sm) {
+        gpio_set_dir_in_masked(p0_mask);
+        busy_wait_us_32(sm->unselect_delay);
+        sm->last = 0;
+    }
+
+    bool on(uint state_index) const {
+        return (on_ >> state_index) & 1;
+    }
+
+    // set_on sets a debounced state without reporting it, as writing on of
+    // states does for switch_matrix_task.
+    void set_on(uint state_index, bool on) {
+        on_ = (on_ & ~((uint64_t)1 << state_index)) | ((uint64_t)on << state_index);
+    }
+
+private:
+    static constexpr uint32_t p0_mask = switch_matrix_fixed_mask(Pins, false);
+    static constexpr uint32_t p1_mask = switch_matrix_fixed_mask(Pins, true);
+    // rows are p0 pins in the order switch_matrix_task selects them.
+    static constexpr auto rows = switch_matrix_fixed_rows<Pins, __builtin_popcount(p0_mask)>();
+    static constexpr uint num_rows = rows.size();
+
+    static constexpr uint row_of(uint state_index) {
+        return switch_matrix_fixed_row_of(rows, Pins[state_index].p0);
+    }
+
+    // row_states returns the bitmap of states in row r.
+    static constexpr uint64_t row_states(uint r) {
+        uint64_t states = 0;
+        for (uint i = 0; i < num; i++) {
+            if (row_of(i) == r) {
+                states |= (uint64_t)1 << i;
+            }
+        }
+        return states;
+    }
+
+    // scan_rows selects rows one by one, as the comma operator sequences.
+    template <std::size_t... R>
+    __attribute__((always_inline)) uint64_t scan_rows(switch_matrix_t *sm, std::index_sequence<R...>) {
+        uint64_t raw = 0;
+        ((raw |= scan_row<R>(sm)), ...);
+        return raw;
+    }
+
+    template <uint R>
+    __attribute__((always_inline)) uint64_t scan_row(switch_matrix_t *sm) {
+        constexpr uint32_t mask = 1u << rows[R];
+        constexpr uint64_t states = row_states(R);
+        gpio_set_dir_out_masked(mask);
+        busy_wait_us_32(sm->select_delay);
+        uint32_t scanned = gpio_get_all();
+        if (scanned == 0) {
+            scanned = ~0;
+        }
+        gpio_set_dir_in_masked(mask);
+        busy_wait_us_32(sm->unselect_delay);
+        uint64_t raw = row_bits<R>(~scanned, std::make_index_sequence<num>());
+        if (((raw ^ on_) & states) != 0) {
+            FLIGHT_RECORDER_PUT(SCAN, rows[R], 0, scanned);
+        }
+        return raw;
+    }
+
+    // row_bits moves the bits of switches in row R from pressed (low pins)
+    // to their state indexes. Others are 0 and folded away.
+    template <uint R, std::size_t... I>
+    static __attribute__((always_inline)) uint64_t row_bits(uint32_t pressed, std::index_sequence<I...>) {
+        return (row_bit<R, I>(pressed) | ...);
+    }
+
+    template <uint R, uint I>
+    static __attribute__((always_inline)) uint64_t row_bit(uint32_t pressed) {
+        if constexpr (row_of(I) == R) {
+            return (uint64_t)((pressed >> Pins[I].p1) & 1) << I;
+        } else {
+            return 0;
+        }
+    }
+
+    void set_state(switch_matrix_t *sm, uint64_t now, uint state_index, bool on) {
+        uint64_t last = last_[state_index];
+        uint64_t elapsed = now - last;
+        if (elapsed >= sm->debounce_interval) {
+            on_ ^= (uint64_t)1 << state_index;
+            last_[state_index] = now;
+            FLIGHT_RECORDER_PUT(CHANGED, state_index, 0, on);
+            if (sm->stats != NULL) {
+                switch_matrix_stats_changed(&sm->stats[state_index], on, elapsed);
+            }
+            switch_matrix_changed(sm, now, state_index, on);
+        } else {
+            FLIGHT_RECORDER_PUT(SUPPRESSED, state_index, elapsed > UINT16_MAX ? UINT16_MAX : elapsed, on);
+            if (sm->stats != NULL) {
+                switch_matrix_stats_bounced(&sm->stats[state_index], elapsed);
+            }
+            switch_matrix_suppressed(sm, now, state_index, on, last);
+        }
+    }
+
+    uint64_t on_ = 0;
+    uint64_t last_[num] = {};
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Macros
+
+// SWITCH_MATRIX_FIXED_DEFINE instantiates switch_matrix_fixed for pins, and
+// defines C functions of it declared by SWITCH_MATRIX_FIXED_DECLARE. The
+// functions are placed as PERF_HOT_FUNC, and the scan is inlined into
+// name_task and name_scan.
+#define SWITCH_MATRIX_FIXED_DEFINE(name, pins) \
+    static switch_matrix_fixed<pins> name##_matrix; \
+    extern "C" void name##_init(switch_matrix_t *sm) { \
+        name##_matrix.init(sm); \
+    } \
+    extern "C" void PERF_HOT_FUNC(name##_task)(switch_matrix_t *sm, uint64_t now) { \
+        name##_matrix.task(sm, now); \
+    } \
+    extern "C" void PERF_HOT_FUNC(name##_scan)(switch_matrix_t *sm, uint64_t now) { \
+        name##_matrix.scan(sm, now); \
+    } \
+    extern "C" uint32_t name##_idle_enter(switch_matrix_t *sm) { \
+        return name##_matrix.idle_enter(sm); \
+    } \
+    extern "C" void name##_idle_exit(switch_matrix_t *sm) { \
+        name##_matrix.idle_exit(sm); \
+    }
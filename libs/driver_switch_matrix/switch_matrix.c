@@ -1,16 +1,22 @@
-#include <stdio.h>
+#include <string.h>
 
 #include "driver/switch_matrix.h"
 #include "hardware/gpio.h"
 
 #include "pico/stdlib.h"
 
+#include "flight/recorder.h"
+#include "log/ring.h"
+#include "perf/hot.h"
+#include "perf/probe.h"
+
+PERF_PROBE_DEFINE(sm_scan);
+
 //////////////////////////////////////////////////////////////////////////////
 // Pre-declarations
 
 static void sm_gpio_init(uint gpio);
 static void sm_scan_switches(switch_matrix_t *sm, uint64_t now);
-static void sm_performance_count(switch_matrix_t *sm, uint64_t now);
 static void sm_set_switch_state(switch_matrix_t *sm, uint64_t now, uint knum, bool on);
 
 //////////////////////////////////////////////////////////////////////////////
@@ -18,7 +24,7 @@ static void sm_set_switch_state(switch_matrix_t *sm, uint64_t now, uint knum, bo
 
 void switch_matrix_init(switch_matrix_t *sm) {
     uint32_t inited_pins = 0;
-    for (uint i = 0; i < sm->num; i++) {
+    for (uint i = 0; sm->states != NULL && i < sm->num; i++) {
         uint8_t p0 = sm->states[i].p0, p1 = sm->states[i].p1;
         if ((inited_pins & (1 << p0)) == 0) {
             sm_gpio_init(p0);
@@ -41,15 +47,52 @@ void switch_matrix_init(switch_matrix_t *sm) {
     if (sm->debounce_interval == 0) {
         sm->debounce_interval = 10 * 1000;
     }
+    switch_matrix_reset_stats(sm);
+}
+
+void switch_matrix_reset_stats(switch_matrix_t *sm) {
+    if (sm->stats == NULL) {
+        return;
+    }
+    memset(sm->stats, 0, sm->num * sizeof(sm->stats[0]));
+    for (uint i = 0; i < sm->num; i++) {
+        sm->stats[i].min_bounce = UINT32_MAX;
+    }
 }
 
-void switch_matrix_task(switch_matrix_t *sm, uint64_t now) {
+void PERF_HOT_FUNC(switch_matrix_task)(switch_matrix_t *sm, uint64_t now) {
     if (now - sm->last < sm->scan_interval) {
         return;
     }
+    switch_matrix_scan(sm, now);
+}
+
+void PERF_HOT_FUNC(switch_matrix_scan)(switch_matrix_t *sm, uint64_t now) {
     sm->last = now;
+    PERF_PROBE_BEGIN(sm_scan);
     sm_scan_switches(sm, now);
-    sm_performance_count(sm, now);
+    PERF_PROBE_END(sm_scan);
+}
+
+uint32_t switch_matrix_idle_enter(switch_matrix_t *sm) {
+    uint32_t p0_mask = 0, p1_mask = 0;
+    for (uint i = 0; i < sm->num; i++) {
+        p0_mask |= 1 << sm->states[i].p0;
+        p1_mask |= 1 << sm->states[i].p1;
+    }
+    // p0 pins were initialized to output low when selected.
+    gpio_set_dir_out_masked(p0_mask);
+    return p1_mask & ~p0_mask;
+}
+
+void switch_matrix_idle_exit(switch_matrix_t *sm) {
+    uint32_t p0_mask = 0;
+    for (uint i = 0; i < sm->num; i++) {
+        p0_mask |= 1 << sm->states[i].p0;
+    }
+    gpio_set_dir_in_masked(p0_mask);
+    busy_wait_us_32(sm->unselect_delay);
+    sm->last = 0;
 }
 
 __attribute__((weak)) void switch_matrix_changed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on) {
@@ -57,7 +100,7 @@ __attribute__((weak)) void switch_matrix_changed(switch_matrix_t *sm, uint64_t w
         sm->changed(sm, when, state_index, on);
         return;
     }
-    printf("switch_matrix_changed: state_index=%-2d %-3s when=%llu\n", state_index, on ? "ON" : "OFF", when);
+    LOG_RING("switch_matrix_changed: state_index=%-2u %-3s when=%llu\n", state_index, on ? "ON" : "OFF", LOG_RING_U64(when));
 }
 
 __attribute__((weak)) void switch_matrix_suppressed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on, uint64_t last_changed) {
@@ -65,7 +108,7 @@ __attribute__((weak)) void switch_matrix_suppressed(switch_matrix_t *sm, uint64_
         sm->suppressed(sm, when, state_index, on, last_changed);
         return;
     }
-    printf("switch_matrix_suppressed: state_index=%-2d %-3s when=%llu last=%llu elapsed=%llu\n", state_index, on ? "ON" : "OFF", when, last_changed, when - last_changed);
+    LOG_RING("switch_matrix_suppressed: state_index=%-2u %-3s when=%llu elapsed=%lu\n", state_index, on ? "ON" : "OFF", LOG_RING_U64(when), (uint32_t)(when - last_changed));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -78,8 +121,9 @@ void sm_gpio_init(uint gpio) {
     gpio_put(gpio, false);
 }
 
-void sm_scan_switches(switch_matrix_t *sm, uint64_t now) {
+void PERF_HOT_FUNC(sm_scan_switches)(switch_matrix_t *sm, uint64_t now) {
     uint32_t scanned[32] = {0};
+    uint32_t recorded = 0;
     for (uint i = 0; i < sm->num; i++) {
         uint8_t p0 = sm->states[i].p0;
         uint8_t p1 = sm->states[i].p1;
@@ -94,11 +138,15 @@ void sm_scan_switches(switch_matrix_t *sm, uint64_t now) {
             busy_wait_us_32(sm->unselect_delay);
         }
         bool on = (scanned[p0] & (1 << p1)) == 0;
+        if (on != sm->states[i].on && (recorded & (1 << p0)) == 0) {
+            FLIGHT_RECORDER_PUT(SCAN, p0, 0, scanned[p0]);
+            recorded |= 1 << p0;
+        }
         sm_set_switch_state(sm, now, i, on);
     }
 }
 
-void sm_set_switch_state(switch_matrix_t *sm, uint64_t now, uint state_index, bool on) {
+void PERF_HOT_FUNC(sm_set_switch_state)(switch_matrix_t *sm, uint64_t now, uint state_index, bool on) {
     switch_matrix_state_t *st = &sm->states[state_index];
     if (on == st->on) {
         return;
@@ -108,12 +156,16 @@ void sm_set_switch_state(switch_matrix_t *sm, uint64_t now, uint state_index, bo
     if (elapsed >= sm->debounce_interval) {
         st->on = on;
         st->last = now >> 1;
+        FLIGHT_RECORDER_PUT(CHANGED, state_index, 0, on);
+        if (sm->stats != NULL) {
+            switch_matrix_stats_changed(&sm->stats[state_index], on, elapsed);
+        }
         switch_matrix_changed(sm, now, state_index, on);
     } else {
+        FLIGHT_RECORDER_PUT(SUPPRESSED, state_index, elapsed > UINT16_MAX ? UINT16_MAX : elapsed, on);
+        if (sm->stats != NULL) {
+            switch_matrix_stats_bounced(&sm->stats[state_index], elapsed);
+        }
         switch_matrix_suppressed(sm, now, state_index, on, last);
     }
 }
-
-void sm_performance_count(switch_matrix_t *sm, uint64_t now) {
-    // TODO:
-}
@@ -73,6 +73,10 @@ static inline void ws2812_array_set_rgb(int i, uint8_t r, uint8_t g, uint8_t b)
     ws2812_array_dirty = true;
 }
 
+// ws2812_array_apply_autocap scales colors of n LEDs down in place, so their
+// total current stays within WS2812_ARRAY_MAX_CURRENT. ws2812_array_task
+// applies it to each frame sent.
+void ws2812_array_apply_autocap(ws2812_state_t *p, int n);
 
 //----------------------------------------------------------------------------
 // Hooks
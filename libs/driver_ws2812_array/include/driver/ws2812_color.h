@@ -0,0 +1,89 @@
+#pragma once
+
+#include <pico/types.h>
+
+#include "driver/ws2812_array.h"
+
+#if PICO_RP2040
+#include "hardware/divider.h"
+#endif
+
+// Kernels on colors of ws2812_state_t.
+//
+// Scaling each channel by num / den takes a division per channel, which is a
+// call to __aeabi_uidiv on RP2040 waiting about 8 cycles for the SIO divider.
+// The factor kernel divides once per frame for a factor in Q16 instead, by
+// the divider directly, and then only multiplies. Where the CPU divides by
+// an instruction (UDIV on the Cortex-M33 of RP2350, and the host), dividing
+// each channel is as fast or faster, so ws2812_color_scale selects the kernel
+// by platform.
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+#ifndef WS2812_COLOR_SCALE_FACTOR
+    #if PICO_RP2040
+        #define WS2812_COLOR_SCALE_FACTOR 1
+    #else
+        #define WS2812_COLOR_SCALE_FACTOR 0
+    #endif
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+// ws2812_color_quotient returns a / b, which b must not be 0.
+static inline uint32_t ws2812_color_quotient(uint32_t a, uint32_t b) {
+#if PICO_RP2040
+    return hw_divider_u32_quotient_inlined(a, b);
+#else
+    return a / b;
+#endif
+}
+
+// ws2812_color_scale8 returns v * num / den, for a factor f of
+// ws2812_color_scale_factor.
+static inline uint8_t ws2812_color_scale8(uint8_t v, uint32_t num, uint32_t den, uint32_t f) {
+    uint32_t q = (v * f) >> 16;
+    // f is rounded down, so q may be short by one.
+    if ((q + 1) * den <= v * num) {
+        q++;
+    }
+    return (uint8_t)q;
+}
+
+// ws2812_color_scale_factor returns num / den in Q16. num must be less than
+// den and 2^16.
+static inline uint32_t ws2812_color_scale_factor(uint32_t num, uint32_t den) {
+    return ws2812_color_quotient(num << 16, den);
+}
+
+// ws2812_color_scale_factor_kernel scales colors of n LEDs by num / den in
+// place, as v * num / den of each channel rounded down. num must be less than
+// den and 2^16.
+static inline void ws2812_color_scale_factor_kernel(ws2812_state_t *p, int n, uint32_t num, uint32_t den) {
+    uint32_t f = ws2812_color_scale_factor(num, den);
+    for (int i = 0; i < n; i++) {
+        ws2812_color_t *c = &p[i].rgb;
+        c->b = ws2812_color_scale8(c->b, num, den, f);
+        c->r = ws2812_color_scale8(c->r, num, den, f);
+        c->g = ws2812_color_scale8(c->g, num, den, f);
+    }
+}
+
+// ws2812_color_scale_divide_kernel is ws2812_color_scale_factor_kernel by a
+// division of each channel.
+static inline void ws2812_color_scale_divide_kernel(ws2812_state_t *p, int n, uint32_t num, uint32_t den) {
+    for (int i = 0; i < n; i++) {
+        ws2812_color_t *c = &p[i].rgb;
+        c->b = (uint8_t)(c->b * num / den);
+        c->r = (uint8_t)(c->r * num / den);
+        c->g = (uint8_t)(c->g * num / den);
+    }
+}
+
+#if WS2812_COLOR_SCALE_FACTOR
+    #define ws2812_color_scale  ws2812_color_scale_factor_kernel
+#else
+    #define ws2812_color_scale  ws2812_color_scale_divide_kernel
+#endif
@@ -1,12 +1,19 @@
+#include <assert.h>
 #include <string.h>
 
 #include "driver/ws2812_array.h"
+#include "driver/ws2812_color.h"
 
 #include "pico/sem.h"
 #include "hardware/dma.h"
 
 #include "ws2812.pio.h"
 
+#include "perf/hot.h"
+#include "perf/probe.h"
+
+PERF_PROBE_DEFINE(ws2812_task);
+
 bool ws2812_array_dirty = false;
 
 ws2812_state_t ws2812_array_states[WS2812_ARRAY_NUM] = {0};
@@ -30,7 +37,7 @@ static int64_t on_completed_resetdelay(alarm_id_t id, void *user_data) {
     return 0; // no repeat
 }
 
-static void __isr on_completed_dma() {
+static void __isr PERF_HOT_FUNC(on_completed_dma)() {
     if (dma_hw->ints0 & dma_chan_mask) {
         // clear IRQ0 status register bit
         dma_hw->ints0 = dma_chan_mask;
@@ -71,11 +78,9 @@ void ws2812_array_init(void) {
 
 const uint64_t MAX_TOTAL_LEVEL = WS2812_ARRAY_MAX_CURRENT * 255 / WS2812_ARRAY_CURRENT_PER_CHANNEL;
 
-static inline uint8_t muldiv8_32(uint8_t v, uint32_t mul, uint32_t div) {
-    return (uint8_t)((uint32_t)v * mul / div);
-}
+static_assert(WS2812_ARRAY_MAX_CURRENT * 255 / WS2812_ARRAY_CURRENT_PER_CHANNEL < (1 << 16), "WS2812_ARRAY_MAX_CURRENT is too large for ws2812_color_scale");
 
-static void apply_autocap(ws2812_state_t *p, int n) {
+void PERF_HOT_FUNC(ws2812_array_apply_autocap)(ws2812_state_t *p, int n) {
     if (MAX_TOTAL_LEVEL == 0) {
         return;
     }
@@ -89,26 +94,22 @@ static void apply_autocap(ws2812_state_t *p, int n) {
     if (total <= MAX_TOTAL_LEVEL) {
         return;
     }
-    for (int i = 0; i < n; i++) {
-        ws2812_color_t *c = &p[i].rgb;
-        c->b = muldiv8_32(c->b, MAX_TOTAL_LEVEL, total);
-        c->r = muldiv8_32(c->r, MAX_TOTAL_LEVEL, total);
-        c->g = muldiv8_32(c->g, MAX_TOTAL_LEVEL, total);
-    }
+    ws2812_color_scale(p, n, MAX_TOTAL_LEVEL, total);
 }
 
-bool ws2812_array_task(uint64_t now) {
+bool PERF_HOT_FUNC(ws2812_array_task)(uint64_t now) {
     if (!ws2812_array_dirty) {
         return false;
     }
     if (!sem_acquire_timeout_ms(&resetdelay_sem, 0)) {
         return false;
     }
+    PERF_PROBE_SCOPE(ws2812_task);
     ws2812_array_dirty = false;
     // Copy the DMA target to the send buffer to protect it from being
     // overwritten.
     memcpy(sendbuf, ws2812_array_states, sizeof(sendbuf));
-    apply_autocap(sendbuf, count_of(sendbuf));
+    ws2812_array_apply_autocap(sendbuf, count_of(sendbuf));
     dma_channel_set_read_addr(dma_chan, sendbuf, true);
     return true;
 }
@@ -0,0 +1,123 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// FLIGHT_RECORDER_ENABLED turns on the recorder. When it is 0 every
+// FLIGHT_RECORDER_* macro expands to nothing.
+#ifndef FLIGHT_RECORDER_ENABLED
+    #define FLIGHT_RECORDER_ENABLED 1
+#endif
+
+// Number of entries kept. Must be a power of 2. An entry is 12 bytes.
+#ifndef FLIGHT_RECORDER_LEN
+    #define FLIGHT_RECORDER_LEN 256
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+#include <pico/types.h>
+
+#include "hardware/timer.h"
+
+typedef enum {
+    // a row of a switch matrix which differs from the debounced states.
+    // index: p0 pin, value: gpio_get_all() while selected.
+    FLIGHT_RECORDER_SCAN = 1,
+    // index: state index, value: on.
+    FLIGHT_RECORDER_CHANGED,
+    // a change suppressed by debouncing. value: on, aux: elapsed in us.
+    FLIGHT_RECORDER_SUPPRESSED,
+    // a new word of a rotary encoder. index: pin A, aux: word, value: delta.
+    FLIGHT_RECORDER_ENCODER,
+    // a run of a task over its budget. index: priority, aux: elapsed in us,
+    // value: address of the name.
+    FLIGHT_RECORDER_OVERRUN,
+    // by the program.
+    FLIGHT_RECORDER_USER,
+} flight_recorder_kind_t;
+
+// Reasons to freeze the recorder.
+typedef enum {
+    FLIGHT_RECORDER_RUNNING = 0,
+    FLIGHT_RECORDER_TRIGGER_USER,
+    FLIGHT_RECORDER_TRIGGER_WATCHDOG,
+    FLIGHT_RECORDER_TRIGGER_LATENCY,
+} flight_recorder_trigger_t;
+
+typedef struct {
+    uint32_t time;
+    uint8_t  kind;
+    uint8_t  index;
+    uint16_t aux;
+    uint32_t value;
+} flight_recorder_entry_t;
+
+// The recorder is placed in uninitialized RAM, so it survives a soft reset
+// and a watchdog reset.
+typedef struct {
+    uint32_t magic;
+    // number of entries recorded, which wraps around by FLIGHT_RECORDER_LEN.
+    uint32_t head;
+    // flight_recorder_trigger_t which froze the recorder.
+    uint32_t trigger;
+    uint32_t trigger_time;
+    // next entry to dump while frozen.
+    uint32_t dump_pos;
+    flight_recorder_entry_t entries[FLIGHT_RECORDER_LEN];
+} flight_recorder_t;
+
+extern flight_recorder_t flight_recorder;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// flight_recorder_init starts recording. A recording frozen before a reset is
+// kept to be dumped, and one running at a watchdog reset is frozen for it.
+void flight_recorder_init(void);
+
+// flight_recorder_trigger freezes the recorder, and starts a dump.
+void flight_recorder_trigger(flight_recorder_trigger_t reason);
+
+// flight_recorder_dump_task writes entries of a frozen recorder to log_ring
+// as long as the ring has room, oldest first, and restarts recording after
+// the last one. It returns true while entries remain.
+bool flight_recorder_dump_task(void);
+
+// flight_recorder_put adds an entry, unless frozen. It is not safe against
+// IRQ handlers which record too.
+static inline void flight_recorder_put(flight_recorder_kind_t kind, uint index, uint aux, uint32_t value) {
+    flight_recorder_t *fr = &flight_recorder;
+    if (fr->trigger != FLIGHT_RECORDER_RUNNING) {
+        return;
+    }
+    flight_recorder_entry_t *e = &fr->entries[fr->head++ & (FLIGHT_RECORDER_LEN - 1)];
+    e->time  = time_us_32();
+    e->kind  = kind;
+    e->index = index;
+    e->aux   = aux;
+    e->value = value;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Macros
+
+#if FLIGHT_RECORDER_ENABLED
+
+#define FLIGHT_RECORDER_PUT(kind, index, aux, value) \
+    flight_recorder_put(FLIGHT_RECORDER_##kind, index, aux, value)
+
+#else
+
+#define FLIGHT_RECORDER_PUT(kind, index, aux, value) do {} while (0)
+
+#endif
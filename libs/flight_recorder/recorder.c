@@ -0,0 +1,116 @@
+#include <string.h>
+
+#include "flight/recorder.h"
+#include "log/ring.h"
+
+#include "pico/platform.h"
+#include "hardware/watchdog.h"
+
+// Entries are written with a few stores and no lock, and the recorder is
+// always on. A trigger freezes it, and the entries are dumped as log_ring
+// records, which logdecode.py turns into text. A recording frozen but not
+// dumped yet stays in uninitialized RAM across a reset, and is dumped after
+// the reset.
+
+_Static_assert((FLIGHT_RECORDER_LEN & (FLIGHT_RECORDER_LEN - 1)) == 0, "FLIGHT_RECORDER_LEN must be a power of 2");
+
+#define FLIGHT_RECORDER_MAGIC 0x46524543
+
+// Records of log_ring kept free for others while dumping.
+#define FLIGHT_RECORDER_DUMP_RESERVE 16
+
+flight_recorder_t __uninitialized_ram(flight_recorder);
+
+static const char *const flight_recorder_kind_names[] = {
+    [FLIGHT_RECORDER_SCAN]       = "scan",
+    [FLIGHT_RECORDER_CHANGED]    = "changed",
+    [FLIGHT_RECORDER_SUPPRESSED] = "bounce",
+    [FLIGHT_RECORDER_ENCODER]    = "encoder",
+    [FLIGHT_RECORDER_OVERRUN]    = "overrun",
+    [FLIGHT_RECORDER_USER]       = "user",
+};
+
+static const char *const flight_recorder_trigger_names[] = {
+    [FLIGHT_RECORDER_TRIGGER_USER]     = "user",
+    [FLIGHT_RECORDER_TRIGGER_WATCHDOG] = "watchdog",
+    [FLIGHT_RECORDER_TRIGGER_LATENCY]  = "latency",
+};
+
+static void flight_recorder_restart(void) {
+    flight_recorder_t *fr = &flight_recorder;
+    fr->head = 0;
+    fr->dump_pos = 0;
+    memset(fr->entries, 0, sizeof(fr->entries));
+    fr->magic = FLIGHT_RECORDER_MAGIC;
+    fr->trigger = FLIGHT_RECORDER_RUNNING;
+}
+
+static bool flight_recorder_valid(void) {
+    flight_recorder_t *fr = &flight_recorder;
+    return fr->magic == FLIGHT_RECORDER_MAGIC &&
+        fr->trigger < count_of(flight_recorder_trigger_names) &&
+        fr->dump_pos <= FLIGHT_RECORDER_LEN;
+}
+
+void flight_recorder_init(void) {
+    flight_recorder_t *fr = &flight_recorder;
+    if (!flight_recorder_valid()) {
+        flight_recorder_restart();
+        return;
+    }
+    if (fr->trigger == FLIGHT_RECORDER_RUNNING) {
+        if (!watchdog_caused_reboot()) {
+            flight_recorder_restart();
+            return;
+        }
+        fr->trigger = FLIGHT_RECORDER_TRIGGER_WATCHDOG;
+        fr->trigger_time = 0;
+        fr->dump_pos = 0;
+    }
+    LOG_RING("flight_recorder: kept from before reset\n");
+}
+
+void flight_recorder_trigger(flight_recorder_trigger_t reason) {
+    flight_recorder_t *fr = &flight_recorder;
+    if (fr->trigger != FLIGHT_RECORDER_RUNNING) {
+        return;
+    }
+    fr->trigger = reason;
+    fr->trigger_time = time_us_32();
+    fr->dump_pos = 0;
+}
+
+bool flight_recorder_dump_task(void) {
+    flight_recorder_t *fr = &flight_recorder;
+    if (fr->trigger == FLIGHT_RECORDER_RUNNING) {
+        return false;
+    }
+    uint32_t n = fr->head < FLIGHT_RECORDER_LEN ? fr->head : FLIGHT_RECORDER_LEN;
+    if (fr->dump_pos == 0) {
+        // the header is followed by an entry at least, not to be repeated.
+        if (log_ring_space() <= FLIGHT_RECORDER_DUMP_RESERVE + 1) {
+            return true;
+        }
+        LOG_RING("flight_recorder: trigger=%s at %lu entries=%lu\n",
+                flight_recorder_trigger_names[fr->trigger], fr->trigger_time, n);
+    }
+    while (fr->dump_pos < n && log_ring_space() > FLIGHT_RECORDER_DUMP_RESERVE) {
+        uint32_t i = (fr->head - n + fr->dump_pos) & (FLIGHT_RECORDER_LEN - 1);
+        const flight_recorder_entry_t *e = &fr->entries[i];
+        const char *kind = e->kind < count_of(flight_recorder_kind_names) ? flight_recorder_kind_names[e->kind] : NULL;
+        if (e->kind == FLIGHT_RECORDER_OVERRUN) {
+            LOG_RING("flight_recorder: %10lu %-8s index=%-2u aux=%-5u task=%s\n",
+                    e->time, kind, e->index, e->aux, e->value);
+        } else {
+            LOG_RING("flight_recorder: %10lu %-8s index=%-2u aux=%-5u value=0x%08lx\n",
+                    e->time, kind != NULL ? kind : "?", e->index, e->aux, e->value);
+        }
+        fr->dump_pos++;
+    }
+    if (fr->dump_pos < n) {
+        return true;
+    }
+    LOG_RING("flight_recorder: end\n");
+    flight_recorder_restart();
+    return false;
+}
@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+
+# Compiles fonts and images into page ordered 1bpp C sources for gfx_mono, at
+# build time.
+#
+# usage:
+#   assetc.py font   [--spacing N] <NAME> <FONT.bdf> <OUT.c> <OUT.h>
+#   assetc.py bitmap [--rle] [--max-width W] [--max-height H]
+#                    <NAME> <IMAGE> <OUT.c> <OUT.h>
+#
+# Fonts are read from BDF. Images are read from PBM/PGM (P1, P2, P4, P5)
+# without any dependency, and from other formats when Pillow is installed.
+# Dark pixels become "on".
+#
+# Output is laid out like SSD1306 frame buffer: ceil(height / 8) pages of
+# width bytes, each byte is a column of 8 pixels with the least significant
+# bit at top. All data is const, so it stays in flash.
+#
+# With --rle a bitmap is compressed when it gets smaller. A control byte c
+# with the top bit set repeats the next byte (c & 0x7f) + 2 times, otherwise
+# c + 1 literal bytes follow.
+
+import argparse
+import sys
+from pathlib import Path
+
+
+def fail(msg):
+    print(f'assetc: {msg}', file=sys.stderr)
+    sys.exit(1)
+
+
+##############################################################################
+# Images
+
+def read_netpbm(path):
+    data = Path(path).read_bytes()
+    pos = 0
+
+    def token():
+        nonlocal pos
+        while True:
+            while pos < len(data) and data[pos:pos+1].isspace():
+                pos += 1
+            if data[pos:pos+1] == b'#':
+                while pos < len(data) and data[pos:pos+1] not in (b'\n', b'\r'):
+                    pos += 1
+                continue
+            break
+        start = pos
+        while pos < len(data) and not data[pos:pos+1].isspace():
+            pos += 1
+        return data[start:pos]
+
+    magic = token()
+    if magic not in (b'P1', b'P2', b'P4', b'P5'):
+        return None
+    width = int(token())
+    height = int(token())
+    maxval = 1 if magic in (b'P1', b'P4') else int(token())
+    pixels = []
+    if magic == b'P1':
+        digits = [c for c in data[pos:] if c in b'01']
+        pixels = [c == ord('1') for c in digits[:width * height]]
+    elif magic == b'P2':
+        pixels = [int(token()) < (maxval + 1) // 2 for _ in range(width * height)]
+    elif magic == b'P4':
+        pos += 1
+        stride = (width + 7) // 8
+        for y in range(height):
+            row = data[pos + y * stride:pos + (y + 1) * stride]
+            pixels += [(row[x // 8] >> (7 - x % 8)) & 1 == 1 for x in range(width)]
+    elif magic == b'P5':
+        pos += 1
+        pixels = [v < (maxval + 1) // 2 for v in data[pos:pos + width * height]]
+    if len(pixels) != width * height:
+        fail(f'{path}: truncated image')
+    return width, height, pixels
+
+
+def read_image(path):
+    img = read_netpbm(path)
+    if img is not None:
+        return img
+    try:
+        from PIL import Image
+    except ImportError:
+        fail(f'{path}: only PBM/PGM can be read without Pillow')
+    im = Image.open(path).convert('L')
+    pixels = [v < 128 for v in im.getdata()]
+    return im.size[0], im.size[1], pixels
+
+
+def to_pages(width, height, pixel):
+    out = []
+    for page in range((height + 7) // 8):
+        for x in range(width):
+            b = 0
+            for k in range(8):
+                y = page * 8 + k
+                if y < height and pixel(x, y):
+                    b |= 1 << k
+            out.append(b)
+    return out
+
+
+def rle(data):
+    out = []
+    i = 0
+    literal = []
+
+    def flush():
+        while literal:
+            chunk = literal[:128]
+            del literal[:128]
+            out.append(len(chunk) - 1)
+            out.extend(chunk)
+
+    while i < len(data):
+        n = 1
+        while i + n < len(data) and data[i + n] == data[i] and n < 129:
+            n += 1
+        if n >= 2:
+            flush()
+            out.append(0x80 | (n - 2))
+            out.append(data[i])
+            i += n
+        else:
+            literal.append(data[i])
+            i += 1
+    flush()
+    return out
+
+
+##############################################################################
+# Fonts
+
+def read_bdf(path):
+    font = {'glyphs': {}}
+    glyph = None
+    bitmap = None
+    for line in Path(path).read_text().splitlines():
+        words = line.split()
+        if not words:
+            continue
+        key = words[0]
+        if bitmap is not None:
+            if key == 'ENDCHAR':
+                glyph['bitmap'] = bitmap
+                if glyph['encoding'] >= 0:
+                    font['glyphs'][glyph['encoding']] = glyph
+                glyph = bitmap = None
+            else:
+                bitmap.append(int(key, 16))
+            continue
+        if key == 'FONTBOUNDINGBOX':
+            font['bbx'] = [int(v) for v in words[1:5]]
+        elif key == 'FONT_ASCENT':
+            font['ascent'] = int(words[1])
+        elif key == 'STARTCHAR':
+            glyph = {'encoding': -1, 'dwidth': 0, 'bbx': [0, 0, 0, 0]}
+        elif key == 'ENCODING':
+            glyph['encoding'] = int(words[1])
+        elif key == 'DWIDTH':
+            glyph['dwidth'] = int(words[1])
+        elif key == 'BBX':
+            glyph['bbx'] = [int(v) for v in words[1:5]]
+        elif key == 'BITMAP':
+            bitmap = []
+    if 'bbx' not in font:
+        fail(f'{path}: FONTBOUNDINGBOX is missing')
+    if 'ascent' not in font:
+        font['ascent'] = font['bbx'][1] + font['bbx'][3]
+    return font
+
+
+def glyph_columns(font, glyph, width, height):
+    gw, gh, gx, gy = glyph['bbx']
+    top = font['ascent'] - (gy + gh)
+    bits = ((gw + 7) // 8) * 8
+
+    def pixel(x, y):
+        row = y - top
+        col = x - gx
+        if row < 0 or row >= gh or col < 0 or col >= gw:
+            return False
+        return (glyph['bitmap'][row] >> (bits - 1 - col)) & 1 == 1
+
+    return to_pages(width, height, pixel)
+
+
+##############################################################################
+# Output
+
+def c_bytes(data, indent='    ', per_line=12):
+    lines = []
+    for i in range(0, len(data), per_line):
+        lines.append(indent + ', '.join(f'0x{b:02x}' for b in data[i:i + per_line]) + ',')
+    return '\n'.join(lines)
+
+
+def write(path, text):
+    p = Path(path)
+    if p.exists() and p.read_text() == text:
+        return
+    p.write_text(text)
+
+
+def header(name, kind, src):
+    guard = f'#pragma once\n\n// Generated by assetc.py from {Path(src).name}. DO NOT EDIT.\n\n'
+    return guard + f'#include "gfx/{kind}.h"\n\n' + \
+        '#ifdef __cplusplus\nextern "C" {\n#endif\n\n' + \
+        f'extern const gfx_{kind}_t gfx_{kind}_{name};\n\n' + \
+        '#ifdef __cplusplus\n}\n#endif\n'
+
+
+def compile_font(args):
+    font = read_bdf(args.source)
+    glyphs = font['glyphs']
+    if not glyphs:
+        fail(f'{args.source}: no glyphs')
+    height = font['bbx'][1]
+    if height > 255:
+        fail(f'{args.source}: too tall font')
+    first = min(c for c in glyphs if c >= 0x20)
+    last = max(c for c in glyphs if c <= 0xff)
+    default_width = max(0, glyphs.get(0x20, {'dwidth': font['bbx'][0]})['dwidth'] - args.spacing)
+    offsets, widths, data, lines = [], [], [], []
+    for c in range(first, last + 1):
+        g = glyphs.get(c)
+        w = max(0, g['dwidth'] - args.spacing) if g else default_width
+        cols = glyph_columns(font, g, w, height) if g else [0] * (w * ((height + 7) // 8))
+        offsets.append(len(data))
+        widths.append(w)
+        data += cols
+        ch = chr(c)
+        label = f"'\\{ch}'" if ch in "\\'" else f"'{ch}'" if 0x20 <= c < 0x7f else f'0x{c:02x}'
+        lines.append(('    ' + ', '.join(f'0x{b:02x}' for b in cols) + ',' if cols else '   ') + f' // {label}')
+    if len(data) > 0xffff:
+        fail(f'{args.source}: too large font')
+    src = f'// Generated by assetc.py from {Path(args.source).name}. DO NOT EDIT.\n\n'
+    src += f'#include "gfx_font_{args.name}.h"\n\n'
+    src += 'static const uint8_t bitmaps[] = {\n' + '\n'.join(lines) + '\n};\n\n'
+    src += 'static const uint16_t offsets[] = {\n'
+    src += '\n'.join('    ' + ', '.join(f'{o}' for o in offsets[i:i + 12]) + ','
+                     for i in range(0, len(offsets), 12)) + '\n};\n\n'
+    src += 'static const uint8_t widths[] = {\n'
+    src += '\n'.join('    ' + ', '.join(f'{w}' for w in widths[i:i + 16]) + ','
+                     for i in range(0, len(widths), 16)) + '\n};\n\n'
+    src += f'''const gfx_font_t gfx_font_{args.name} = {{
+    .height   = {height},
+    .first    = 0x{first:02x},
+    .last     = 0x{last:02x},
+    .spacing  = {args.spacing},
+    .offsets  = offsets,
+    .widths   = widths,
+    .bitmaps  = bitmaps,
+}};
+'''
+    write(args.out_c, src)
+    write(args.out_h, header(args.name, 'font', args.source))
+
+
+def compile_bitmap(args):
+    width, height, pixels = read_image(args.source)
+    if args.max_width and width > args.max_width:
+        fail(f'{args.source}: {width} pixels wide, but display is only {args.max_width}')
+    if args.max_height and height > args.max_height:
+        fail(f'{args.source}: {height} pixels high, but display is only {args.max_height}')
+    data = to_pages(width, height, lambda x, y: pixels[y * width + x])
+    flags = '0'
+    if args.rle:
+        packed = rle(data)
+        if len(packed) < len(data):
+            data = packed
+            flags = 'GFX_BITMAP_RLE'
+    src = f'// Generated by assetc.py from {Path(args.source).name}. DO NOT EDIT.\n\n'
+    src += f'#include "gfx_bitmap_{args.name}.h"\n\n'
+    src += 'static const uint8_t data[] = {\n' + c_bytes(data) + '\n};\n\n'
+    src += f'''const gfx_bitmap_t gfx_bitmap_{args.name} = {{
+    .width  = {width},
+    .height = {height},
+    .flags  = {flags},
+    .size   = sizeof(data),
+    .data   = data,
+}};
+'''
+    write(args.out_c, src)
+    write(args.out_h, header(args.name, 'bitmap', args.source))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='compile fonts and images for gfx_mono')
+    sub = parser.add_subparsers(dest='kind', required=True)
+
+    p = sub.add_parser('font')
+    p.add_argument('--spacing', type=int, default=1)
+    p.set_defaults(func=compile_font)
+
+    p = sub.add_parser('bitmap')
+    p.add_argument('--rle', action='store_true')
+    p.add_argument('--max-width', type=int, default=0)
+    p.add_argument('--max-height', type=int, default=0)
+    p.set_defaults(func=compile_bitmap)
+
+    for p in sub.choices.values():
+        p.add_argument('name')
+        p.add_argument('source')
+        p.add_argument('out_c')
+        p.add_argument('out_h')
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,36 @@
+#include "gfx/bitmap.h"
+
+// RLE data is a sequence of runs. A control byte c with the top bit set
+// repeats the next byte (c & 0x7f) + 2 times, otherwise c + 1 literal bytes
+// follow.
+
+void gfx_bitmap_reader_init(gfx_bitmap_reader_t *r, const gfx_bitmap_t *b) {
+    r->p = b->data;
+    r->end = b->data + b->size;
+    r->rle = (b->flags & GFX_BITMAP_RLE) != 0;
+    r->repeat = false;
+    r->count = 0;
+}
+
+uint8_t gfx_bitmap_reader_next(gfx_bitmap_reader_t *r) {
+    if (!r->rle) {
+        return r->p < r->end ? *r->p++ : 0;
+    }
+    if (r->count == 0) {
+        if (r->p >= r->end) {
+            return 0;
+        }
+        uint8_t c = *r->p++;
+        r->repeat = (c & 0x80) != 0;
+        r->count = r->repeat ? (c & 0x7f) + 2 : c + 1;
+    }
+    r->count--;
+    if (r->repeat) {
+        uint8_t v = r->p < r->end ? *r->p : 0;
+        if (r->count == 0) {
+            r->p++;
+        }
+        return v;
+    }
+    return r->p < r->end ? *r->p++ : 0;
+}
@@ -0,0 +1,62 @@
+# Build time compilation of fonts and images for gfx_mono.
+#
+#   gfx_add_font(<target> <name> <font.bdf> [SPACING n])
+#   gfx_add_bitmap(<target> <name> <image> [RLE] [MAX_WIDTH w] [MAX_HEIGHT h])
+#
+# These generate gfx_font_<name>.c/.h or gfx_bitmap_<name>.c/.h into the
+# binary directory of the target, compile the .c into the target, and add the
+# directory to its include path. Sources are regenerated when the font, the
+# image or assetc.py is changed.
+
+find_package(Python3 COMPONENTS Interpreter REQUIRED)
+
+set(GFX_ASSETC ${CMAKE_CURRENT_LIST_DIR}/assetc.py CACHE INTERNAL "")
+
+function(gfx_add_asset target kind name source)
+	set(dir ${CMAKE_CURRENT_BINARY_DIR}/gfx_assets)
+	set(out_c ${dir}/gfx_${kind}_${name}.c)
+	set(out_h ${dir}/gfx_${kind}_${name}.h)
+	get_filename_component(source ${source} ABSOLUTE)
+	add_custom_command(
+		OUTPUT ${out_c} ${out_h}
+		COMMAND ${CMAKE_COMMAND} -E make_directory ${dir}
+		COMMAND Python3::Interpreter ${GFX_ASSETC} ${kind} ${ARGN} ${name} ${source} ${out_c} ${out_h}
+		DEPENDS ${source} ${GFX_ASSETC}
+		COMMENT "Generating gfx_${kind}_${name} from ${source}"
+		VERBATIM
+	)
+	get_target_property(type ${target} TYPE)
+	if (type STREQUAL "INTERFACE_LIBRARY")
+		target_sources(${target} INTERFACE ${out_c})
+		target_include_directories(${target} INTERFACE ${dir})
+	else()
+		target_sources(${target} PRIVATE ${out_c})
+		target_include_directories(${target} PUBLIC ${dir})
+	endif()
+endfunction()
+
+function(gfx_add_font target name source)
+	cmake_parse_arguments(ARG "" "SPACING" "" ${ARGN})
+	set(opts)
+	if (DEFINED ARG_SPACING)
+		list(APPEND opts --spacing ${ARG_SPACING})
+	endif()
+	gfx_add_asset(${target} font ${name} ${source} ${opts})
+endfunction()
+
+function(gfx_add_bitmap target name source)
+	cmake_parse_arguments(ARG "RLE" "MAX_WIDTH;MAX_HEIGHT" "" ${ARGN})
+	set(opts)
+	if (ARG_RLE)
+		list(APPEND opts --rle)
+	endif()
+	if (DEFINED ARG_MAX_WIDTH)
+		list(APPEND opts --max-width ${ARG_MAX_WIDTH})
+	endif()
+	if (DEFINED ARG_MAX_HEIGHT)
+		list(APPEND opts --max-height ${ARG_MAX_HEIGHT})
+	endif()
+	gfx_add_asset(${target} bitmap ${name} ${source} ${opts})
+endfunction()
+
+# vim:set ts=4 sts=4 sw=4 tw=0 noet:
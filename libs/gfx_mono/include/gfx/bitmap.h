@@ -0,0 +1,44 @@
+#pragma once
+
+#include <pico/types.h>
+
+// data is compressed by run length encoding.
+#define GFX_BITMAP_RLE  0x01
+
+// gfx_bitmap_t is an image in the page ordered layout of frame buffers,
+// generated by gfx_add_bitmap() at build time. data stays in flash.
+typedef struct {
+    uint16_t width;
+    uint16_t height;
+    uint8_t  flags;
+    uint32_t size;
+    const uint8_t *data;
+} gfx_bitmap_t;
+
+// gfx_bitmap_reader_t reads bytes of a bitmap in page order, decompressing
+// RLE on the fly.
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool     rle;
+    bool     repeat;
+    uint8_t  count;
+} gfx_bitmap_reader_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void gfx_bitmap_reader_init(gfx_bitmap_reader_t *r, const gfx_bitmap_t *b);
+
+// gfx_bitmap_reader_next returns next byte, or 0 after the end.
+uint8_t gfx_bitmap_reader_next(gfx_bitmap_reader_t *r);
+
+// gfx_bitmap_len returns length of decompressed data in bytes.
+static inline uint32_t gfx_bitmap_len(const gfx_bitmap_t *b) {
+    return (uint32_t)b->width * ((b->height + 7) >> 3);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <pico/types.h>
+
+// gfx_font_t is a proportional bitmap font, generated from BDF by
+// gfx_add_font() at build time. Each glyph is stored in the same page ordered
+// layout as a frame buffer: ceil(height / 8) pages of width bytes, and each
+// byte is a column of 8 pixels with the least significant bit at top.
+typedef struct {
+    uint8_t height;
+    uint8_t first;
+    uint8_t last;
+    // blank columns between glyphs.
+    uint8_t spacing;
+
+    // offsets[ch - first] is the index of the glyph's first byte in bitmaps.
+    const uint16_t *offsets;
+    const uint8_t  *widths;
+    const uint8_t  *bitmaps;
+} gfx_font_t;
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <pico/types.h>
+
+#include "gfx/bitmap.h"
+#include "gfx/font.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+// gfx_mono_t is a canvas of 1bpp frame buffer in the page ordered layout of
+// SSD1306: byte (y / 8) * width + x holds 8 vertical pixels, the least
+// significant bit at top.
+typedef struct {
+    uint8_t *buf;
+    int16_t width;
+    int16_t height;
+} gfx_mono_t;
+
+// Modes to draw bitmaps.
+typedef enum {
+    // overwrite pixels in the bitmap's rectangle.
+    GFX_MONO_COPY,
+    // set pixels which are on in the bitmap.
+    GFX_MONO_OR,
+    // clear pixels which are on in the bitmap.
+    GFX_MONO_CLEAR,
+    // invert pixels which are on in the bitmap.
+    GFX_MONO_XOR,
+} gfx_mono_mode_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// gfx_mono_init setups a canvas on a buffer of width * ceil(height / 8) bytes.
+void gfx_mono_init(gfx_mono_t *g, uint8_t *buf, int width, int height);
+
+// gfx_mono_clear fills whole canvas.
+void gfx_mono_clear(gfx_mono_t *g, bool on);
+
+// All drawing functions below clip to the canvas.
+
+void gfx_mono_set_pixel(gfx_mono_t *g, int x, int y, bool on);
+
+// gfx_mono_hline draws a horizontal line, a bit of bytes in a page.
+void gfx_mono_hline(gfx_mono_t *g, int x, int y, int w, bool on);
+
+// gfx_mono_vline draws a vertical line, whole bytes for inner pages.
+void gfx_mono_vline(gfx_mono_t *g, int x, int y, int h, bool on);
+
+// gfx_mono_fill_rect fills a rectangle, inner pages are filled by memset.
+void gfx_mono_fill_rect(gfx_mono_t *g, int x, int y, int w, int h, bool on);
+
+// gfx_mono_line draws a line by Bresenham's algorithm. Horizontal and
+// vertical lines are drawn as spans.
+void gfx_mono_line(gfx_mono_t *g, int x0, int y0, int x1, int y1, bool on);
+
+// gfx_mono_blit draws a page ordered bitmap of w * h pixels at any (x, y).
+// Each column byte is shifted into two pages of the canvas.
+void gfx_mono_blit(gfx_mono_t *g, int x, int y, const uint8_t *bitmap, int w, int h, gfx_mono_mode_t mode);
+
+// gfx_mono_draw_bitmap draws a generated bitmap at any (x, y). RLE bitmaps
+// are decompressed a chunk of columns at a time on stack.
+void gfx_mono_draw_bitmap(gfx_mono_t *g, int x, int y, const gfx_bitmap_t *b, gfx_mono_mode_t mode);
+
+// gfx_mono_draw_char draws a glyph, and returns its advance in pixels.
+// Characters out of the font are drawn as '?'. In GFX_MONO_COPY mode, the
+// spacing after the glyph is cleared too.
+int gfx_mono_draw_char(gfx_mono_t *g, int x, int y, const gfx_font_t *font, char ch, gfx_mono_mode_t mode);
+
+// gfx_mono_draw_string draws a string, and returns x after the last glyph.
+int gfx_mono_draw_string(gfx_mono_t *g, int x, int y, const gfx_font_t *font, const char *str, gfx_mono_mode_t mode);
+
+// gfx_font_text_width returns width of a string in pixels.
+int gfx_font_text_width(const gfx_font_t *font, const char *str);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,243 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "gfx/mono.h"
+
+// All drawing is done a byte (8 vertical pixels) at a time. A rectangle
+// covers a partial page at top, full pages and a partial page at bottom, and
+// each of them is a run of bytes with a same mask. A bitmap row shifted by
+// y % 8 straddles two pages, so it is written as two runs.
+
+static inline int gfx_mono_pages(gfx_mono_t *g) {
+    return (g->height + 7) >> 3;
+}
+
+static inline void gfx_mono_apply(uint8_t *p, int n, uint8_t mask, bool on) {
+    if (on) {
+        for (int i = 0; i < n; i++) {
+            p[i] |= mask;
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            p[i] &= ~mask;
+        }
+    }
+}
+
+void gfx_mono_init(gfx_mono_t *g, uint8_t *buf, int width, int height) {
+    g->buf = buf;
+    g->width = width;
+    g->height = height;
+}
+
+void gfx_mono_clear(gfx_mono_t *g, bool on) {
+    memset(g->buf, on ? 0xff : 0x00, g->width * gfx_mono_pages(g));
+}
+
+void gfx_mono_set_pixel(gfx_mono_t *g, int x, int y, bool on) {
+    if (x < 0 || x >= g->width || y < 0 || y >= g->height) {
+        return;
+    }
+    uint8_t *p = &g->buf[(y >> 3) * g->width + x];
+    uint8_t mask = 1u << (y & 7);
+    if (on) {
+        *p |= mask;
+    } else {
+        *p &= ~mask;
+    }
+}
+
+void gfx_mono_hline(gfx_mono_t *g, int x, int y, int w, bool on) {
+    gfx_mono_fill_rect(g, x, y, w, 1, on);
+}
+
+void gfx_mono_vline(gfx_mono_t *g, int x, int y, int h, bool on) {
+    gfx_mono_fill_rect(g, x, y, 1, h, on);
+}
+
+void gfx_mono_fill_rect(gfx_mono_t *g, int x, int y, int w, int h, bool on) {
+    if (x < 0) {
+        w += x;
+        x = 0;
+    }
+    if (y < 0) {
+        h += y;
+        y = 0;
+    }
+    if (x + w > g->width) {
+        w = g->width - x;
+    }
+    if (y + h > g->height) {
+        h = g->height - y;
+    }
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+    int page = y >> 3;
+    int last = (y + h - 1) >> 3;
+    uint8_t top    = 0xff << (y & 7);
+    uint8_t bottom = 0xff >> (7 - ((y + h - 1) & 7));
+    uint8_t *p = g->buf + page * g->width + x;
+    if (page == last) {
+        gfx_mono_apply(p, w, top & bottom, on);
+        return;
+    }
+    gfx_mono_apply(p, w, top, on);
+    p += g->width;
+    for (page++; page < last; page++) {
+        memset(p, on ? 0xff : 0x00, w);
+        p += g->width;
+    }
+    gfx_mono_apply(p, w, bottom, on);
+}
+
+void gfx_mono_line(gfx_mono_t *g, int x0, int y0, int x1, int y1, bool on) {
+    if (y0 == y1) {
+        gfx_mono_hline(g, x0 < x1 ? x0 : x1, y0, abs(x1 - x0) + 1, on);
+        return;
+    }
+    if (x0 == x1) {
+        gfx_mono_vline(g, x0, y0 < y1 ? y0 : y1, abs(y1 - y0) + 1, on);
+        return;
+    }
+    int dx =  abs(x1 - x0);
+    int sx = x0 < x1 ? 1 : -1;
+    int dy = -abs(y1 - y0);
+    int sy = y0 < y1 ? 1 : -1;
+    int err = dx + dy;
+    while (true) {
+        gfx_mono_set_pixel(g, x0, y0, on);
+        if (x0 == x1 && y0 == y1) {
+            break;
+        }
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y0 += sy;
+        }
+    }
+}
+
+// gfx_mono_blit_run writes n columns of a bitmap page to a canvas page.
+// shift is y % 8 of the bitmap, and half selects lower (0) or upper (1) byte
+// of the shifted columns.
+static void gfx_mono_blit_run(uint8_t *dst, const uint8_t *src, int n, uint8_t valid, int shift, int half, gfx_mono_mode_t mode) {
+    int rshift = half * 8;
+    uint8_t mask = (uint8_t)(((uint)valid << shift) >> rshift);
+    switch (mode) {
+        case GFX_MONO_COPY:
+            for (int i = 0; i < n; i++) {
+                uint8_t v = (uint8_t)(((uint)(src[i] & valid) << shift) >> rshift);
+                dst[i] = (dst[i] & ~mask) | v;
+            }
+            break;
+        case GFX_MONO_OR:
+            for (int i = 0; i < n; i++) {
+                dst[i] |= (uint8_t)(((uint)(src[i] & valid) << shift) >> rshift);
+            }
+            break;
+        case GFX_MONO_CLEAR:
+            for (int i = 0; i < n; i++) {
+                dst[i] &= ~(uint8_t)(((uint)(src[i] & valid) << shift) >> rshift);
+            }
+            break;
+        case GFX_MONO_XOR:
+            for (int i = 0; i < n; i++) {
+                dst[i] ^= (uint8_t)(((uint)(src[i] & valid) << shift) >> rshift);
+            }
+            break;
+    }
+}
+
+void gfx_mono_blit(gfx_mono_t *g, int x, int y, const uint8_t *bitmap, int w, int h, gfx_mono_mode_t mode) {
+    int col0 = x < 0 ? -x : 0;
+    int col1 = w < g->width - x ? w : g->width - x;
+    if (col0 >= col1 || h <= 0) {
+        return;
+    }
+    int n = col1 - col0;
+    // arithmetic shift and mask work for negative y too.
+    int shift = y & 7;
+    int page0 = y >> 3;
+    int pages = gfx_mono_pages(g);
+    int src_pages = (h + 7) >> 3;
+    for (int sp = 0; sp < src_pages; sp++) {
+        int rows = h - sp * 8;
+        uint8_t valid = rows >= 8 ? 0xff : 0xff >> (8 - rows);
+        const uint8_t *src = bitmap + sp * w + col0;
+        int dp = page0 + sp;
+        if (dp >= 0 && dp < pages) {
+            gfx_mono_blit_run(g->buf + dp * g->width + x + col0, src, n, valid, shift, 0, mode);
+        }
+        dp++;
+        if (shift != 0 && dp >= 0 && dp < pages) {
+            gfx_mono_blit_run(g->buf + dp * g->width + x + col0, src, n, valid, shift, 1, mode);
+        }
+    }
+}
+
+// Columns of a RLE bitmap decompressed at once by gfx_mono_draw_bitmap.
+#define GFX_MONO_CHUNK_LEN 32
+
+void gfx_mono_draw_bitmap(gfx_mono_t *g, int x, int y, const gfx_bitmap_t *b, gfx_mono_mode_t mode) {
+    if ((b->flags & GFX_BITMAP_RLE) == 0) {
+        gfx_mono_blit(g, x, y, b->data, b->width, b->height, mode);
+        return;
+    }
+    uint8_t chunk[GFX_MONO_CHUNK_LEN];
+    gfx_bitmap_reader_t r;
+    gfx_bitmap_reader_init(&r, b);
+    for (int page = 0; page * 8 < b->height; page++) {
+        int h = b->height - page * 8;
+        if (h > 8) {
+            h = 8;
+        }
+        for (int col = 0; col < b->width; col += GFX_MONO_CHUNK_LEN) {
+            int n = b->width - col;
+            if (n > GFX_MONO_CHUNK_LEN) {
+                n = GFX_MONO_CHUNK_LEN;
+            }
+            for (int i = 0; i < n; i++) {
+                chunk[i] = gfx_bitmap_reader_next(&r);
+            }
+            gfx_mono_blit(g, x + col, y + page * 8, chunk, n, h, mode);
+        }
+    }
+}
+
+static inline uint8_t gfx_font_index(const gfx_font_t *font, char ch) {
+    uint8_t c = (uint8_t)ch;
+    if (c < font->first || c > font->last) {
+        c = ('?' >= font->first && '?' <= font->last) ? '?' : font->first;
+    }
+    return c - font->first;
+}
+
+int gfx_mono_draw_char(gfx_mono_t *g, int x, int y, const gfx_font_t *font, char ch, gfx_mono_mode_t mode) {
+    uint8_t idx = gfx_font_index(font, ch);
+    int w = font->widths[idx];
+    gfx_mono_blit(g, x, y, font->bitmaps + font->offsets[idx], w, font->height, mode);
+    if (mode == GFX_MONO_COPY && font->spacing > 0) {
+        gfx_mono_fill_rect(g, x + w, y, font->spacing, font->height, false);
+    }
+    return w + font->spacing;
+}
+
+int gfx_mono_draw_string(gfx_mono_t *g, int x, int y, const gfx_font_t *font, const char *str, gfx_mono_mode_t mode) {
+    while (*str && x < g->width) {
+        x += gfx_mono_draw_char(g, x, y, font, *str++, mode);
+    }
+    return x;
+}
+
+int gfx_font_text_width(const gfx_font_t *font, const char *str) {
+    int w = 0;
+    while (*str) {
+        w += font->widths[gfx_font_index(font, *str++)] + font->spacing;
+    }
+    return w;
+}
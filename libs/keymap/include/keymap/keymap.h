@@ -0,0 +1,118 @@
+#pragma once
+
+#include <pico/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Max number of keys of keymap_state_t, to remember actions of pressed keys.
+#ifndef KEYMAP_MAX_KEYS
+    #define KEYMAP_MAX_KEYS 64
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+// keymap_action_t is a kind in the upper byte, and its argument in the lower
+// byte.
+typedef uint16_t keymap_action_t;
+
+enum {
+    KEYMAP_NONE,
+    // a usage of the keyboard page.
+    KEYMAP_KEY,
+    // activates a layer while held.
+    KEYMAP_LAYER_MOMENTARY,
+    // toggles a layer on press.
+    KEYMAP_LAYER_TOGGLE,
+    // an action defined by the program.
+    KEYMAP_USER,
+
+    // a key on tap, a modifier on hold. The modifier (0 to 7 for 0xE0 to
+    // 0xE7) is added to the kind.
+    KEYMAP_MOD_TAP = 0x10,
+    // a key on tap, a layer on hold. The layer (0 to 31) is added to the
+    // kind.
+    KEYMAP_LAYER_TAP = 0x20,
+};
+
+#define KEYMAP_ACTION(kind, arg) ((keymap_action_t)((kind) << 8 | (arg)))
+#define KEYMAP_KIND(action)      ((uint8_t)((action) >> 8))
+#define KEYMAP_ARG(action)       ((uint8_t)((action) & 0xff))
+
+#define KEYMAP_NO_ACTION KEYMAP_ACTION(KEYMAP_NONE, 0)
+
+// keymap_combo_t is an action of keys pressed together.
+typedef struct {
+    uint64_t keys;
+    keymap_action_t action;
+} keymap_combo_t;
+
+typedef struct {
+    float x;
+    float y;
+} keymap_led_pos_t;
+
+// keymap_t is generated by keymap_add() of CMake.
+typedef struct {
+    uint8_t num_layers;
+    uint8_t num_keys;
+    // [num_layers][num_keys] with transparent actions resolved.
+    const keymap_action_t *actions;
+    uint8_t num_combos;
+    const keymap_combo_t *combos;
+} keymap_t;
+
+typedef struct {
+    const keymap_t *map;
+    // bit n is set when layer n is active. Layer 0 is always active.
+    uint32_t layers;
+    // actions of pressed keys, released as pressed even if layers changed.
+    keymap_action_t pressed[KEYMAP_MAX_KEYS];
+} keymap_state_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// keymap_lookup returns the action of a key in the top active layer.
+static inline keymap_action_t keymap_lookup(const keymap_t *map, uint32_t layers, uint index) {
+    uint layer = 31 - __builtin_clz(layers | 1);
+    return map->actions[layer * map->num_keys + index];
+}
+
+// keymap_is_tap_hold returns true for actions which differ on tap and hold.
+static inline bool keymap_is_tap_hold(keymap_action_t a) {
+    return KEYMAP_KIND(a) >= KEYMAP_MOD_TAP && KEYMAP_KIND(a) < KEYMAP_LAYER_TAP + 32;
+}
+
+// keymap_tap_action returns the action of a tap-hold action on tap.
+static inline keymap_action_t keymap_tap_action(keymap_action_t a) {
+    return KEYMAP_ACTION(KEYMAP_KEY, KEYMAP_ARG(a));
+}
+
+// keymap_hold_action returns the action of a tap-hold action on hold.
+static inline keymap_action_t keymap_hold_action(keymap_action_t a) {
+    uint8_t kind = KEYMAP_KIND(a);
+    if (kind >= KEYMAP_LAYER_TAP) {
+        return KEYMAP_ACTION(KEYMAP_LAYER_MOMENTARY, kind - KEYMAP_LAYER_TAP);
+    }
+    return KEYMAP_ACTION(KEYMAP_KEY, 0xE0 + kind - KEYMAP_MOD_TAP);
+}
+
+void keymap_init(keymap_state_t *s, const keymap_t *map);
+
+// keymap_apply updates active layers by an action of a key.
+void keymap_apply(keymap_state_t *s, keymap_action_t a, bool on);
+
+// keymap_event resolves a key change to an action, and applies layer actions.
+// Releases return the action resolved on the press. Keys out of the map
+// return KEYMAP_NONE. Tap-hold actions and combos need keymap_resolver_t.
+keymap_action_t keymap_event(keymap_state_t *s, uint index, bool on);
+
+#ifdef __cplusplus
+}
+#endif
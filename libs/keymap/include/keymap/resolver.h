@@ -0,0 +1,100 @@
+#pragma once
+
+#include <pico/types.h>
+
+#include "keymap/keymap.h"
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Tap-hold keys held longer than this are held.
+#ifndef KEYMAP_TAPPING_TERM_US
+    #define KEYMAP_TAPPING_TERM_US (200 * 1000)
+#endif
+
+// Keys of a combo must be pressed within this from the first one.
+#ifndef KEYMAP_COMBO_TERM_US
+    #define KEYMAP_COMBO_TERM_US (30 * 1000)
+#endif
+
+// Max number of events held back while undecided.
+#ifndef KEYMAP_RESOLVER_QUEUE_LEN
+    #define KEYMAP_RESOLVER_QUEUE_LEN 16
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+typedef struct keymap_resolver_s keymap_resolver_t;
+
+// keymap_resolver_emit_cb receives resolved actions in order. when is the
+// time of the switch event which caused it. Layer actions are applied already.
+typedef void (*keymap_resolver_emit_cb)(keymap_resolver_t *r, keymap_action_t action, bool on, uint64_t when);
+
+typedef struct {
+    uint8_t  index;
+    bool     on;
+    // the press was checked and is not a combo.
+    bool     no_combo;
+    uint64_t when;
+} keymap_resolver_event_t;
+
+typedef struct {
+    // Events passed through without waiting.
+    uint32_t immediate;
+    // Events held back until a decision, and their latency in microseconds.
+    uint32_t held;
+    uint32_t max_latency;
+    uint64_t sum_latency;
+    // Decisions forced because the queue was full.
+    uint32_t overflows;
+} keymap_resolver_stats_t;
+
+struct keymap_resolver_s {
+    void *user;
+    keymap_resolver_emit_cb emit;
+
+    // Terms in microseconds, set by keymap_resolver_init and may be changed.
+    uint32_t tapping_term;
+    uint32_t combo_term;
+
+    keymap_state_t state;
+
+    keymap_resolver_event_t queue[KEYMAP_RESOLVER_QUEUE_LEN];
+    uint queue_len;
+
+    // Keys of the active combo, and its action until the first release.
+    uint64_t combo_keys;
+    keymap_action_t combo_action;
+
+    keymap_resolver_stats_t stats;
+};
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// keymap_resolver_init initializes a resolver. Set user and emit before this.
+void keymap_resolver_init(keymap_resolver_t *r, const keymap_t *map);
+
+// keymap_resolver_event takes a switch event. Events which are not ambiguous
+// are emitted immediately. A press of a tap-hold key or a key of a combo holds
+// back it and following events, until it is decided by later events or by
+// keymap_resolver_task.
+void keymap_resolver_event(keymap_resolver_t *r, uint index, bool on, uint64_t when);
+
+// keymap_resolver_task decides held events whose terms have passed by now.
+void keymap_resolver_task(keymap_resolver_t *r, uint64_t now);
+
+// keymap_resolver_deadline returns the time keymap_resolver_task should be
+// called at, or UINT64_MAX when nothing is held.
+uint64_t keymap_resolver_deadline(keymap_resolver_t *r);
+
+void keymap_resolver_reset_stats(keymap_resolver_t *r);
+
+#ifdef __cplusplus
+}
+#endif
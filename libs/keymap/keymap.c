@@ -0,0 +1,43 @@
+#include <string.h>
+
+#include "keymap/keymap.h"
+
+void keymap_init(keymap_state_t *s, const keymap_t *map) {
+    s->map = map;
+    s->layers = 1;
+    memset(s->pressed, 0, sizeof(s->pressed));
+}
+
+void keymap_apply(keymap_state_t *s, keymap_action_t a, bool on) {
+    switch (KEYMAP_KIND(a)) {
+        case KEYMAP_LAYER_MOMENTARY:
+            if (on) {
+                s->layers |= 1u << KEYMAP_ARG(a);
+            } else {
+                s->layers &= ~(1u << KEYMAP_ARG(a));
+            }
+            break;
+        case KEYMAP_LAYER_TOGGLE:
+            if (on) {
+                s->layers ^= 1u << KEYMAP_ARG(a);
+            }
+            break;
+    }
+    s->layers |= 1;
+}
+
+keymap_action_t keymap_event(keymap_state_t *s, uint index, bool on) {
+    if (index >= s->map->num_keys || index >= KEYMAP_MAX_KEYS) {
+        return KEYMAP_NO_ACTION;
+    }
+    keymap_action_t a;
+    if (on) {
+        a = keymap_lookup(s->map, s->layers, index);
+        s->pressed[index] = a;
+    } else {
+        a = s->pressed[index];
+        s->pressed[index] = KEYMAP_NO_ACTION;
+    }
+    keymap_apply(s, a, on);
+    return a;
+}
@@ -0,0 +1,30 @@
+# Build time compilation of keymaps.
+#
+#   keymap_add(<target> <name> <keymap.json>)
+#
+# This generates keymap_<name>.c/.h into the binary directory of the target,
+# compiles the .c into the target, and adds the directory to its include
+# path. Sources are regenerated when the keymap or keymapc.py is changed.
+
+find_package(Python3 COMPONENTS Interpreter REQUIRED)
+
+set(KEYMAPC ${CMAKE_CURRENT_LIST_DIR}/keymapc.py CACHE INTERNAL "")
+
+function(keymap_add target name source)
+	set(dir ${CMAKE_CURRENT_BINARY_DIR}/keymaps)
+	set(out_c ${dir}/keymap_${name}.c)
+	set(out_h ${dir}/keymap_${name}.h)
+	get_filename_component(source ${source} ABSOLUTE)
+	add_custom_command(
+		OUTPUT ${out_c} ${out_h}
+		COMMAND ${CMAKE_COMMAND} -E make_directory ${dir}
+		COMMAND Python3::Interpreter ${KEYMAPC} ${name} ${source} ${out_c} ${out_h}
+		DEPENDS ${source} ${KEYMAPC}
+		COMMENT "Generating keymap_${name} from ${source}"
+		VERBATIM
+	)
+	target_sources(${target} PRIVATE ${out_c})
+	target_include_directories(${target} PRIVATE ${dir})
+endfunction()
+
+# vim:set ts=4 sts=4 sw=4 tw=0 noet:
@@ -0,0 +1,329 @@
+#!/usr/bin/env python3
+
+# Compiles a keymap in JSON into C sources at build time.
+#
+# usage:
+#   keymapc.py <NAME> <KEYMAP.json> <OUT.c> <OUT.h>
+#
+# A keymap describes keys and layers:
+#
+#   {
+#     "pins": { "ROW1": 14, "COL1": 4, ... },
+#     "keys": [
+#       { "p0": "ROW1", "p1": "COL1", "led": 0, "x": 0.0, "y": 0.8 },
+#       ...
+#     ],
+#     "layers": [
+#       [ "6", "7", ... ],
+#       [ "F6", "TRNS", ... ]
+#     ],
+#     "combos": [
+#       { "keys": [ 12, 13 ], "action": "ESC" }
+#     ]
+#   }
+#
+# The index of a key in "keys" is its state index of switch_matrix. "p0" and
+# "p1" are pin names in "pins" or GPIO numbers. "led" is the index of the LED
+# under the key, which is placed at ("x", "y"). Keys without "led" have no
+# LED. Each layer has an action per key:
+#
+#   A..Z, 0..9, F1..F24, ENTER, SPACE, LSFT, ...   a key (see KEYS below)
+#   0x04                                           a key by usage
+#   MO(n)                                          layer n while held
+#   TG(n)                                          toggle layer n
+#   USER(n)                                        handled by the program
+#   MT(mod, key)                                   key on tap, mod on hold
+#   LT(n, key)                                     key on tap, layer n on hold
+#   NO                                             nothing
+#   TRNS                                           same as the layer below
+#
+# A combo is an action of keys (indexes in "keys") pressed together. Combo and
+# tap-hold actions are resolved by keymap_resolver_t.
+#
+# Output has switch_matrix states, LED positions, the key to LED mapping and
+# flat [layer][key] action tables. TRNS is resolved here against the layer
+# below, so a key is resolved by one lookup in the top active layer. The
+# header also has KEYMAP_<NAME>_PINS, an initializer of switch_matrix_pin_t[]
+# for switch_matrix_fixed.
+
+import json
+import re
+import sys
+from pathlib import Path
+
+
+def fail(msg):
+    print(f'keymapc: {msg}', file=sys.stderr)
+    sys.exit(1)
+
+
+##############################################################################
+# Actions
+
+# These must match keymap/keymap.h.
+KIND_NONE = 0
+KIND_KEY = 1
+KIND_LAYER_MOMENTARY = 2
+KIND_LAYER_TOGGLE = 3
+KIND_USER = 4
+KIND_MOD_TAP = 0x10
+KIND_LAYER_TAP = 0x20
+
+MAX_LAYERS = 32
+# keymap_combo_t has a 64 bit mask of keys.
+MAX_COMBO_KEYS = 64
+
+KEYS = {
+    'ENTER': 0x28, 'ESC': 0x29, 'BSPC': 0x2A, 'TAB': 0x2B, 'SPACE': 0x2C,
+    'MINUS': 0x2D, 'EQUAL': 0x2E, 'LBRC': 0x2F, 'RBRC': 0x30, 'BSLS': 0x31,
+    'NUHS': 0x32, 'SCLN': 0x33, 'QUOT': 0x34, 'GRV': 0x35, 'COMM': 0x36,
+    'DOT': 0x37, 'SLSH': 0x38, 'CAPS': 0x39,
+    'PSCR': 0x46, 'SCRL': 0x47, 'PAUS': 0x48, 'INS': 0x49, 'HOME': 0x4A,
+    'PGUP': 0x4B, 'DEL': 0x4C, 'END': 0x4D, 'PGDN': 0x4E, 'RGHT': 0x4F,
+    'LEFT': 0x50, 'DOWN': 0x51, 'UP': 0x52, 'NUBS': 0x64, 'APP': 0x65,
+    'LCTL': 0xE0, 'LSFT': 0xE1, 'LALT': 0xE2, 'LGUI': 0xE3,
+    'RCTL': 0xE4, 'RSFT': 0xE5, 'RALT': 0xE6, 'RGUI': 0xE7,
+}
+for i in range(26):
+    KEYS[chr(ord('A') + i)] = 0x04 + i
+for i in range(1, 10):
+    KEYS[str(i)] = 0x1E + i - 1
+KEYS['0'] = 0x27
+for i in range(1, 13):
+    KEYS[f'F{i}'] = 0x3A + i - 1
+for i in range(13, 25):
+    KEYS[f'F{i}'] = 0x68 + i - 13
+
+TRNS = None
+
+
+def parse_action(s, nlayers, where):
+    if not isinstance(s, str):
+        fail(f'{where}: action must be a string: {s!r}')
+    if s == 'TRNS':
+        return TRNS
+    if s == 'NO':
+        return (KIND_NONE, 0)
+    if s in KEYS:
+        return (KIND_KEY, KEYS[s])
+    if re.fullmatch(r'0[xX][0-9a-fA-F]{1,2}', s):
+        return (KIND_KEY, int(s, 16))
+    m = re.fullmatch(r'(MT|LT)\(\s*(\w+)\s*,\s*(\w+)\s*\)', s)
+    if m:
+        key = parse_action(m.group(3), nlayers, where)
+        if key is TRNS or key[0] != KIND_KEY:
+            fail(f'{where}: not a key: {s}')
+        if m.group(1) == 'MT':
+            mod = KEYS.get(m.group(2), -1) - 0xE0
+            if not 0 <= mod < 8:
+                fail(f'{where}: not a modifier: {s}')
+            return (KIND_MOD_TAP + mod, key[1])
+        n = int(m.group(2)) if m.group(2).isdigit() else nlayers
+        if n >= nlayers:
+            fail(f'{where}: no layer {m.group(2)}: {s}')
+        return (KIND_LAYER_TAP + n, key[1])
+    m = re.fullmatch(r'(MO|TG|USER)\((\d+)\)', s)
+    if m:
+        n = int(m.group(2))
+        if m.group(1) == 'USER':
+            if n > 255:
+                fail(f'{where}: user action out of range: {s}')
+            return (KIND_USER, n)
+        if n >= nlayers:
+            fail(f'{where}: no layer {n}: {s}')
+        kind = KIND_LAYER_MOMENTARY if m.group(1) == 'MO' else KIND_LAYER_TOGGLE
+        return (kind, n)
+    fail(f'{where}: unknown action: {s}')
+
+
+##############################################################################
+# Keymap
+
+def parse_pin(pins, v, where):
+    if isinstance(v, int):
+        return v
+    if v not in pins:
+        fail(f'{where}: unknown pin: {v!r}')
+    return pins[v]
+
+
+def load(path):
+    try:
+        km = json.loads(Path(path).read_text())
+    except (OSError, ValueError) as e:
+        fail(f'{path}: {e}')
+    pins = km.get('pins', {})
+    keys = km.get('keys')
+    layers = km.get('layers')
+    if not keys:
+        fail(f'{path}: no keys')
+    if not layers:
+        fail(f'{path}: no layers')
+    if len(layers) > MAX_LAYERS:
+        fail(f'{path}: too many layers: {len(layers)} > {MAX_LAYERS}')
+
+    states = []
+    key_to_led = []
+    leds = {}
+    for i, k in enumerate(keys):
+        where = f'{path}: keys[{i}]'
+        p0 = parse_pin(pins, k.get('p0'), where)
+        p1 = parse_pin(pins, k.get('p1'), where)
+        states.append((p0, p1))
+        led = k.get('led', -1)
+        if led >= 0:
+            if led in leds:
+                fail(f'{where}: LED {led} is used by keys[{leds[led][0]}] too')
+            leds[led] = (i, float(k.get('x', 0)), float(k.get('y', 0)))
+        key_to_led.append(led)
+    if len(keys) > 255:
+        fail(f'{path}: too many keys: {len(keys)}')
+    nleds = max(leds) + 1 if leds else 0
+    for i in range(nleds):
+        if i not in leds:
+            fail(f'{path}: no key has LED {i}')
+    positions = [(leds[i][1], leds[i][2]) for i in range(nleds)]
+
+    tables = []
+    for n, layer in enumerate(layers):
+        if len(layer) != len(keys):
+            fail(f'{path}: layers[{n}] has {len(layer)} actions for {len(keys)} keys')
+        row = []
+        for i, s in enumerate(layer):
+            a = parse_action(s, len(layers), f'{path}: layers[{n}][{i}]')
+            if a is TRNS:
+                a = tables[n - 1][i] if n > 0 else (KIND_NONE, 0)
+            row.append(a)
+        tables.append(row)
+
+    combos = []
+    for n, c in enumerate(km.get('combos', [])):
+        where = f'{path}: combos[{n}]'
+        members = c.get('keys', [])
+        if len(members) < 2:
+            fail(f'{where}: needs 2 keys or more')
+        mask = 0
+        for i in members:
+            if not isinstance(i, int) or not 0 <= i < min(len(keys), MAX_COMBO_KEYS):
+                fail(f'{where}: invalid key: {i!r}')
+            mask |= 1 << i
+        a = parse_action(c.get('action'), len(layers), where)
+        if a is TRNS or KIND_MOD_TAP <= a[0]:
+            fail(f'{where}: invalid action: {c.get("action")}')
+        combos.append((mask, a))
+
+    return states, positions, key_to_led, tables, combos
+
+
+##############################################################################
+# Output
+
+def generate(name, path, states, positions, key_to_led, tables, combos, out_c, out_h):
+    upper = name.upper()
+    h = [
+        '// Generated by keymapc.py from ' + Path(path).name + '. DO NOT EDIT.',
+        '',
+        '#pragma once',
+        '',
+        '#include "driver/switch_matrix.h"',
+        '#include "keymap/keymap.h"',
+        '',
+        f'#define KEYMAP_{upper}_NUM_KEYS   {len(states)}',
+        f'#define KEYMAP_{upper}_NUM_LEDS   {len(positions)}',
+        f'#define KEYMAP_{upper}_NUM_LAYERS {len(tables)}',
+        f'#define KEYMAP_{upper}_NUM_COMBOS {len(combos)}',
+        '',
+        '// { p0, p1 } of each key, to define a constexpr table in C++.',
+        f'#define KEYMAP_{upper}_PINS {{ \\',
+    ]
+    for p0, p1 in states:
+        h.append(f'    {{ {p0}, {p1} }}, \\')
+    h += [
+        '}',
+        '',
+        '#ifdef __cplusplus',
+        'extern "C" {',
+        '#endif',
+        '',
+        f'extern switch_matrix_state_t keymap_{name}_sm_states[KEYMAP_{upper}_NUM_KEYS];',
+        f'extern const keymap_led_pos_t keymap_{name}_led_positions[KEYMAP_{upper}_NUM_LEDS];',
+        f'extern const int8_t keymap_{name}_key_to_led[KEYMAP_{upper}_NUM_KEYS];',
+        f'extern const keymap_t keymap_{name};',
+        '',
+        '#ifdef __cplusplus',
+        '}',
+        '#endif',
+    ]
+    c = [
+        '// Generated by keymapc.py from ' + Path(path).name + '. DO NOT EDIT.',
+        '',
+        f'#include "keymap_{name}.h"',
+        '',
+        '#include "perf/hot.h"',
+        '',
+        f'switch_matrix_state_t keymap_{name}_sm_states[KEYMAP_{upper}_NUM_KEYS] = {{',
+    ]
+    for p0, p1 in states:
+        c.append(f'    {{ {p0}, {p1} }},')
+    c += [
+        '};',
+        '',
+        '// LED tables are read by effects every frame.',
+        f'const keymap_led_pos_t PERF_HOT_DATA(keymap_{name}_led_positions)[KEYMAP_{upper}_NUM_LEDS] = {{',
+    ]
+    for x, y in positions:
+        c.append(f'    {{ {x!r}f, {y!r}f }},')
+    c += [
+        '};',
+        '',
+        f'const int8_t PERF_HOT_DATA(keymap_{name}_key_to_led)[KEYMAP_{upper}_NUM_KEYS] = {{',
+    ]
+    for i in range(0, len(key_to_led), 8):
+        c.append('    ' + ' '.join(f'{v:3d},' for v in key_to_led[i:i+8]))
+    c += [
+        '};',
+        '',
+        f'static const keymap_action_t actions[KEYMAP_{upper}_NUM_LAYERS][KEYMAP_{upper}_NUM_KEYS] = {{',
+    ]
+    for n, row in enumerate(tables):
+        c.append(f'    // layer {n}')
+        c.append('    {')
+        for i in range(0, len(row), 8):
+            c.append('        ' + ' '.join(f'0x{kind << 8 | arg:04x},' for kind, arg in row[i:i+8]))
+        c.append('    },')
+    c += [
+        '};',
+        '',
+    ]
+    if combos:
+        c.append(f'static const keymap_combo_t combos[KEYMAP_{upper}_NUM_COMBOS] = {{')
+        for mask, (kind, arg) in combos:
+            c.append(f'    {{ 0x{mask:016x}ull, 0x{kind << 8 | arg:04x} }},')
+        c += [
+            '};',
+            '',
+        ]
+    c += [
+        f'const keymap_t keymap_{name} = {{',
+        f'    .num_layers = KEYMAP_{upper}_NUM_LAYERS,',
+        f'    .num_keys   = KEYMAP_{upper}_NUM_KEYS,',
+        f'    .actions    = &actions[0][0],',
+        f'    .num_combos = KEYMAP_{upper}_NUM_COMBOS,',
+        f'    .combos     = {"combos" if combos else "NULL"},',
+        '};',
+    ]
+    Path(out_h).write_text('\n'.join(h) + '\n')
+    Path(out_c).write_text('\n'.join(c) + '\n')
+
+
+def main(argv):
+    if len(argv) != 5:
+        fail('usage: keymapc.py <NAME> <KEYMAP.json> <OUT.c> <OUT.h>')
+    name, path, out_c, out_h = argv[1:]
+    if not re.fullmatch(r'[A-Za-z_][A-Za-z0-9_]*', name):
+        fail(f'invalid name: {name!r}')
+    generate(name, path, *load(path), out_c, out_h)
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,248 @@
+#include <string.h>
+
+#include "keymap/resolver.h"
+
+// Only a press of a tap-hold key or a key of a combo is ambiguous. It is held
+// back with all events after it in a queue, and decided by timestamps of the
+// events, not by when they are processed:
+//
+//  - a combo when all of its keys are pressed within the combo term, before
+//    any other key or release. A larger combo is waited for until the term.
+//  - a tap when the key is released within the tapping term.
+//  - a hold when the tapping term passed, or another key was pressed and
+//    released within it (permissive hold).
+//
+// Once the head is decided, events after it are replayed in order with layers
+// the decision made, until another ambiguous press.
+
+_Static_assert(KEYMAP_MAX_KEYS <= 64, "keymap_combo_t has 64 bits of keys");
+
+typedef enum {
+    KEYMAP_UNDECIDED,
+    KEYMAP_NOT_COMBO,
+    KEYMAP_COMBO,
+    KEYMAP_TAP,
+    KEYMAP_HOLD,
+} keymap_decision_t;
+
+void keymap_resolver_init(keymap_resolver_t *r, const keymap_t *map) {
+    keymap_init(&r->state, map);
+    r->tapping_term = KEYMAP_TAPPING_TERM_US;
+    r->combo_term = KEYMAP_COMBO_TERM_US;
+    r->queue_len = 0;
+    r->combo_keys = 0;
+    r->combo_action = KEYMAP_NO_ACTION;
+    keymap_resolver_reset_stats(r);
+}
+
+void keymap_resolver_reset_stats(keymap_resolver_t *r) {
+    memset(&r->stats, 0, sizeof(r->stats));
+}
+
+static inline uint64_t keymap_bit(uint index) {
+    return 1ull << index;
+}
+
+static void keymap_resolver_emit(keymap_resolver_t *r, keymap_action_t a, bool on, uint64_t when) {
+    if (a != KEYMAP_NO_ACTION && r->emit != NULL) {
+        r->emit(r, a, on, when);
+    }
+}
+
+static void keymap_resolver_press(keymap_resolver_t *r, uint index, keymap_action_t a, uint64_t when) {
+    r->state.pressed[index] = a;
+    keymap_apply(&r->state, a, true);
+    keymap_resolver_emit(r, a, true, when);
+}
+
+static void keymap_resolver_release(keymap_resolver_t *r, uint index, uint64_t when) {
+    if (r->combo_keys & keymap_bit(index)) {
+        // the first release of keys ends the combo.
+        r->combo_keys &= ~keymap_bit(index);
+        if (r->combo_action != KEYMAP_NO_ACTION) {
+            keymap_apply(&r->state, r->combo_action, false);
+            keymap_resolver_emit(r, r->combo_action, false, when);
+            r->combo_action = KEYMAP_NO_ACTION;
+        }
+        return;
+    }
+    keymap_action_t a = r->state.pressed[index];
+    r->state.pressed[index] = KEYMAP_NO_ACTION;
+    keymap_apply(&r->state, a, false);
+    keymap_resolver_emit(r, a, false, when);
+}
+
+static bool keymap_resolver_in_combo(keymap_resolver_t *r, uint index) {
+    const keymap_t *map = r->state.map;
+    for (uint i = 0; i < map->num_combos; i++) {
+        if (map->combos[i].keys & keymap_bit(index)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool keymap_resolver_may_combo(keymap_resolver_t *r, const keymap_resolver_event_t *e) {
+    return !e->no_combo && keymap_resolver_in_combo(r, e->index);
+}
+
+static bool keymap_resolver_ambiguous(keymap_resolver_t *r, const keymap_resolver_event_t *e) {
+    if (!e->on) {
+        return false;
+    }
+    return keymap_resolver_may_combo(r, e) ||
+        keymap_is_tap_hold(keymap_lookup(r->state.map, r->state.layers, e->index));
+}
+
+// keymap_resolver_decide_combo decides whether the head starts a combo, and
+// returns it with the number of its presses in the queue.
+static keymap_decision_t keymap_resolver_decide_combo(keymap_resolver_t *r, uint64_t now, const keymap_combo_t **combo, uint *n) {
+    const keymap_t *map = r->state.map;
+    uint64_t deadline = r->queue[0].when + r->combo_term;
+    bool closed = now >= deadline;
+    uint64_t keys = 0;
+    *n = 0;
+    for (uint i = 0; i < r->queue_len; i++) {
+        const keymap_resolver_event_t *e = &r->queue[i];
+        if (e->when >= deadline || !e->on || !keymap_resolver_in_combo(r, e->index)) {
+            closed = true;
+            break;
+        }
+        keys |= keymap_bit(e->index);
+        *n = i + 1;
+    }
+    const keymap_combo_t *match = NULL;
+    bool larger = false;
+    for (uint i = 0; i < map->num_combos; i++) {
+        const keymap_combo_t *c = &map->combos[i];
+        if (c->keys == keys) {
+            match = c;
+        } else if ((c->keys & keys) == keys) {
+            larger = true;
+        }
+    }
+    if (match != NULL && (closed || !larger)) {
+        *combo = match;
+        return KEYMAP_COMBO;
+    }
+    if (!closed && (match != NULL || larger)) {
+        return KEYMAP_UNDECIDED;
+    }
+    return KEYMAP_NOT_COMBO;
+}
+
+static keymap_decision_t keymap_resolver_decide_tap_hold(keymap_resolver_t *r, uint64_t now) {
+    const keymap_resolver_event_t *head = &r->queue[0];
+    uint64_t deadline = head->when + r->tapping_term;
+    uint64_t down = 0;
+    for (uint i = 1; i < r->queue_len; i++) {
+        const keymap_resolver_event_t *e = &r->queue[i];
+        if (e->when >= deadline) {
+            return KEYMAP_HOLD;
+        }
+        if (e->index == head->index) {
+            return KEYMAP_TAP;
+        }
+        if (e->on) {
+            down |= keymap_bit(e->index);
+        } else if (down & keymap_bit(e->index)) {
+            return KEYMAP_HOLD;
+        }
+    }
+    return now >= deadline ? KEYMAP_HOLD : KEYMAP_UNDECIDED;
+}
+
+static void keymap_resolver_pop(keymap_resolver_t *r, uint n, uint64_t now) {
+    for (uint i = 0; i < n; i++) {
+        uint64_t when = r->queue[i].when;
+        uint32_t latency = now > when ? (uint32_t)(now - when) : 0;
+        if (latency > r->stats.max_latency) {
+            r->stats.max_latency = latency;
+        }
+        r->stats.held++;
+        r->stats.sum_latency += latency;
+    }
+    r->queue_len -= n;
+    memmove(&r->queue[0], &r->queue[n], r->queue_len * sizeof(r->queue[0]));
+}
+
+static void keymap_resolver_resolve(keymap_resolver_t *r, uint64_t now) {
+    while (r->queue_len > 0) {
+        keymap_resolver_event_t *head = &r->queue[0];
+        if (!keymap_resolver_ambiguous(r, head)) {
+            if (head->on) {
+                keymap_resolver_press(r, head->index, keymap_lookup(r->state.map, r->state.layers, head->index), head->when);
+            } else {
+                keymap_resolver_release(r, head->index, head->when);
+            }
+            keymap_resolver_pop(r, 1, now);
+            continue;
+        }
+        if (keymap_resolver_may_combo(r, head)) {
+            const keymap_combo_t *c;
+            uint n;
+            keymap_decision_t d = keymap_resolver_decide_combo(r, now, &c, &n);
+            if (d == KEYMAP_UNDECIDED) {
+                break;
+            }
+            if (d == KEYMAP_COMBO) {
+                r->combo_keys |= c->keys;
+                r->combo_action = c->action;
+                keymap_apply(&r->state, c->action, true);
+                keymap_resolver_emit(r, c->action, true, r->queue[n - 1].when);
+                keymap_resolver_pop(r, n, now);
+                continue;
+            }
+            // check it again as a tap-hold key or a normal key.
+            head->no_combo = true;
+            continue;
+        }
+        keymap_decision_t d = keymap_resolver_decide_tap_hold(r, now);
+        if (d == KEYMAP_UNDECIDED) {
+            break;
+        }
+        keymap_action_t a = keymap_lookup(r->state.map, r->state.layers, head->index);
+        a = d == KEYMAP_TAP ? keymap_tap_action(a) : keymap_hold_action(a);
+        keymap_resolver_press(r, head->index, a, head->when);
+        keymap_resolver_pop(r, 1, now);
+    }
+}
+
+void keymap_resolver_event(keymap_resolver_t *r, uint index, bool on, uint64_t when) {
+    if (index >= r->state.map->num_keys || index >= KEYMAP_MAX_KEYS) {
+        return;
+    }
+    keymap_resolver_event_t e = { .index = index, .on = on, .when = when };
+    if (r->queue_len == 0 && !keymap_resolver_ambiguous(r, &e)) {
+        r->stats.immediate++;
+        if (on) {
+            keymap_resolver_press(r, index, keymap_lookup(r->state.map, r->state.layers, index), when);
+        } else {
+            keymap_resolver_release(r, index, when);
+        }
+        return;
+    }
+    if (r->queue_len == KEYMAP_RESOLVER_QUEUE_LEN) {
+        // decide the head as if its terms have passed.
+        r->stats.overflows++;
+        uint32_t term = r->tapping_term > r->combo_term ? r->tapping_term : r->combo_term;
+        keymap_resolver_resolve(r, r->queue[0].when + term);
+    }
+    r->queue[r->queue_len++] = e;
+    keymap_resolver_resolve(r, when);
+}
+
+void keymap_resolver_task(keymap_resolver_t *r, uint64_t now) {
+    keymap_resolver_resolve(r, now);
+}
+
+uint64_t keymap_resolver_deadline(keymap_resolver_t *r) {
+    if (r->queue_len == 0) {
+        return UINT64_MAX;
+    }
+    const keymap_resolver_event_t *head = &r->queue[0];
+    if (keymap_resolver_may_combo(r, head)) {
+        return head->when + r->combo_term;
+    }
+    return head->when + r->tapping_term;
+}
@@ -0,0 +1,23 @@
+#include "led/effect.h"
+#include "led/math.h"
+
+#include "pico/stdlib.h"
+
+#include "perf/hot.h"
+
+void PERF_HOT_FUNC(led_effect_white)(void *data, int idx, ws2812_color_t *c, const led_pos_t *pos, uint64_t now) {
+    led_matrix_add_color(c, 255, 255, 255);
+}
+
+void PERF_HOT_FUNC(led_effect_vertical_rainbow)(void *data, int idx, ws2812_color_t *c, const led_pos_t *pos, uint64_t now) {
+    ws2812_color_t rgb = led_math_rainbow(pos->x, now);
+    led_matrix_add_color(c, rgb.r, rgb.g, rgb.b);
+}
+
+void PERF_HOT_FUNC(led_effect_push)(void *data, int idx, ws2812_color_t *c, const led_pos_t *pos, uint64_t now) {
+    led_effect_push_t *p = (led_effect_push_t *)data;
+    uint8_t v = led_math_push(pos, &led_matrix_positions[p->led_index], now - p->start);
+    if (v > 0) {
+        led_matrix_add_color(c, v, v, v);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <pico/types.h>
+
+#include "led/matrix.h"
+
+// Effects are color providers of led_matrix (led_matrix_provider_add). Their
+// math is in led/math.h, in float or fixed point by the platform.
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+// led_effect_push_t is the data of led_effect_push, a ring spreading from
+// a LED and fading out in a second.
+typedef struct {
+    int led_index;
+    uint64_t start;
+} led_effect_push_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// led_effect_white lights all LEDs in white. data is not used.
+void led_effect_white(void *data, int idx, ws2812_color_t *c, const led_pos_t *pos, uint64_t now);
+
+// led_effect_vertical_rainbow scrolls a rainbow horizontally, which cycles in
+// about 4 seconds. data is not used.
+void led_effect_vertical_rainbow(void *data, int idx, ws2812_color_t *c, const led_pos_t *pos, uint64_t now);
+
+// led_effect_push takes a led_effect_push_t as data.
+void led_effect_push(void *data, int idx, ws2812_color_t *c, const led_pos_t *pos, uint64_t now);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,185 @@
+#pragma once
+
+#include <math.h>
+
+#include <pico/types.h>
+
+#include "led/matrix.h"
+
+// Math of effects, in two implementations of the same results:
+//
+//  - float runs on the FPU of the Cortex-M33 of RP2350. It takes single
+//    precision only, as double would run in software there.
+//  - fixed runs on integers in Q16 and Q12, for the Cortex-M0+ of RP2040 (and
+//    Hazard3 of RP2350), which has no FPU and would call soft-float for each
+//    operation. Divisions go to the hardware divider of the SIO.
+//
+// led_math_rainbow and led_math_push are the ones for the platform, and the
+// others are compiled only where called, as host tests compare them.
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+#ifndef LED_MATH_FIXED
+    #if PICO_RP2040 || PICO_RISCV
+        #define LED_MATH_FIXED 1
+    #else
+        #define LED_MATH_FIXED 0
+    #endif
+#endif
+
+// The rainbow cycles by 2^22 microseconds.
+#define LED_MATH_RAINBOW_MASK   ((1u << 22) - 1)
+
+// The push lights LEDs within 0.7 from the center, as its level is below
+// 1/256 beyond.
+#define LED_MATH_PUSH_RADIUS    0.7f
+#define LED_MATH_PUSH_DURATION  1000000
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+// led_math_hue returns the color of a hue of 6 sectors, v being the position
+// in the sector.
+static inline ws2812_color_t led_math_hue(uint sector, uint8_t v) {
+    const uint8_t L = 255;
+    uint8_t L_v = L - v;
+    switch (sector) {
+        case 0: return (ws2812_color_t){ .r = L,   .g = v,   .b = 0   };
+        case 1: return (ws2812_color_t){ .r = L_v, .g = L,   .b = 0   };
+        case 2: return (ws2812_color_t){ .r = 0,   .g = L,   .b = v   };
+        case 3: return (ws2812_color_t){ .r = 0,   .g = L_v, .b = L   };
+        case 4: return (ws2812_color_t){ .r = v,   .g = 0,   .b = L   };
+        default: return (ws2812_color_t){ .r = L,  .g = 0,   .b = L_v };
+    }
+}
+
+// led_math_rainbow_float returns the color of the rainbow at x, which
+// scrolls by 8 per cycle. x must not be negative.
+static inline ws2812_color_t led_math_rainbow_float(float x, uint64_t now) {
+    float frac = (float)(uint32_t)(now & LED_MATH_RAINBOW_MASK) * (1.0f / LED_MATH_RAINBOW_MASK);
+    float phase = frac + x * 0.125f;
+    phase -= (int)phase;
+    float hue = phase * 6.0f;
+    uint sector = (uint)hue;
+    return led_math_hue(sector, (uint8_t)((hue - sector) * 255.0f));
+}
+
+// led_math_push_float returns the level of the push at pos from center,
+// elapsed microseconds after it started. The level is
+// powf(powf(0.2, r / 0.2), 1 / (1 - t)), approximated on bits of floats: a
+// float read as an integer is about 2^23 * (log2(x) + 127), so powers are
+// products of it.
+static inline uint8_t led_math_push_float(const led_pos_t *pos, const led_pos_t *center, uint64_t elapsed) {
+    float dx = pos->x - center->x;
+    float dy = pos->y - center->y;
+    float r2 = dx * dx + dy * dy;
+    if (r2 > LED_MATH_PUSH_RADIUS * LED_MATH_PUSH_RADIUS) {
+        return 0;
+    }
+    float r = sqrtf(r2);
+    if (r < 2e-8f) {
+        return 255;
+    }
+    float t = (float)(uint32_t)(elapsed < LED_MATH_PUSH_DURATION ? elapsed : LED_MATH_PUSH_DURATION) * 1e-6f;
+    float denom = 1.0f - t;
+    if (denom < 1e-7f) {
+        denom = 1e-7f;
+    }
+    union { float f; int32_t i; } u;
+    // powf(0.2, r / 0.2)
+    u.i = (int32_t)((1 << 23) * (r * (5.0f * -2.321928f) + 126.942695f));
+    // powf(x, 1 / denom), levels below 1/256 being 0.
+    float i = (float)(u.i - 0x3f7a3bea) / denom + (float)0x3f7a3bea;
+    if (i < (float)0x3b800000) {
+        return 0;
+    }
+    u.i = (int32_t)i;
+    return (uint8_t)(255.0f * u.f);
+}
+
+// led_math_q16 converts x to Q16 by bits of it, without soft-float. It
+// truncates toward zero as a cast does, and saturates beyond 32767.
+static inline int32_t led_math_q16(float x) {
+    union { float f; uint32_t u; } b = { .f = x };
+    // The mantissa is Q23 by the exponent.
+    int shift = (int)((b.u >> 23) & 0xff) - 127 - 7;
+    uint32_t m = (b.u & 0x7fffff) | 0x800000;
+    int32_t q;
+    if (shift >= 8) {
+        q = INT32_MAX;
+    } else if (shift >= 0) {
+        q = (int32_t)(m << shift);
+    } else if (shift > -24) {
+        q = (int32_t)(m >> -shift);
+    } else {
+        q = 0;
+    }
+    return (b.u >> 31) ? -q : q;
+}
+
+// led_math_isqrt returns the square root of x, bit by bit.
+static inline uint32_t led_math_isqrt(uint32_t x) {
+    uint32_t r = 0;
+    for (uint32_t bit = 1u << 30; bit != 0; bit >>= 2) {
+        if (x >= r + bit) {
+            x -= r + bit;
+            r = (r >> 1) + bit;
+        } else {
+            r >>= 1;
+        }
+    }
+    return r;
+}
+
+// led_math_rainbow_fixed is led_math_rainbow_float in Q16. The phase wraps
+// in 16 bits, which is the fraction.
+static inline ws2812_color_t led_math_rainbow_fixed(float x, uint64_t now) {
+    uint32_t frac = (uint32_t)(now & LED_MATH_RAINBOW_MASK) >> 6;
+    uint32_t phase = (frac + (uint32_t)(led_math_q16(x) >> 3)) & 0xffff;
+    uint32_t hue = phase * 6;
+    return led_math_hue(hue >> 16, (uint8_t)(((hue & 0xffff) * 255) >> 16));
+}
+
+// led_math_push_fixed is led_math_push_float in log2 of Q12: the level is
+// 2^-l, taken as 2^floor(-l) * (1 + fract(-l)) as the bits of a float are.
+static inline uint8_t led_math_push_fixed(const led_pos_t *pos, const led_pos_t *center, uint64_t elapsed) {
+    const int32_t radius = (int32_t)(LED_MATH_PUSH_RADIUS * 65536);
+    int32_t x = led_math_q16(pos->x) - led_math_q16(center->x);
+    int32_t y = led_math_q16(pos->y) - led_math_q16(center->y);
+    // Squares of ones within the radius fit in 32 bits.
+    if (x < -radius || x > radius || y < -radius || y > radius) {
+        return 0;
+    }
+    uint32_t r2 = (uint32_t)(x * x) + (uint32_t)(y * y);
+    if (r2 > (uint32_t)radius * (uint32_t)radius) {
+        return 0;
+    }
+    if (r2 == 0) {
+        return 255;
+    }
+    uint32_t r = led_math_isqrt(r2);
+    // 1 - t in 16 microseconds, at least one.
+    uint32_t rest = (LED_MATH_PUSH_DURATION - (uint32_t)(elapsed < LED_MATH_PUSH_DURATION ? elapsed : LED_MATH_PUSH_DURATION)) >> 4;
+    if (rest == 0) {
+        rest = 1;
+    }
+    // -log2(powf(0.2, r / 0.2)) is 11.60964 * r, and 50 and 185 are offsets
+    // of the approximation.
+    uint32_t a = ((r * 47553u) >> 16) + 50;
+    uint32_t l = a * (LED_MATH_PUSH_DURATION >> 4) / rest + 185;
+    if (l >= 8 << 12) {
+        return 0;
+    }
+    uint32_t n = (l + 4095) >> 12;
+    uint32_t fract = (n << 12) - l;
+    return (uint8_t)((255 * (4096 + fract)) >> (12 + n));
+}
+
+#if LED_MATH_FIXED
+    #define led_math_rainbow    led_math_rainbow_fixed
+    #define led_math_push       led_math_push_fixed
+#else
+    #define led_math_rainbow    led_math_rainbow_float
+    #define led_math_push       led_math_push_float
+#endif
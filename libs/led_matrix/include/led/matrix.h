@@ -0,0 +1,74 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Max number of color providers. Each LED takes the brightest of all.
+#ifndef LED_MATRIX_PROVIDERS_MAX
+    #define LED_MATRIX_PROVIDERS_MAX 30
+#endif
+
+// Interval of frames in microseconds.
+#ifndef LED_MATRIX_INTERVAL_US
+    #define LED_MATRIX_INTERVAL_US 10000
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+#include <pico/types.h>
+
+#include "driver/ws2812_array.h"
+#include "keymap/keymap.h"
+
+typedef keymap_led_pos_t led_pos_t;
+
+// led_matrix_get_color_cb adds the color of an effect for LED idx at pos to
+// c, by led_matrix_add_color.
+typedef void (*led_matrix_get_color_cb)(void *data, int idx, ws2812_color_t *c, const led_pos_t *pos, uint64_t now);
+
+typedef struct {
+    led_matrix_get_color_cb     fn;
+    void                        *data;
+} led_matrix_get_color_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Variables
+
+// Positions of LEDs, set by led_matrix_init.
+extern const led_pos_t *led_matrix_positions;
+extern int led_matrix_num;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// led_matrix_init sets positions of num LEDs, generated by keymap_add() as
+// keymap_<name>_led_positions. num must not exceed WS2812_ARRAY_NUM.
+void led_matrix_init(const led_pos_t *positions, int num);
+
+// led_matrix_task renders a frame to ws2812_array_states every
+// LED_MATRIX_INTERVAL_US.
+void led_matrix_task(uint64_t now);
+
+// led_matrix_render renders a frame now, for a scheduler which runs it every
+// frame.
+void led_matrix_render(uint64_t now);
+
+// Color providers are effects rendered in each frame. led_matrix_provider_add
+// returns the index of the added provider, or -1 when full, and
+// led_matrix_provider_has returns the index of the provider or -1.
+int led_matrix_provider_has(led_matrix_get_color_cb fn, void *data);
+int led_matrix_provider_add(led_matrix_get_color_cb fn, void *data);
+void led_matrix_provider_remove(int i);
+
+// led_matrix_add_color blends a color into c, taking the brighter of each
+// channel.
+void led_matrix_add_color(ws2812_color_t *c, uint8_t r, uint8_t g, uint8_t b);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,79 @@
+#include <string.h>
+
+#include "led/matrix.h"
+
+#include "pico/stdlib.h"
+
+#include "perf/hot.h"
+#include "perf/probe.h"
+
+PERF_PROBE_DEFINE(led_matrix_render);
+
+const led_pos_t *led_matrix_positions = NULL;
+int led_matrix_num = 0;
+
+static led_matrix_get_color_t providers[LED_MATRIX_PROVIDERS_MAX] = {0};
+
+void led_matrix_init(const led_pos_t *positions, int num) {
+    led_matrix_positions = positions;
+    led_matrix_num = MIN(num, WS2812_ARRAY_NUM);
+}
+
+static void PERF_HOT_FUNC(led_matrix_get_color_call)(led_matrix_get_color_t *getter, int idx, ws2812_color_t *c, const led_pos_t *pos, uint64_t now) {
+    if (getter->fn != NULL) {
+        getter->fn(getter->data, idx, c, pos, now);
+    }
+}
+
+void PERF_HOT_FUNC(led_matrix_render)(uint64_t now) {
+    PERF_PROBE_SCOPE(led_matrix_render);
+    ws2812_array_dirty = true;
+    memset(ws2812_array_states, 0, sizeof(ws2812_array_states));
+    for (int i = 0; i < led_matrix_num; i++) {
+        for (int j = 0; j < LED_MATRIX_PROVIDERS_MAX; j++) {
+            led_matrix_get_color_call(&providers[j], i, &ws2812_array_states[i].rgb, &led_matrix_positions[i], now);
+        }
+    }
+}
+
+void PERF_HOT_FUNC(led_matrix_task)(uint64_t now) {
+    static uint64_t last = 0;
+    if (now - last < LED_MATRIX_INTERVAL_US) {
+        return;
+    }
+    last = now;
+    led_matrix_render(now);
+}
+
+int led_matrix_provider_has(led_matrix_get_color_cb fn, void *data) {
+    for (int i = 0; i < LED_MATRIX_PROVIDERS_MAX; i++) {
+        if (providers[i].fn == fn && providers[i].data == data) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int led_matrix_provider_add(led_matrix_get_color_cb fn, void *data) {
+    for (int i = 0; i < LED_MATRIX_PROVIDERS_MAX; i++) {
+        if (providers[i].fn == NULL) {
+            providers[i].fn   = fn;
+            providers[i].data = data;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void led_matrix_provider_remove(int i) {
+    if (i >= 0 && i < LED_MATRIX_PROVIDERS_MAX) {
+        providers[i].fn   = NULL;
+        providers[i].data = NULL;
+    }
+}
+
+void PERF_HOT_FUNC(led_matrix_add_color)(ws2812_color_t *c, uint8_t r, uint8_t g, uint8_t b) {
+    c->r = MAX(c->r, r);
+    c->g = MAX(c->g, g);
+    c->b = MAX(c->b, b);
+}
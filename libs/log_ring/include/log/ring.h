@@ -0,0 +1,104 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Number of records in the ring. Must be a power of 2. A record is 32 bytes,
+// and takes 2.8ms to be sent at 115200 baud.
+#ifndef LOG_RING_LEN
+    #define LOG_RING_LEN 128
+#endif
+
+// Max number of 32-bit arguments of a record.
+#define LOG_RING_MAX_ARGS 5
+
+// First byte of a record, which the decoder synchronizes to.
+#define LOG_RING_SYNC 0xA5
+
+// Set in len of a record which has bytes of text in args instead of a format.
+#define LOG_RING_TEXT 0x80
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+#include <pico/types.h>
+
+// A record is sent as is, in little endian. fmt is the address of the format
+// string in the program, which the decoder reads from the ELF file.
+typedef struct {
+    uint8_t  sync;
+    // number of arguments, or LOG_RING_TEXT | number of bytes of text.
+    uint8_t  len;
+    // incremented for each record, including dropped ones.
+    uint16_t seq;
+    uint32_t fmt;
+    // time_us_32() when written.
+    uint32_t time;
+    uint32_t args[LOG_RING_MAX_ARGS];
+} log_ring_record_t;
+
+typedef struct {
+    uint32_t written;
+    uint32_t dropped;
+} log_ring_stats_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// log_ring_init sets up the default UART and a DMA channel to send records,
+// and installs a stdio driver, which writes text to the ring and reads the
+// UART. Disable stdio_uart of the program (pico_enable_stdio_uart 0).
+void log_ring_init(void);
+
+// log_ring_write copies a record to the ring, and starts DMA if it is idle.
+// It never blocks: when the ring is full the record is dropped and counted.
+// Use LOG_RING instead.
+void log_ring_write(const char *fmt, uint n, const uint32_t *args);
+
+// log_ring_text writes bytes as text records.
+void log_ring_text(const char *buf, uint len);
+
+// log_ring_space returns the number of records which can be written now.
+uint log_ring_space(void);
+
+const log_ring_stats_t *log_ring_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Macros
+
+// LOG_RING writes a record of a printf format and up to LOG_RING_MAX_ARGS
+// arguments. Arguments are cast to 32 bits and formatted by the decoder, so
+// fmt must be a string literal and %s takes only constant strings. Pass
+// 64-bit values by LOG_RING_U64 for %llu and such.
+//
+//     LOG_RING("sm: %u %s at %llu\n", index, on ? "ON" : "OFF", LOG_RING_U64(when));
+#define LOG_RING(fmt, ...) \
+    LOG_RING_WRITE_(fmt, LOG_RING_NARGS_(__VA_ARGS__), __VA_ARGS__)
+
+// LOG_RING_U64 splits a 64-bit value into 2 arguments.
+#define LOG_RING_U64(v) (uint32_t)(v), (uint32_t)((uint64_t)(v) >> 32)
+
+#define LOG_RING_NARGS_(...) LOG_RING_NARGS_N_(_, ##__VA_ARGS__, 5, 4, 3, 2, 1, 0)
+#define LOG_RING_NARGS_N_(_, a1, a2, a3, a4, a5, n, ...) n
+
+#define LOG_RING_CAT_(a, b) a##b
+#define LOG_RING_XCAT_(a, b) LOG_RING_CAT_(a, b)
+
+#define LOG_RING_WRITE_(fmt, n, ...) \
+    log_ring_write(fmt, n, (const uint32_t[LOG_RING_MAX_ARGS]){ LOG_RING_XCAT_(LOG_RING_ARGS_, n)(__VA_ARGS__) })
+
+#define LOG_RING_ARG_(a) (uint32_t)(uintptr_t)(a)
+#define LOG_RING_ARGS_0(...) 0
+#define LOG_RING_ARGS_1(a) LOG_RING_ARG_(a)
+#define LOG_RING_ARGS_2(a, b) LOG_RING_ARG_(a), LOG_RING_ARG_(b)
+#define LOG_RING_ARGS_3(a, b, c) LOG_RING_ARGS_2(a, b), LOG_RING_ARG_(c)
+#define LOG_RING_ARGS_4(a, b, c, d) LOG_RING_ARGS_3(a, b, c), LOG_RING_ARG_(d)
+#define LOG_RING_ARGS_5(a, b, c, d, e) LOG_RING_ARGS_4(a, b, c, d), LOG_RING_ARG_(e)
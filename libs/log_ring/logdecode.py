@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+
+# Decodes records of log_ring into text.
+#
+# usage:
+#   logdecode.py [-t] <PROGRAM.elf> [INPUT]
+#
+# INPUT is a file or a serial port which is set up already, for example:
+#
+#   $ stty -F /dev/ttyACM0 115200 raw
+#   $ ./libs/log_ring/logdecode.py build/rp2040/tests/testfirm/testfirm.elf /dev/ttyACM0
+#
+# It reads stdin without INPUT. -t prefixes lines with the time of records in
+# seconds.
+#
+# A record is 32 bytes (see log_ring_record_t). The format of a record is read
+# from the ELF file at its address, so the ELF file must be of the program
+# running. Bytes out of records are skipped until the next sync byte. Records
+# dropped by the program are counted from gaps of sequence numbers.
+
+import re
+import struct
+import sys
+
+SYNC = 0xA5
+TEXT = 0x80
+MAX_ARGS = 5
+RECORD = struct.Struct('<BBHII5I')
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+SPEC = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diouxXcsp%])')
+
+
+def fail(msg):
+    print(f'logdecode: {msg}', file=sys.stderr)
+    sys.exit(1)
+
+
+class Elf:
+    """Loaded sections of an ELF file, to read strings at addresses."""
+
+    def __init__(self, path):
+        with open(path, 'rb') as f:
+            data = f.read()
+        if data[:4] != b'\x7fELF':
+            fail(f'not an ELF file: {path}')
+        if data[4] == 1:
+            shoff, = struct.unpack_from('<I', data, 0x20)
+            shentsize, shnum = struct.unpack_from('<HH', data, 0x2E)
+            sh = struct.Struct('<IIIIIIIIII')
+        else:
+            shoff, = struct.unpack_from('<Q', data, 0x28)
+            shentsize, shnum = struct.unpack_from('<HH', data, 0x3A)
+            sh = struct.Struct('<IIQQQQIIQQ')
+        self.sections = []
+        for i in range(shnum):
+            _, type_, flags, addr, offset, size, *_ = sh.unpack_from(data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and type_ != SHT_NOBITS and size > 0:
+                self.sections.append((addr, data[offset:offset + size]))
+
+    def string(self, addr):
+        for base, data in self.sections:
+            if base <= addr < base + len(data):
+                end = data.find(b'\0', addr - base)
+                if end < 0:
+                    return None
+                return data[addr - base:end].decode('utf-8', 'replace')
+        return None
+
+
+def format_record(elf, fmt, args):
+    args = list(args)
+
+    def arg():
+        return args.pop(0) if args else 0
+
+    def convert(m):
+        flags, width, prec, length, conv = m.groups()
+        if conv == '%':
+            return '%'
+        spec = '%' + flags + width + ('.' + prec if prec else '')
+        if conv == 's':
+            addr = arg()
+            s = elf.string(addr)
+            return (spec + 's') % (s if s is not None else f'<0x{addr:08x}>')
+        if conv == 'c':
+            return (spec + 'c') % chr(arg() & 0xFF)
+        if conv == 'p':
+            return (spec + 's') % f'0x{arg():08x}'
+        bits = 32
+        v = arg()
+        if length in ('ll', 'j'):
+            v |= arg() << 32
+            bits = 64
+        if conv in 'di' and v & (1 << (bits - 1)):
+            v -= 1 << bits
+        return (spec + ('d' if conv in 'diu' else conv)) % v
+
+    return SPEC.sub(convert, fmt)
+
+
+def decode(elf, stream, out, timestamps):
+    buf = b''
+    seq = None
+    at_line_start = True
+    while True:
+        chunk = stream.read(RECORD.size)
+        if not chunk:
+            break
+        buf += chunk
+        while len(buf) >= RECORD.size:
+            if buf[0] != SYNC:
+                buf = buf[1:]
+                continue
+            sync, length, rseq, fmt_addr, time, *args = RECORD.unpack_from(buf)
+            if length & TEXT:
+                if length & ~TEXT > MAX_ARGS * 4 or fmt_addr != 0:
+                    buf = buf[1:]
+                    continue
+                text = struct.pack('<5I', *args)[:length & ~TEXT].decode('utf-8', 'replace')
+            else:
+                fmt = elf.string(fmt_addr) if length <= MAX_ARGS else None
+                if fmt is None:
+                    buf = buf[1:]
+                    continue
+                text = format_record(elf, fmt, args[:length])
+            buf = buf[RECORD.size:]
+            if seq is not None and rseq != (seq + 1) & 0xFFFF:
+                if not at_line_start:
+                    out.write('\n')
+                out.write(f'[{(rseq - seq - 1) & 0xFFFF} records dropped]\n')
+                at_line_start = True
+            seq = rseq
+            if timestamps:
+                lines = text.split('\n')
+                for i, line in enumerate(lines):
+                    if at_line_start and line:
+                        out.write(f'[{time / 1e6:10.6f}] ')
+                        at_line_start = False
+                    out.write(line)
+                    if i < len(lines) - 1:
+                        out.write('\n')
+                        at_line_start = True
+            elif text:
+                out.write(text)
+                at_line_start = text.endswith('\n')
+            out.flush()
+
+
+def main(argv):
+    timestamps = '-t' in argv[1:]
+    argv = [a for a in argv if a != '-t']
+    if len(argv) not in (2, 3):
+        fail('usage: logdecode.py [-t] <PROGRAM.elf> [INPUT]')
+    elf = Elf(argv[1])
+    try:
+        if len(argv) == 3:
+            with open(argv[2], 'rb', buffering=0) as stream:
+                decode(elf, stream, sys.stdout, timestamps)
+        else:
+            decode(elf, sys.stdin.buffer, sys.stdout, timestamps)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,163 @@
+#include <string.h>
+
+#include "log/ring.h"
+#include "perf/hot.h"
+
+#include "pico/stdio/driver.h"
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+
+// Records are copied to a ring in RAM with interrupts disabled, which takes
+// constant time. DMA sends a contiguous run of records from the tail to the
+// UART by DREQ, and its completion IRQ advances the tail and starts the next
+// run. So the CPU never waits for the UART.
+//
+// Text of printf is written as text records too, because bytes written to the
+// UART directly would break records in flight.
+
+_Static_assert((LOG_RING_LEN & (LOG_RING_LEN - 1)) == 0, "LOG_RING_LEN must be a power of 2");
+_Static_assert(sizeof(log_ring_record_t) == 32, "log_ring_record_t must be packed");
+
+static log_ring_record_t log_ring_records[LOG_RING_LEN];
+
+// head and tail count records, and wrap around by LOG_RING_LEN.
+static volatile uint32_t log_ring_head = 0;
+static volatile uint32_t log_ring_tail = 0;
+// records being sent by DMA from the tail.
+static volatile uint32_t log_ring_inflight = 0;
+static uint16_t log_ring_seq = 0;
+
+static uint log_ring_dma_chan;
+static bool log_ring_ready = false;
+
+static log_ring_stats_t log_ring_stats_ = {0};
+
+// log_ring_start sends records from the tail up to the head or the end of
+// the buffer. Call it with interrupts disabled.
+static void PERF_HOT_FUNC(log_ring_start)(void) {
+    if (!log_ring_ready || log_ring_inflight > 0) {
+        return;
+    }
+    uint32_t tail = log_ring_tail;
+    uint32_t n = log_ring_head - tail;
+    uint32_t index = tail & (LOG_RING_LEN - 1);
+    if (n > LOG_RING_LEN - index) {
+        n = LOG_RING_LEN - index;
+    }
+    if (n == 0) {
+        return;
+    }
+    log_ring_inflight = n;
+    dma_channel_transfer_from_buffer_now(log_ring_dma_chan, &log_ring_records[index],
+            n * sizeof(log_ring_record_t));
+}
+
+static void __isr PERF_HOT_FUNC(on_completed_dma)(void) {
+    dma_hw->ints1 = 1u << log_ring_dma_chan;
+    uint32_t save = save_and_disable_interrupts();
+    log_ring_tail += log_ring_inflight;
+    log_ring_inflight = 0;
+    log_ring_start();
+    restore_interrupts(save);
+}
+
+// log_ring_put copies a record to the head. It returns false if dropped.
+static bool PERF_HOT_FUNC(log_ring_put)(uint8_t len, uint32_t fmt, const void *args, uint args_size) {
+    uint32_t time = time_us_32();
+    uint32_t save = save_and_disable_interrupts();
+    uint16_t seq = log_ring_seq++;
+    uint32_t head = log_ring_head;
+    if (head - log_ring_tail >= LOG_RING_LEN) {
+        log_ring_stats_.dropped++;
+        restore_interrupts(save);
+        return false;
+    }
+    log_ring_record_t *r = &log_ring_records[head & (LOG_RING_LEN - 1)];
+    r->sync = LOG_RING_SYNC;
+    r->len  = len;
+    r->seq  = seq;
+    r->fmt  = fmt;
+    r->time = time;
+    memcpy(r->args, args, args_size);
+    log_ring_head = head + 1;
+    log_ring_stats_.written++;
+    log_ring_start();
+    restore_interrupts(save);
+    return true;
+}
+
+void PERF_HOT_FUNC(log_ring_write)(const char *fmt, uint n, const uint32_t *args) {
+    log_ring_put(n, (uint32_t)(uintptr_t)fmt, args, LOG_RING_MAX_ARGS * sizeof(uint32_t));
+}
+
+void log_ring_text(const char *buf, uint len) {
+    while (len > 0) {
+        char chunk[LOG_RING_MAX_ARGS * sizeof(uint32_t)] = {0};
+        uint n = len < sizeof(chunk) ? len : sizeof(chunk);
+        memcpy(chunk, buf, n);
+        log_ring_put(LOG_RING_TEXT | n, 0, chunk, sizeof(chunk));
+        buf += n;
+        len -= n;
+    }
+}
+
+uint log_ring_space(void) {
+    return LOG_RING_LEN - (log_ring_head - log_ring_tail);
+}
+
+const log_ring_stats_t *log_ring_stats(void) {
+    return &log_ring_stats_;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// stdio driver
+
+static void log_ring_stdio_out_chars(const char *buf, int len) {
+    log_ring_text(buf, len);
+}
+
+static int log_ring_stdio_in_chars(char *buf, int len) {
+    int n = 0;
+    while (n < len && uart_is_readable(uart_default)) {
+        buf[n++] = uart_getc(uart_default);
+    }
+    return n > 0 ? n : PICO_ERROR_NO_DATA;
+}
+
+static stdio_driver_t log_ring_stdio = {
+    .out_chars = log_ring_stdio_out_chars,
+    .in_chars  = log_ring_stdio_in_chars,
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT
+    .crlf_enabled = PICO_STDIO_DEFAULT_CRLF,
+#endif
+};
+
+void log_ring_init(void) {
+    uart_init(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+    gpio_set_function(PICO_DEFAULT_UART_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(PICO_DEFAULT_UART_RX_PIN, GPIO_FUNC_UART);
+
+    // DMA_IRQ_0 is taken by ws2812_array.
+    log_ring_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(log_ring_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, uart_get_dreq(uart_default, true));
+    dma_channel_configure(log_ring_dma_chan, &c, &uart_get_hw(uart_default)->dr,
+            log_ring_records, 0, false);
+    irq_set_exclusive_handler(DMA_IRQ_1, on_completed_dma);
+    dma_channel_set_irq1_enabled(log_ring_dma_chan, true);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    stdio_set_driver_enabled(&log_ring_stdio, true);
+
+    // send records written before.
+    uint32_t save = save_and_disable_interrupts();
+    log_ring_ready = true;
+    log_ring_start();
+    restore_interrupts(save);
+}
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+
+# Reports where the hot set of a program was placed.
+#
+# usage:
+#   hotreport.py <PROGRAM.elf> <OUT.txt> <SYMBOL>...
+#
+# Each symbol is listed with its address, size and section. Symbols in flash
+# (XIP) are marked FLASH, and the total size of them is reported at the end.
+# Symbols not found were inlined into their callers, or are not linked. A
+# name may match several static symbols.
+
+import struct
+import sys
+
+SHT_SYMTAB = 2
+STT_FUNC = 2
+
+FLASH_BEGIN = 0x10000000
+FLASH_END = 0x20000000
+
+
+def fail(msg):
+    print(f'hotreport: {msg}', file=sys.stderr)
+    sys.exit(1)
+
+
+def read_symbols(path):
+    """Returns {name: [(addr, size, section)]} of functions and objects."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:4] != b'\x7fELF':
+        fail(f'not an ELF file: {path}')
+    if data[4] == 1:
+        shoff, = struct.unpack_from('<I', data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x2E)
+        sh = struct.Struct('<IIIIIIIIII')
+        sym = struct.Struct('<IIIBBH')
+    else:
+        shoff, = struct.unpack_from('<Q', data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from('<HHH', data, 0x3A)
+        sh = struct.Struct('<IIQQQQIIQQ')
+        sym = struct.Struct('<IBBHQQ')
+    sections = [sh.unpack_from(data, shoff + i * shentsize) for i in range(shnum)]
+
+    def string(table, offset):
+        base = sections[table][4]
+        end = data.index(b'\0', base + offset)
+        return data[base + offset:end].decode()
+
+    names = [string(shstrndx, s[0]) for s in sections]
+    symbols = {}
+    for s in sections:
+        if s[1] != SHT_SYMTAB:
+            continue
+        _, _, _, _, offset, size, link, _, _, entsize = s
+        for i in range(size // entsize):
+            if data[4] == 1:
+                name, value, sz, info, _, shndx = sym.unpack_from(data, offset + i * entsize)
+            else:
+                name, info, _, shndx, value, sz = sym.unpack_from(data, offset + i * entsize)
+            if name == 0 or not 0 < shndx < len(sections):
+                continue
+            if info & 0xF == STT_FUNC:
+                # the thumb bit.
+                value &= ~1
+            symbols.setdefault(string(link, name), []).append((value, sz, names[shndx]))
+    return symbols
+
+
+def main(argv):
+    if len(argv) < 3:
+        fail('usage: hotreport.py <PROGRAM.elf> <OUT.txt> <SYMBOL>...')
+    path, out, wanted = argv[1], argv[2], argv[3:]
+    symbols = read_symbols(path)
+    lines = [f'{"symbol":<32} {"address":<10} {"size":>6}  section']
+    in_flash = 0
+    in_flash_size = 0
+    for name in wanted:
+        found = symbols.get(name)
+        if not found:
+            lines.append(f'{name:<32} {"-":<10} {"-":>6}  (inlined or not linked)')
+            continue
+        for addr, size, section in sorted(set(found)):
+            mark = ''
+            if FLASH_BEGIN <= addr < FLASH_END:
+                mark = '  FLASH'
+                in_flash += 1
+                in_flash_size += size
+            lines.append(f'{name:<32} 0x{addr:08x} {size:>6}  {section}{mark}')
+    lines.append(f'{in_flash} hot symbols in flash, {in_flash_size} bytes')
+    text = '\n'.join(lines) + '\n'
+    with open(out, 'w') as f:
+        f.write(text)
+    print(text, end='')
+
+
+if __name__ == '__main__':
+    main(sys.argv)
@@ -0,0 +1,51 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Placements of hot paths, chosen by PERF_HOT_PATH of CMake.
+//
+//  - FLASH runs them through XIP, and may stall on cache misses when other
+//    code evicted them.
+//  - RAM copies them to the striped SRAM at boot, like __not_in_flash_func.
+//  - SCRATCH copies functions to SCRATCH_X and tables to SCRATCH_Y, which
+//    are separate banks, so fetches never contend with DMA to the main SRAM.
+//    SCRATCH_X is free without pico_multicore, and SCRATCH_Y holds the stack
+//    of core 0.
+#define PERF_HOT_PATH_FLASH     0
+#define PERF_HOT_PATH_RAM       1
+#define PERF_HOT_PATH_SCRATCH   2
+
+#ifndef PERF_HOT_PATH
+    #define PERF_HOT_PATH PERF_HOT_PATH_FLASH
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Macros
+
+// PERF_HOT_FUNC marks a function of the hot set, as __not_in_flash_func does.
+//
+//     void PERF_HOT_FUNC(switch_matrix_task)(switch_matrix_t *sm, uint64_t now) {
+//
+// PERF_HOT_DATA marks a table read by the hot set.
+//
+//     const uint8_t PERF_HOT_DATA(gamma)[256] = { ... };
+//
+// List them in perf_hot_path_report() of the program too, to check where
+// they were placed.
+#if PERF_HOT_PATH == PERF_HOT_PATH_SCRATCH
+
+#define PERF_HOT_FUNC(name) __attribute__((section(".scratch_x." #name))) name
+#define PERF_HOT_DATA(name) __attribute__((section(".scratch_y." #name))) name
+
+#elif PERF_HOT_PATH == PERF_HOT_PATH_RAM
+
+#define PERF_HOT_FUNC(name) __attribute__((section(".time_critical." #name))) name
+#define PERF_HOT_DATA(name) __attribute__((section(".data." #name))) name
+
+#else
+
+#define PERF_HOT_FUNC(name) name
+#define PERF_HOT_DATA(name) name
+
+#endif
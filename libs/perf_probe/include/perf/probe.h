@@ -0,0 +1,134 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// PERF_PROBE_ENABLED turns on all probes. When it is 0 every PERF_PROBE_*
+// macro expands to nothing, so instrumented code costs nothing.
+#ifndef PERF_PROBE_ENABLED
+    #define PERF_PROBE_ENABLED 0
+#endif
+
+// Number of histogram buckets for each probe. Bucket 0 counts samples
+// shorter than 16 cycles, bucket i counts samples in [2^(i+3), 2^(i+4))
+// cycles, and the last bucket also collects everything longer.
+#ifndef PERF_PROBE_HIST_NUM
+    #define PERF_PROBE_HIST_NUM 16
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+#include <pico/types.h>
+
+#include "hardware/structs/systick.h"
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t hist[PERF_PROBE_HIST_NUM];
+} perf_probe_stats_t;
+
+typedef struct perf_probe_s perf_probe_t;
+
+struct perf_probe_s {
+    const char *name;
+    perf_probe_t *next;
+    bool registered;
+    bool dump_pending;
+
+    perf_probe_stats_t stats;
+    perf_probe_stats_t snapshot;
+};
+
+typedef struct {
+    perf_probe_t *probe;
+    uint32_t start;
+} perf_probe_scope_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// perf_probe_init starts SysTick as a free running 24-bit cycle counter.
+// Samples must be shorter than 2^24 cycles (about 134ms at 125MHz).
+void perf_probe_init(void);
+
+// perf_probe_record adds a sample to a probe. A probe registers itself to the
+// dump list at its first sample.
+void perf_probe_record(perf_probe_t *p, uint32_t cycles);
+
+// perf_probe_dump_request takes snapshots of all probes at once. The
+// snapshots are printed by perf_probe_dump_task later.
+void perf_probe_dump_request(void);
+
+// perf_probe_dump_task prints one pending snapshot per call, so a dump is
+// spread over several iterations of the main loop. It returns true while
+// snapshots remain.
+bool perf_probe_dump_task(void);
+
+// perf_probe_reset_all clears the statistics of all probes.
+void perf_probe_reset_all(void);
+
+// perf_probe_now returns the current value of the cycle counter. SysTick
+// counts down.
+static inline uint32_t perf_probe_now(void) {
+    return systick_hw->cvr;
+}
+
+// perf_probe_elapsed returns cycles elapsed since start.
+static inline uint32_t perf_probe_elapsed(uint32_t start) {
+    return (start - systick_hw->cvr) & 0x00ffffff;
+}
+
+static inline void perf_probe_scope_end(perf_probe_scope_t *s) {
+    perf_probe_record(s->probe, perf_probe_elapsed(s->start));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Macros
+
+#if PERF_PROBE_ENABLED
+
+#define PERF_PROBE_INIT() perf_probe_init()
+
+// PERF_PROBE_DEFINE defines a probe at file scope.
+#define PERF_PROBE_DEFINE(id) \
+    perf_probe_t perf_probe_##id = { .name = #id }
+
+// PERF_PROBE_DECLARE declares a probe which is defined in other file.
+#define PERF_PROBE_DECLARE(name) \
+    extern perf_probe_t perf_probe_##name
+
+// PERF_PROBE_BEGIN and PERF_PROBE_END measure a region in same block.
+#define PERF_PROBE_BEGIN(name) \
+    uint32_t perf_probe_start_##name = perf_probe_now()
+
+#define PERF_PROBE_END(name) \
+    perf_probe_record(&perf_probe_##name, perf_probe_elapsed(perf_probe_start_##name))
+
+// PERF_PROBE_SCOPE measures from here to the end of the enclosing block,
+// including early returns.
+#define PERF_PROBE_SCOPE(name) \
+    __attribute__((cleanup(perf_probe_scope_end))) \
+    perf_probe_scope_t perf_probe_scope_##name = { &perf_probe_##name, perf_probe_now() }
+
+#else
+
+#define PERF_PROBE_INIT() do {} while (0)
+#define PERF_PROBE_DEFINE(name) extern int perf_probe_disabled_##name
+#define PERF_PROBE_DECLARE(name) extern int perf_probe_disabled_##name
+#define PERF_PROBE_BEGIN(name) do {} while (0)
+#define PERF_PROBE_END(name) do {} while (0)
+#define PERF_PROBE_SCOPE(name) do {} while (0)
+
+#endif
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "perf/probe.h"
+
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+
+// SysTick control and status register bits.
+#define SYST_CSR_ENABLE     (1u << 0)
+#define SYST_CSR_CLKSOURCE  (1u << 2)
+
+static perf_probe_t *probes = NULL;
+
+static inline uint perf_probe_bucket(uint32_t cycles) {
+    uint32_t v = cycles >> 4;
+    if (v == 0) {
+        return 0;
+    }
+    uint b = 32 - __builtin_clz(v);
+    return b < PERF_PROBE_HIST_NUM ? b : PERF_PROBE_HIST_NUM - 1;
+}
+
+void perf_probe_init(void) {
+    if ((systick_hw->csr & SYST_CSR_ENABLE) != 0) {
+        return;
+    }
+    // Count down from 0xffffff with the processor clock, without interrupt.
+    systick_hw->rvr = 0x00ffffff;
+    systick_hw->cvr = 0;
+    systick_hw->csr = SYST_CSR_CLKSOURCE | SYST_CSR_ENABLE;
+}
+
+void perf_probe_record(perf_probe_t *p, uint32_t cycles) {
+    if (!p->registered) {
+        p->registered = true;
+        p->next = probes;
+        probes = p;
+    }
+    perf_probe_stats_t *s = &p->stats;
+    if (s->count == 0 || cycles < s->min) {
+        s->min = cycles;
+    }
+    if (cycles > s->max) {
+        s->max = cycles;
+    }
+    s->count++;
+    s->sum += cycles;
+    s->hist[perf_probe_bucket(cycles)]++;
+}
+
+void perf_probe_dump_request(void) {
+    // Probes may be recorded from IRQ handlers, so take all snapshots with
+    // interrupts disabled. It is just some memcpy.
+    uint32_t saved = save_and_disable_interrupts();
+    for (perf_probe_t *p = probes; p != NULL; p = p->next) {
+        memcpy(&p->snapshot, &p->stats, sizeof(p->snapshot));
+        p->dump_pending = true;
+    }
+    restore_interrupts(saved);
+    printf("perf_probe: clk_sys=%lu\n", (unsigned long)clock_get_hz(clk_sys));
+}
+
+bool perf_probe_dump_task(void) {
+    perf_probe_t *p = probes;
+    while (p != NULL && !p->dump_pending) {
+        p = p->next;
+    }
+    if (p == NULL) {
+        return false;
+    }
+    p->dump_pending = false;
+    perf_probe_stats_t *s = &p->snapshot;
+    unsigned long mean = s->count > 0 ? (unsigned long)(s->sum / s->count) : 0;
+    printf("perf_probe: %-16s count=%lu min=%lu max=%lu mean=%lu hist=",
+            p->name, (unsigned long)s->count, (unsigned long)s->min,
+            (unsigned long)s->max, mean);
+    for (int i = 0; i < PERF_PROBE_HIST_NUM; i++) {
+        printf(i == 0 ? "%lu" : ",%lu", (unsigned long)s->hist[i]);
+    }
+    printf("\n");
+    return true;
+}
+
+void perf_probe_reset_all(void) {
+    uint32_t saved = save_and_disable_interrupts();
+    for (perf_probe_t *p = probes; p != NULL; p = p->next) {
+        memset(&p->stats, 0, sizeof(p->stats));
+    }
+    restore_interrupts(saved);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <pico/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+// Priorities of tasks. A ready task of a higher priority (smaller value)
+// always runs before others, and tasks of a same priority run earliest
+// deadline first.
+enum {
+    TASK_PRIORITY_INPUT      = 0,
+    TASK_PRIORITY_OUTPUT     = 1,
+    TASK_PRIORITY_BACKGROUND = 2,
+};
+
+typedef struct task_s task_t;
+
+typedef void (*task_fn)(task_t *t, uint64_t now);
+
+typedef struct {
+    uint32_t runs;
+    // runs which took longer than the budget.
+    uint32_t overruns;
+    // runs which started after their deadline.
+    uint32_t misses;
+    uint32_t max_elapsed;
+    uint32_t max_lateness;
+} task_stats_t;
+
+struct task_s {
+    // Set these before task_scheduler_add().
+    const char *name;
+    task_fn fn;
+    void *user;
+    // Interval to run in microseconds. A run is released every period, and
+    // its deadline is the next release.
+    uint32_t period;
+    uint8_t  priority;
+    // Expected max time of a run in microseconds, 0 to not check.
+    uint32_t budget;
+
+    uint64_t release;
+    volatile bool woken;
+    volatile bool suspended;
+    task_stats_t stats;
+    task_t *next;
+};
+
+typedef struct {
+    task_t *tasks;
+    // Time spent in WFE, waiting for the next release or an interrupt.
+    uint64_t idle;
+    uint64_t started;
+    // The task printed next by task_scheduler_dump_task.
+    task_t *dump_next;
+} task_scheduler_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void task_scheduler_init(task_scheduler_t *s);
+
+// task_scheduler_add adds a task, which is released immediately.
+void task_scheduler_add(task_scheduler_t *s, task_t *t);
+
+// task_scheduler_run_once runs a ready task, and returns true. When no task
+// is ready it returns false without waiting.
+bool task_scheduler_run_once(task_scheduler_t *s, uint64_t now);
+
+// task_scheduler_run runs tasks forever. It sleeps by WFE until the next
+// release, or until an interrupt occurs.
+void __attribute__((noreturn)) task_scheduler_run(task_scheduler_t *s);
+
+// task_wake releases a task immediately, to react to an event. It can be
+// called from IRQ handlers.
+void task_wake(task_t *t);
+
+// task_suspend stops to release a task, until task_resume. The scheduler
+// sleeps without timeout when all tasks are suspended.
+void task_suspend(task_t *t);
+
+// task_resume makes a suspended task ready immediately. It can be called from
+// IRQ handlers.
+void task_resume(task_t *t);
+
+// task_scheduler_dump_request prints the idle ratio, and statistics of tasks
+// are printed by task_scheduler_dump_task later.
+void task_scheduler_dump_request(task_scheduler_t *s);
+
+// task_scheduler_dump_task prints statistics of a task per call, so a dump is
+// spread over several runs. It returns true while tasks remain.
+bool task_scheduler_dump_task(task_scheduler_t *s);
+
+// task_scheduler_reset_stats clears statistics of all tasks.
+void task_scheduler_reset_stats(task_scheduler_t *s);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "task/scheduler.h"
+#include "flight/recorder.h"
+
+#include "pico/time.h"
+#include "hardware/sync.h"
+
+// A cooperative scheduler. Each task is released every period, and a
+// released task is ready until it runs. Ready tasks are picked by priority
+// first and then by the earliest deadline. A task which misses several
+// periods runs once, and its next release is aligned to now, instead of
+// running back to back to catch up.
+
+void task_scheduler_init(task_scheduler_t *s) {
+    s->tasks = NULL;
+    s->idle = 0;
+    s->started = time_us_64();
+    s->dump_next = NULL;
+}
+
+void task_scheduler_add(task_scheduler_t *s, task_t *t) {
+    t->release = time_us_64();
+    t->woken = false;
+    t->suspended = false;
+    memset(&t->stats, 0, sizeof(t->stats));
+    t->next = s->tasks;
+    s->tasks = t;
+}
+
+// task_deadline returns the deadline of a ready task. A woken task has the
+// earliest deadline in its priority.
+static inline uint64_t task_deadline(task_t *t) {
+    return t->woken ? 0 : t->release + t->period;
+}
+
+static task_t *task_scheduler_pick(task_scheduler_t *s, uint64_t now) {
+    task_t *best = NULL;
+    uint64_t best_deadline = 0;
+    for (task_t *t = s->tasks; t != NULL; t = t->next) {
+        if (t->suspended || (!t->woken && t->release > now)) {
+            continue;
+        }
+        uint64_t deadline = task_deadline(t);
+        if (best == NULL || t->priority < best->priority ||
+                (t->priority == best->priority && deadline < best_deadline)) {
+            best = t;
+            best_deadline = deadline;
+        }
+    }
+    return best;
+}
+
+bool task_scheduler_run_once(task_scheduler_t *s, uint64_t now) {
+    task_t *t = task_scheduler_pick(s, now);
+    if (t == NULL) {
+        return false;
+    }
+    // a wake while running releases the task again.
+    bool woken = t->woken;
+    t->woken = false;
+    uint64_t lateness = woken || t->release > now ? 0 : now - t->release;
+    t->fn(t, now);
+    uint64_t end = time_us_64();
+
+    task_stats_t *st = &t->stats;
+    uint32_t elapsed = (uint32_t)(end - now);
+    st->runs++;
+    if (elapsed > st->max_elapsed) {
+        st->max_elapsed = elapsed;
+    }
+    if (t->budget > 0 && elapsed > t->budget) {
+        st->overruns++;
+        FLIGHT_RECORDER_PUT(OVERRUN, t->priority, elapsed > UINT16_MAX ? UINT16_MAX : elapsed, (uintptr_t)t->name);
+    }
+    if (lateness > st->max_lateness) {
+        st->max_lateness = lateness > UINT32_MAX ? UINT32_MAX : (uint32_t)lateness;
+    }
+    if (lateness > t->period) {
+        st->misses++;
+    }
+
+    // a woken task keeps its periodic release.
+    if (t->release <= now) {
+        t->release += t->period;
+        if (t->release <= now) {
+            t->release = now + t->period;
+        }
+    }
+    return true;
+}
+
+void task_scheduler_run(task_scheduler_t *s) {
+    while (true) {
+        uint64_t now = time_us_64();
+        if (task_scheduler_run_once(s, now)) {
+            continue;
+        }
+        uint64_t next = UINT64_MAX;
+        for (task_t *t = s->tasks; t != NULL; t = t->next) {
+            if (t->suspended) {
+                continue;
+            }
+            if (t->woken) {
+                next = now;
+                break;
+            }
+            if (t->release < next) {
+                next = t->release;
+            }
+        }
+        // Any interrupt wakes up WFE too, and the loop checks tasks again.
+        if (next == UINT64_MAX) {
+            __wfe();
+        } else {
+            best_effort_wfe_or_timeout(from_us_since_boot(next));
+        }
+        s->idle += time_us_64() - now;
+    }
+}
+
+void task_wake(task_t *t) {
+    t->woken = true;
+    __sev();
+}
+
+void task_suspend(task_t *t) {
+    t->suspended = true;
+}
+
+void task_resume(task_t *t) {
+    t->woken = true;
+    t->suspended = false;
+    __sev();
+}
+
+void task_scheduler_dump_request(task_scheduler_t *s) {
+    uint64_t total = time_us_64() - s->started;
+    printf("task_scheduler: idle=%llu%% (%llu/%llu us)\n",
+            total > 0 ? s->idle * 100 / total : 0, s->idle, total);
+    s->dump_next = s->tasks;
+}
+
+bool task_scheduler_dump_task(task_scheduler_t *s) {
+    task_t *t = s->dump_next;
+    if (t == NULL) {
+        return false;
+    }
+    s->dump_next = t->next;
+    task_stats_t *st = &t->stats;
+    printf("  %-12s pri=%u period=%-6lu runs=%-8lu overruns=%-6lu misses=%-6lu max=%luus late=%luus\n",
+            t->name, t->priority, (unsigned long)t->period,
+            (unsigned long)st->runs, (unsigned long)st->overruns,
+            (unsigned long)st->misses, (unsigned long)st->max_elapsed,
+            (unsigned long)st->max_lateness);
+    return true;
+}
+
+void task_scheduler_reset_stats(task_scheduler_t *s) {
+    for (task_t *t = s->tasks; t != NULL; t = t->next) {
+        memset(&t->stats, 0, sizeof(t->stats));
+    }
+    s->idle = 0;
+    s->started = time_us_64();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <pico/types.h>
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Max number of reports waiting for the endpoint.
+#ifndef USB_KEYBOARD_QUEUE_LEN
+    #define USB_KEYBOARD_QUEUE_LEN 32
+#endif
+
+// Usages of the keyboard page below modifiers, reported by the NKRO bitmap.
+#define USB_KEYBOARD_NKRO_USAGES 0xE0
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+// usb_keyboard_report_t is the boot protocol keyboard report.
+typedef struct {
+    uint8_t modifier;
+    uint8_t reserved;
+    uint8_t keycode[6];
+} usb_keyboard_report_t;
+
+// usb_keyboard_nkro_report_t is the report protocol keyboard report, a bit
+// per usage.
+typedef struct {
+    uint8_t modifier;
+    uint8_t bitmap[USB_KEYBOARD_NKRO_USAGES / 8];
+} usb_keyboard_nkro_report_t;
+
+typedef struct {
+    // Latency from detection of events to delivery of their reports to the
+    // host, in microseconds.
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+
+    // Changes merged into a queued report while the host was not polling.
+    uint32_t coalesced;
+
+    // Changes merged into the last queued report, because the queue was
+    // full. Order of events in them is lost.
+    uint32_t overflows;
+} usb_keyboard_stats_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// usb_keyboard_init initializes the USB device stack, and clears state.
+void usb_keyboard_init(void);
+
+// usb_keyboard_press and usb_keyboard_release update pressed keys by a usage
+// of the keyboard page (modifiers are 0xE0 to 0xE7), and queue a report if
+// it changed. when is the time the event was detected, to measure latency.
+// The report is sent immediately if the endpoint is free.
+void usb_keyboard_press(uint8_t usage, uint64_t when);
+void usb_keyboard_release(uint8_t usage, uint64_t when);
+
+// usb_keyboard_resend queues a report of current state, as the host switched
+// the protocol.
+void usb_keyboard_resend(uint64_t when);
+
+// usb_keyboard_task runs the USB device stack, and sends a queued report when
+// the endpoint is free. Call it frequently, more than once per 1ms frame.
+void usb_keyboard_task(uint64_t now);
+
+// usb_keyboard_sent should be called when the host has taken the report.
+void usb_keyboard_sent(uint64_t now);
+
+// usb_keyboard_pending returns the number of queued reports.
+uint usb_keyboard_pending(void);
+
+const usb_keyboard_stats_t *usb_keyboard_stats(void);
+
+void usb_keyboard_reset_stats(void);
+
+//----------------------------------------------------------------------------
+// Port
+//
+// These connect the keyboard to a USB device stack, and are implemented for
+// TinyUSB by keyboard_tinyusb.c. Host tests implement them to fake the
+// endpoint.
+
+void usb_keyboard_port_init(void);
+
+void usb_keyboard_port_task(void);
+
+// usb_keyboard_port_ready returns true when the endpoint can accept a report.
+bool usb_keyboard_port_ready(void);
+
+// usb_keyboard_port_boot returns true when the host selected the boot
+// protocol, which takes usb_keyboard_report_t instead of
+// usb_keyboard_nkro_report_t.
+bool usb_keyboard_port_boot(void);
+
+// usb_keyboard_port_send starts to send a report, and returns false when it
+// was not accepted. usb_keyboard_sent() is called on completion.
+bool usb_keyboard_port_send(const void *report, uint16_t len);
+
+//----------------------------------------------------------------------------
+// Hooks
+
+// usb_keyboard_event is called back from the USB IRQ when the device stack
+// queued an event, which usb_keyboard_task should process. It lets callers
+// run the task on events instead of polling it.
+void usb_keyboard_event(void);
+
+#ifdef __cplusplus
+}
+#endif
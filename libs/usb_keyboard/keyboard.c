@@ -0,0 +1,220 @@
+#include <string.h>
+
+#include "usb/keyboard.h"
+
+// Pressed keys are held in a NKRO report, and each event flips a bit of it.
+// A change is queued as a new report, or merged into the last queued report
+// when it is waiting for the host to poll. Merging never loses nor reorders
+// events for the host:
+//
+//  - a key changed twice (a tap) needs two reports.
+//  - two presses in a report would be seen in order of usages, not events.
+//  - modifiers apply to presses around them, so they are not merged.
+//
+// Releases merge into a report with a press or other releases, as their order
+// does not change what is typed. Reports of the boot protocol are built from
+// NKRO reports on sending.
+
+#define USB_KEYBOARD_MODIFIER_FIRST 0xE0
+#define USB_KEYBOARD_MODIFIER_LAST  0xE7
+
+// The boot protocol reports this in all slots when more than 6 keys are
+// pressed.
+#define USB_KEYBOARD_ERROR_ROLLOVER 0x01
+
+typedef struct {
+    usb_keyboard_nkro_report_t report;
+    // usages changed from the previous report.
+    uint8_t changed[USB_KEYBOARD_NKRO_USAGES / 8];
+    bool pressed;
+    bool modifier;
+    // the time of the first event in the report.
+    uint64_t when;
+} usb_keyboard_entry_t;
+
+static usb_keyboard_nkro_report_t state;
+
+static usb_keyboard_entry_t queue[USB_KEYBOARD_QUEUE_LEN];
+static uint queue_head;
+static uint queue_len;
+
+// A report is on the endpoint, and the time of its event.
+static bool     inflight;
+static uint64_t inflight_when;
+
+static usb_keyboard_stats_t stats;
+
+void usb_keyboard_init(void) {
+    memset(&state, 0, sizeof(state));
+    queue_head = 0;
+    queue_len = 0;
+    inflight = false;
+    usb_keyboard_reset_stats();
+    usb_keyboard_port_init();
+}
+
+static void usb_keyboard_build_boot(usb_keyboard_report_t *r, const usb_keyboard_nkro_report_t *nkro) {
+    memset(r, 0, sizeof(*r));
+    r->modifier = nkro->modifier;
+    uint n = 0;
+    for (uint i = 0; i < count_of(nkro->bitmap); i++) {
+        uint bits = nkro->bitmap[i];
+        while (bits != 0) {
+            uint b = __builtin_ctz(bits);
+            bits &= bits - 1;
+            if (n >= count_of(r->keycode)) {
+                memset(r->keycode, USB_KEYBOARD_ERROR_ROLLOVER, sizeof(r->keycode));
+                return;
+            }
+            r->keycode[n++] = i * 8 + b;
+        }
+    }
+}
+
+static void usb_keyboard_flush(void) {
+    if (queue_len == 0 || inflight || !usb_keyboard_port_ready()) {
+        return;
+    }
+    usb_keyboard_entry_t *e = &queue[queue_head];
+    bool ok;
+    if (usb_keyboard_port_boot()) {
+        usb_keyboard_report_t boot;
+        usb_keyboard_build_boot(&boot, &e->report);
+        ok = usb_keyboard_port_send(&boot, sizeof(boot));
+    } else {
+        ok = usb_keyboard_port_send(&e->report, sizeof(e->report));
+    }
+    if (!ok) {
+        return;
+    }
+    inflight = true;
+    inflight_when = e->when;
+    queue_head = (queue_head + 1) % USB_KEYBOARD_QUEUE_LEN;
+    queue_len--;
+}
+
+static inline bool usb_keyboard_is_modifier(uint8_t usage) {
+    return usage >= USB_KEYBOARD_MODIFIER_FIRST && usage <= USB_KEYBOARD_MODIFIER_LAST;
+}
+
+// usb_keyboard_apply changes a usage in a report, and returns true if it
+// changed. Usage 0 is no key.
+static bool usb_keyboard_apply(usb_keyboard_nkro_report_t *r, uint8_t usage, bool on) {
+    uint8_t *p;
+    uint8_t bit;
+    if (usb_keyboard_is_modifier(usage)) {
+        p = &r->modifier;
+        bit = 1 << (usage - USB_KEYBOARD_MODIFIER_FIRST);
+    } else if (usage != 0 && usage < USB_KEYBOARD_NKRO_USAGES) {
+        p = &r->bitmap[usage / 8];
+        bit = 1 << (usage % 8);
+    } else {
+        return false;
+    }
+    uint8_t v = on ? *p | bit : *p & ~bit;
+    if (v == *p) {
+        return false;
+    }
+    *p = v;
+    return true;
+}
+
+static bool usb_keyboard_can_merge(const usb_keyboard_entry_t *e, uint8_t usage, bool on) {
+    if (e->modifier || usb_keyboard_is_modifier(usage)) {
+        return false;
+    }
+    if (e->changed[usage / 8] & (1 << (usage % 8))) {
+        return false;
+    }
+    return !(on && e->pressed);
+}
+
+static usb_keyboard_entry_t *usb_keyboard_push(uint64_t when) {
+    usb_keyboard_entry_t *e = &queue[(queue_head + queue_len) % USB_KEYBOARD_QUEUE_LEN];
+    memcpy(&e->report, &state, sizeof(state));
+    memset(e->changed, 0, sizeof(e->changed));
+    e->pressed = false;
+    e->modifier = false;
+    e->when = when;
+    queue_len++;
+    return e;
+}
+
+static void usb_keyboard_update(uint8_t usage, bool on, uint64_t when) {
+    if (!usb_keyboard_apply(&state, usage, on)) {
+        return;
+    }
+    // the last report is not sent yet if it is queued.
+    usb_keyboard_entry_t *e = NULL;
+    if (queue_len > 0) {
+        e = &queue[(queue_head + queue_len - 1) % USB_KEYBOARD_QUEUE_LEN];
+    }
+    if (e != NULL && usb_keyboard_can_merge(e, usage, on)) {
+        usb_keyboard_apply(&e->report, usage, on);
+        stats.coalesced++;
+    } else if (queue_len < USB_KEYBOARD_QUEUE_LEN) {
+        e = usb_keyboard_push(when);
+    } else {
+        // keep the time of the older event, it has waited longer.
+        memcpy(&e->report, &state, sizeof(state));
+        stats.overflows++;
+    }
+    if (usb_keyboard_is_modifier(usage)) {
+        e->modifier = true;
+    } else {
+        e->changed[usage / 8] |= 1 << (usage % 8);
+        e->pressed |= on;
+    }
+    usb_keyboard_flush();
+}
+
+void usb_keyboard_press(uint8_t usage, uint64_t when) {
+    usb_keyboard_update(usage, true, when);
+}
+
+void usb_keyboard_release(uint8_t usage, uint64_t when) {
+    usb_keyboard_update(usage, false, when);
+}
+
+void usb_keyboard_resend(uint64_t when) {
+    // queued reports are sent in the new protocol.
+    if (queue_len == 0) {
+        // no changes merge into it, to keep it as is.
+        usb_keyboard_push(when)->modifier = true;
+    }
+    usb_keyboard_flush();
+}
+
+void usb_keyboard_task(uint64_t now) {
+    usb_keyboard_port_task();
+    usb_keyboard_flush();
+}
+
+void usb_keyboard_sent(uint64_t now) {
+    if (inflight) {
+        uint32_t latency = (uint32_t)(now - inflight_when);
+        if (stats.count == 0 || latency < stats.min) {
+            stats.min = latency;
+        }
+        if (latency > stats.max) {
+            stats.max = latency;
+        }
+        stats.count++;
+        stats.sum += latency;
+        inflight = false;
+    }
+    // send the next report to be taken at the next poll.
+    usb_keyboard_flush();
+}
+
+uint usb_keyboard_pending(void) {
+    return queue_len;
+}
+
+const usb_keyboard_stats_t *usb_keyboard_stats(void) {
+    return &stats;
+}
+
+void usb_keyboard_reset_stats(void) {
+    memset(&stats, 0, sizeof(stats));
+}
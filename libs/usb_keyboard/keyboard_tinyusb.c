@@ -0,0 +1,168 @@
+#include <pico/stdlib.h>
+
+#include "tusb.h"
+
+#include "usb/keyboard.h"
+
+// Port of usb_keyboard to TinyUSB, with descriptors of a keyboard which is
+// polled every frame (bInterval 1). It supports the boot protocol, and its
+// report protocol is the NKRO bitmap, which starts with modifiers and LEDs as
+// the boot report does.
+
+#define USB_KEYBOARD_VID 0xCafe
+#define USB_KEYBOARD_PID 0x4004
+
+#define USB_KEYBOARD_EP_IN 0x81
+
+enum {
+    USB_KEYBOARD_ITF,
+    USB_KEYBOARD_ITF_NUM,
+};
+
+enum {
+    USB_KEYBOARD_STR_LANGID,
+    USB_KEYBOARD_STR_MANUFACTURER,
+    USB_KEYBOARD_STR_PRODUCT,
+    USB_KEYBOARD_STR_SERIAL,
+};
+
+static const tusb_desc_device_t desc_device = {
+    .bLength            = sizeof(tusb_desc_device_t),
+    .bDescriptorType    = TUSB_DESC_DEVICE,
+    .bcdUSB             = 0x0200,
+    .bDeviceClass       = 0x00,
+    .bDeviceSubClass    = 0x00,
+    .bDeviceProtocol    = 0x00,
+    .bMaxPacketSize0    = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor           = USB_KEYBOARD_VID,
+    .idProduct          = USB_KEYBOARD_PID,
+    .bcdDevice          = 0x0100,
+    .iManufacturer      = USB_KEYBOARD_STR_MANUFACTURER,
+    .iProduct           = USB_KEYBOARD_STR_PRODUCT,
+    .iSerialNumber      = USB_KEYBOARD_STR_SERIAL,
+    .bNumConfigurations = 1,
+};
+
+static const uint8_t desc_hid_report[] = {
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_KEYBOARD),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+        // modifiers
+        HID_USAGE_PAGE(HID_USAGE_PAGE_KEYBOARD),
+        HID_USAGE_MIN(224),
+        HID_USAGE_MAX(231),
+        HID_LOGICAL_MIN(0),
+        HID_LOGICAL_MAX(1),
+        HID_REPORT_COUNT(8),
+        HID_REPORT_SIZE(1),
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+        // LEDs
+        HID_USAGE_PAGE(HID_USAGE_PAGE_LED),
+        HID_USAGE_MIN(1),
+        HID_USAGE_MAX(5),
+        HID_REPORT_COUNT(5),
+        HID_REPORT_SIZE(1),
+        HID_OUTPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+        HID_REPORT_COUNT(1),
+        HID_REPORT_SIZE(3),
+        HID_OUTPUT(HID_CONSTANT),
+        // a bit per usage
+        HID_USAGE_PAGE(HID_USAGE_PAGE_KEYBOARD),
+        HID_USAGE_MIN(0),
+        HID_USAGE_MAX_N(USB_KEYBOARD_NKRO_USAGES - 1, 2),
+        HID_LOGICAL_MIN(0),
+        HID_LOGICAL_MAX(1),
+        HID_REPORT_COUNT_N(USB_KEYBOARD_NKRO_USAGES, 2),
+        HID_REPORT_SIZE(1),
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_COLLECTION_END,
+};
+
+#define USB_KEYBOARD_CONFIG_LEN (TUD_CONFIG_DESC_LEN + TUD_HID_DESC_LEN)
+
+static const uint8_t desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, USB_KEYBOARD_ITF_NUM, 0, USB_KEYBOARD_CONFIG_LEN, TUSB_DESC_CONFIG_ATT_REMOTE_WAKEUP, 100),
+    TUD_HID_DESCRIPTOR(USB_KEYBOARD_ITF, 0, HID_ITF_PROTOCOL_KEYBOARD, sizeof(desc_hid_report), USB_KEYBOARD_EP_IN, CFG_TUD_HID_EP_BUFSIZE, 1),
+};
+
+static const char *desc_strings[] = {
+    [USB_KEYBOARD_STR_MANUFACTURER] = "koron",
+    [USB_KEYBOARD_STR_PRODUCT]      = "yuiop29re",
+    [USB_KEYBOARD_STR_SERIAL]       = "0",
+};
+
+__attribute__((weak)) void usb_keyboard_event(void) {}
+
+void usb_keyboard_port_init(void) {
+    tud_init(0);
+}
+
+void usb_keyboard_port_task(void) {
+    tud_task();
+}
+
+bool usb_keyboard_port_ready(void) {
+    return tud_hid_ready();
+}
+
+bool usb_keyboard_port_boot(void) {
+    return tud_hid_get_protocol() == HID_PROTOCOL_BOOT;
+}
+
+bool usb_keyboard_port_send(const void *report, uint16_t len) {
+    return tud_hid_report(0, report, len);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// TinyUSB callbacks
+
+void tud_event_hook_cb(uint8_t rhport, uint32_t eventid, bool in_isr) {
+    usb_keyboard_event();
+}
+
+const uint8_t *tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&desc_device;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index) {
+    return desc_configuration;
+}
+
+const uint8_t *tud_hid_descriptor_report_cb(uint8_t instance) {
+    return desc_hid_report;
+}
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    static uint16_t desc_str[32 + 1];
+    uint n;
+    if (index == USB_KEYBOARD_STR_LANGID) {
+        desc_str[1] = 0x0409;
+        n = 1;
+    } else {
+        if (index >= count_of(desc_strings) || desc_strings[index] == NULL) {
+            return NULL;
+        }
+        const char *s = desc_strings[index];
+        for (n = 0; n < count_of(desc_str) - 1 && s[n] != '\0'; n++) {
+            desc_str[1 + n] = s[n];
+        }
+    }
+    desc_str[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * n + 2));
+    return desc_str;
+}
+
+void tud_hid_set_protocol_cb(uint8_t instance, uint8_t protocol) {
+    usb_keyboard_resend(time_us_64());
+}
+
+void tud_hid_report_complete_cb(uint8_t instance, const uint8_t *report, uint16_t len) {
+    usb_keyboard_sent(time_us_64());
+}
+
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t *buffer, uint16_t reqlen) {
+    return 0;
+}
+
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, const uint8_t *buffer, uint16_t bufsize) {
+    // LED reports of the host are ignored.
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// TinyUSB configuration of usb_keyboard, a full speed device with a keyboard
+// interface.
+
+#ifndef CFG_TUSB_RHPORT0_MODE
+    #define CFG_TUSB_RHPORT0_MODE OPT_MODE_DEVICE
+#endif
+
+#ifndef CFG_TUSB_OS
+    #define CFG_TUSB_OS OPT_OS_PICO
+#endif
+
+#define CFG_TUD_ENABLED 1
+
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_HID 1
+#define CFG_TUD_CDC 0
+#define CFG_TUD_MSC 0
+#define CFG_TUD_MIDI 0
+#define CFG_TUD_VENDOR 0
+
+// fits usb_keyboard_nkro_report_t.
+#define CFG_TUD_HID_EP_BUFSIZE 32
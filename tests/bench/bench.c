@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+
+#include "pico/stdlib.h"
+
+#if PICO_ON_DEVICE
+#include "hardware/sync.h"
+#include "perf/probe.h"
+#else
+#include <time.h>
+#endif
+
+// On the target, runs are timed with interrupts disabled, so the numbers are
+// of the code alone. A run must be shorter than 2^24 cycles of SysTick.
+
+#if PICO_RP2350
+#define BENCH_PLATFORM "rp2350"
+#elif PICO_RP2040
+#define BENCH_PLATFORM "rp2040"
+#else
+#define BENCH_PLATFORM "host"
+#endif
+
+static uint32_t bench_samples[BENCH_ITERATIONS];
+static uint32_t bench_overhead = 0;
+static bool bench_calibrated = false;
+
+#if PICO_ON_DEVICE
+
+void bench_init(void) {
+    perf_probe_init();
+}
+
+const char *bench_unit(void) {
+    return "cycles";
+}
+
+static inline uint32_t bench_now(void) {
+    return perf_probe_now();
+}
+
+static inline uint32_t bench_elapsed(uint32_t start) {
+    return perf_probe_elapsed(start);
+}
+
+#else
+
+void bench_init(void) {
+}
+
+const char *bench_unit(void) {
+    return "ns";
+}
+
+static inline uint32_t bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec);
+}
+
+static inline uint32_t bench_elapsed(uint32_t start) {
+    return bench_now() - start;
+}
+
+#endif
+
+static int bench_compare(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void bench_nothing(uint i) {
+}
+
+static void bench_sample(const bench_case_t *c, bench_result_t *r) {
+    if (c->setup != NULL) {
+        c->setup();
+    }
+    // a run to warm up caches (XIP on the target), which is not counted.
+    if (c->prepare != NULL) {
+        c->prepare(0);
+    }
+    c->run(0);
+    for (uint i = 0; i < BENCH_ITERATIONS; i++) {
+        if (c->prepare != NULL) {
+            c->prepare(i);
+        }
+#if PICO_ON_DEVICE
+        uint32_t save = save_and_disable_interrupts();
+#endif
+        uint32_t start = bench_now();
+        c->run(i);
+        uint32_t elapsed = bench_elapsed(start);
+#if PICO_ON_DEVICE
+        restore_interrupts(save);
+#endif
+        bench_samples[i] = elapsed > bench_overhead ? elapsed - bench_overhead : 0;
+    }
+    qsort(bench_samples, BENCH_ITERATIONS, sizeof(bench_samples[0]), bench_compare);
+    r->min = bench_samples[0];
+    r->median = bench_samples[BENCH_ITERATIONS / 2];
+    r->max = bench_samples[BENCH_ITERATIONS - 1];
+}
+
+void bench_run(const bench_case_t *c, bench_result_t *r) {
+    if (!bench_calibrated) {
+        static const bench_case_t empty = { .name = "overhead", .run = bench_nothing };
+        bench_result_t o;
+        bench_sample(&empty, &o);
+        bench_overhead = o.min;
+        bench_calibrated = true;
+    }
+    bench_sample(c, r);
+}
+
+void bench_report(void) {
+    printf("{\"platform\": \"%s\", \"unit\": \"%s\", \"iterations\": %u, \"benchmarks\": [\n",
+            BENCH_PLATFORM, bench_unit(), BENCH_ITERATIONS);
+    for (uint i = 0; i < bench_cases_num; i++) {
+        const bench_case_t *c = &bench_cases[i];
+        bench_result_t r;
+        bench_run(c, &r);
+        printf("  {\"name\": \"%s\", \"min\": %lu, \"median\": %lu, \"max\": %lu}%s\n", c->name,
+                (unsigned long)r.min, (unsigned long)r.median, (unsigned long)r.max,
+                i + 1 < bench_cases_num ? "," : "");
+    }
+    printf("]}\n");
+}
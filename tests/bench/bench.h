@@ -0,0 +1,58 @@
+#pragma once
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Number of timed runs of each case. The median of them is reported.
+#ifndef BENCH_ITERATIONS
+    #define BENCH_ITERATIONS 101
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+#include <pico/types.h>
+
+// A case of the suite. prepare sets up inputs of the i-th run, and only run
+// is timed. setup and prepare may be NULL.
+typedef struct {
+    const char *name;
+    void (*setup)(void);
+    void (*prepare)(uint i);
+    void (*run)(uint i);
+} bench_case_t;
+
+typedef struct {
+    uint32_t min;
+    uint32_t median;
+    uint32_t max;
+} bench_result_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Variables
+
+extern const bench_case_t bench_cases[];
+extern const uint bench_cases_num;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+// bench_init starts the clock. It counts CPU cycles by SysTick on the
+// target, and nanoseconds of CLOCK_MONOTONIC on the host.
+void bench_init(void);
+
+// bench_unit returns "cycles" or "ns".
+const char *bench_unit(void);
+
+// bench_run times BENCH_ITERATIONS runs of a case, less the overhead of
+// reading the clock.
+void bench_run(const bench_case_t *c, bench_result_t *r);
+
+// bench_report runs all cases, and prints results as a JSON object, a case
+// per line:
+//
+//     {"platform": "rp2040", "unit": "cycles", "iterations": 101, "benchmarks": [
+//       {"name": "sm_scan_switches/0", "min": 1180, "median": 1184, "max": 1420},
+//       ...
+//     ]}
+void bench_report(void);
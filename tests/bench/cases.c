@@ -0,0 +1,331 @@
+#include <string.h>
+
+#include "bench.h"
+
+#include "pico/stdlib.h"
+#include "driver/rotary_encoder.h"
+#include "driver/ssd1306.h"
+#include "driver/switch_matrix.h"
+#include "driver/ws2812_array.h"
+#include "driver/ws2812_color.h"
+#include "gfx/mono.h"
+#include "led/effect.h"
+#include "led/matrix.h"
+
+#include "gfx_font_5x7.h"
+#include "keymap_yuiop29re.h"
+
+// Cases run the hot paths of testfirm on fixed inputs. Time passed to them
+// is bench_time, which each prepare moves forward, so debouncing and frame
+// intervals never skip a run.
+
+#ifndef ROTALY_ENCODER_1_PIN_A
+#define ROTALY_ENCODER_1_PIN_A 2
+#endif
+#ifndef ROTALY_ENCODER_1_PIN_B
+#define ROTALY_ENCODER_1_PIN_B 3
+#endif
+
+static uint64_t bench_time = 0;
+
+//////////////////////////////////////////////////////////////////////////////
+// switch_matrix_task (sm_scan_switches)
+
+// Switches are open, so the first sm_changing states set on are scanned as
+// released, which is the path of a change. Changes are taken by callbacks
+// which do nothing, instead of the log ring of the default ones.
+static void sm_changed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on) {
+}
+
+static void sm_suppressed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on, uint64_t last_changed) {
+}
+
+static switch_matrix_t sm = {
+    .num        = KEYMAP_YUIOP29RE_NUM_KEYS,
+    .states     = keymap_yuiop29re_sm_states,
+    .changed    = sm_changed,
+    .suppressed = sm_suppressed,
+};
+static uint sm_changing;
+
+static void sm_setup(uint changing) {
+    switch_matrix_init(&sm);
+    sm_changing = changing;
+}
+
+static void sm_setup_0(void) {
+    sm_setup(0);
+}
+
+static void sm_setup_1(void) {
+    sm_setup(1);
+}
+
+static void sm_setup_10(void) {
+    sm_setup(10);
+}
+
+static void sm_prepare(uint i) {
+    bench_time += 1000 * 1000;
+    for (uint k = 0; k < sm_changing; k++) {
+        keymap_yuiop29re_sm_states[k].on = true;
+    }
+}
+
+static void sm_run(uint i) {
+    switch_matrix_task(&sm, bench_time);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// sm_fixed_task (sm_scan_fixed)
+
+// switch_matrix_fixed for the same matrix, defined in matrix.cpp, and scanned
+// as sm is.
+SWITCH_MATRIX_FIXED_DECLARE(sm_fixed)
+void sm_fixed_set_on(uint n);
+
+static switch_matrix_t sm_f = {
+    .changed    = sm_changed,
+    .suppressed = sm_suppressed,
+};
+
+static void sm_fixed_setup(uint changing) {
+    sm_fixed_init(&sm_f);
+    sm_changing = changing;
+}
+
+static void sm_fixed_setup_0(void) {
+    sm_fixed_setup(0);
+}
+
+static void sm_fixed_setup_1(void) {
+    sm_fixed_setup(1);
+}
+
+static void sm_fixed_setup_10(void) {
+    sm_fixed_setup(10);
+}
+
+static void sm_fixed_prepare(uint i) {
+    bench_time += 1000 * 1000;
+    sm_fixed_set_on(sm_changing);
+}
+
+static void sm_fixed_run(uint i) {
+    sm_fixed_task(&sm_f, bench_time);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// rotary_encoder_task
+
+static rotary_encoder_t re;
+static uint8_t re_history;
+
+static void re_setup_idle(void) {
+    rotary_encoder_init(&re, ROTALY_ENCODER_1_PIN_A, ROTALY_ENCODER_1_PIN_B);
+    re_history = 0;
+}
+
+// The pins are released (word 0) after 3 and 2 of a clockwise detent.
+static void re_setup_detent(void) {
+    rotary_encoder_init(&re, ROTALY_ENCODER_1_PIN_A, ROTALY_ENCODER_1_PIN_B);
+    re_history = 0x0e;
+}
+
+static void re_prepare(uint i) {
+    bench_time += 1000;
+    re.history = re_history;
+}
+
+static void re_run(uint i) {
+    rotary_encoder_task(&re, bench_time);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ws2812_array_apply_autocap
+
+static ws2812_state_t autocap_in[WS2812_ARRAY_NUM];
+static ws2812_state_t autocap_buf[WS2812_ARRAY_NUM];
+
+// All white exceeds the limit, and is scaled.
+static void autocap_setup_over(void) {
+    for (int i = 0; i < WS2812_ARRAY_NUM; i++) {
+        autocap_in[i].rgb = (ws2812_color_t){ .r = 255, .g = 255, .b = 255 };
+    }
+}
+
+// A rainbow is within the limit, and only summed.
+static void autocap_setup_under(void) {
+    for (int i = 0; i < WS2812_ARRAY_NUM; i++) {
+        uint8_t v = i * 255 / WS2812_ARRAY_NUM;
+        autocap_in[i].rgb = (ws2812_color_t){ .r = v, .g = 255 - v, .b = 0 };
+    }
+}
+
+static void autocap_prepare(uint i) {
+    memcpy(autocap_buf, autocap_in, sizeof(autocap_buf));
+}
+
+static void autocap_run(uint i) {
+    ws2812_array_apply_autocap(autocap_buf, WS2812_ARRAY_NUM);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ws2812_color_scale
+
+// Scaling of all white down to a third, by both kernels of
+// ws2812_color_scale. The ratio is set at run time, as a total is, so that
+// divisions are not folded.
+static uint32_t scale_num, scale_den;
+
+static void scale_setup(void) {
+    autocap_setup_over();
+    scale_num = WS2812_ARRAY_NUM * 255;
+    scale_den = WS2812_ARRAY_NUM * 255 * 3;
+}
+
+static void scale_run_divide(uint i) {
+    ws2812_color_scale_divide_kernel(autocap_buf, WS2812_ARRAY_NUM, scale_num, scale_den);
+}
+
+static void scale_run_factor(uint i) {
+    ws2812_color_scale_factor_kernel(autocap_buf, WS2812_ARRAY_NUM, scale_num, scale_den);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// led_matrix_task
+
+static led_effect_push_t led_effects[LED_MATRIX_PROVIDERS_MAX];
+static uint led_effects_num;
+
+static void led_setup(uint num, led_matrix_get_color_cb fn) {
+    led_matrix_init(keymap_yuiop29re_led_positions, KEYMAP_YUIOP29RE_NUM_LEDS);
+    for (int i = 0; i < LED_MATRIX_PROVIDERS_MAX; i++) {
+        led_matrix_provider_remove(i);
+    }
+    led_effects_num = num;
+    for (uint k = 0; k < num; k++) {
+        led_effects[k] = (led_effect_push_t){ .led_index = k % KEYMAP_YUIOP29RE_NUM_LEDS };
+        led_matrix_provider_add(led_effect_push, &led_effects[k]);
+    }
+    if (fn != NULL) {
+        led_matrix_provider_add(fn, NULL);
+    }
+}
+
+static void led_setup_0(void) {
+    led_setup(0, NULL);
+}
+
+static void led_setup_5(void) {
+    led_setup(5, NULL);
+}
+
+static void led_setup_29(void) {
+    led_setup(29, NULL);
+}
+
+static void led_setup_rainbow(void) {
+    led_setup(0, led_effect_vertical_rainbow);
+}
+
+// Effects are in the middle of fading out.
+static void led_prepare(uint i) {
+    bench_time += LED_MATRIX_INTERVAL_US;
+    for (uint k = 0; k < led_effects_num; k++) {
+        led_effects[k].start = bench_time - 200 * 1000;
+    }
+}
+
+static void led_run(uint i) {
+    led_matrix_task(bench_time);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// gfx_mono_draw_string
+
+static uint8_t canvas_buf[SSD1306_BUF_LEN(128, 32)];
+static gfx_mono_t canvas;
+
+static const char text[] = "RE sum 12 at 34.56 s";
+
+static void text_setup(void) {
+    gfx_mono_init(&canvas, canvas_buf, 128, 32);
+}
+
+// A line on a page.
+static void text_run_aligned(uint i) {
+    gfx_mono_draw_string(&canvas, 0, 24, &gfx_font_5x7, text, GFX_MONO_COPY);
+}
+
+// A line across pages, each glyph is shifted into two.
+static void text_run_unaligned(uint i) {
+    gfx_mono_draw_string(&canvas, 3, 13, &gfx_font_5x7, text, GFX_MONO_COPY);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// ssd1306_render_diff_async
+
+static uint8_t oled_fb[SSD1306_BUF_PREFIX_LEN + SSD1306_BUF_LEN(128, 32)];
+static uint8_t oled_shadow[SSD1306_BUF_LEN(128, 32)];
+
+static ssd1306_t oled = {
+    .i2c    = i2c_default,
+    .addr   = SSD1306_I2C_ADDR,
+    .width  = 128,
+    .height = 32,
+    .fb     = oled_fb,
+    .shadow = oled_shadow,
+};
+
+static void oled_setup(void) {
+    i2c_init(i2c_default, 400 * 1000);
+    gpio_set_function(PICO_DEFAULT_I2C_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(PICO_DEFAULT_I2C_SDA_PIN);
+    gpio_pull_up(PICO_DEFAULT_I2C_SCL_PIN);
+    ssd1306_init(&oled);
+}
+
+// A span of 32 columns is changed in a page, and packed into the DMA buffer
+// with the window commands.
+static void oled_prepare(uint i) {
+    while (ssd1306_busy(&oled)) {
+        sleep_us(10);
+    }
+    uint8_t *b = oled.buf + (i % 4) * oled.width + 10;
+    for (int x = 0; x < 32; x++) {
+        b[x] = ~b[x];
+    }
+}
+
+static void oled_run(uint i) {
+    ssd1306_render_diff_async(&oled);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Suite
+
+const bench_case_t bench_cases[] = {
+    { "sm_scan_switches/0",             sm_setup_0,             sm_prepare,         sm_run },
+    { "sm_scan_switches/1",             sm_setup_1,             sm_prepare,         sm_run },
+    { "sm_scan_switches/10",            sm_setup_10,            sm_prepare,         sm_run },
+    { "sm_scan_fixed/0",                sm_fixed_setup_0,       sm_fixed_prepare,   sm_fixed_run },
+    { "sm_scan_fixed/1",                sm_fixed_setup_1,       sm_fixed_prepare,   sm_fixed_run },
+    { "sm_scan_fixed/10",               sm_fixed_setup_10,      sm_fixed_prepare,   sm_fixed_run },
+    { "rotary_encoder_task/idle",       re_setup_idle,          re_prepare,         re_run },
+    { "rotary_encoder_task/detent",     re_setup_detent,        re_prepare,         re_run },
+    { "apply_autocap/under",            autocap_setup_under,    autocap_prepare,    autocap_run },
+    { "apply_autocap/over",             autocap_setup_over,     autocap_prepare,    autocap_run },
+    { "color_scale/divide",             scale_setup,            autocap_prepare,    scale_run_divide },
+    { "color_scale/factor",             scale_setup,            autocap_prepare,    scale_run_factor },
+    { "led_matrix_task/0",              led_setup_0,            led_prepare,        led_run },
+    { "led_matrix_task/5",              led_setup_5,            led_prepare,        led_run },
+    { "led_matrix_task/29",             led_setup_29,           led_prepare,        led_run },
+    { "led_matrix_task/rainbow",        led_setup_rainbow,      led_prepare,        led_run },
+    { "draw_string/aligned",            text_setup,             NULL,               text_run_aligned },
+    { "draw_string/unaligned",          text_setup,             NULL,               text_run_unaligned },
+    { "render_diff/span",               oled_setup,             oled_prepare,       oled_run },
+};
+
+const uint bench_cases_num = count_of(bench_cases);
@@ -0,0 +1,30 @@
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+
+#include "bench.h"
+
+#if !PICO_ON_DEVICE
+#include "sim.h"
+#endif
+
+// bench runs the suite and prints the results as JSON. On the target it runs
+// again every 10 seconds, so a terminal opened late still catches one.
+
+int main() {
+#if PICO_ON_DEVICE
+    stdio_init_all();
+    sleep_ms(2000);
+#else
+    sim_reset();
+#endif
+    bench_init();
+    while (true) {
+        bench_report();
+#if PICO_ON_DEVICE
+        sleep_ms(10 * 1000);
+#else
+        return 0;
+#endif
+    }
+}
@@ -0,0 +1,18 @@
+#include "driver/switch_matrix.hpp"
+
+#include "keymap_yuiop29re.h"
+
+// The switch matrix of the keymap for switch_matrix_fixed, timed by cases.c
+// along with switch_matrix_task.
+
+static constexpr switch_matrix_pin_t sm_pins[] = KEYMAP_YUIOP29RE_PINS;
+
+SWITCH_MATRIX_FIXED_DEFINE(sm_fixed, sm_pins)
+
+// sm_fixed_set_on sets the first n states on, as cases.c does to states of
+// switch_matrix_t.
+extern "C" void sm_fixed_set_on(uint n) {
+    for (uint k = 0; k < n; k++) {
+        sm_fixed_matrix.set_on(k, true);
+    }
+}
@@ -0,0 +1,201 @@
+#include <string.h>
+
+#include "gfx/mono.h"
+
+#include "test.h"
+
+// A canvas of 16x16 pixels, 2 pages of 16 bytes.
+
+static uint8_t buf[16 * 2];
+static gfx_mono_t g;
+
+static void reset(bool on) {
+    gfx_mono_init(&g, buf, 16, 16);
+    gfx_mono_clear(&g, on);
+}
+
+static uint8_t at(int page, int x) {
+    return buf[page * 16 + x];
+}
+
+// count_set returns the number of bytes which are not 0.
+static int count_set(void) {
+    int n = 0;
+    for (int i = 0; i < sizeof(buf); i++) {
+        n += buf[i] != 0;
+    }
+    return n;
+}
+
+// A rectangle across pages takes the top bits of the first page and the
+// bottom bits of the last one.
+static void test_fill_rect(void) {
+    reset(false);
+    gfx_mono_fill_rect(&g, 2, 3, 3, 10, true);
+    for (int x = 2; x < 5; x++) {
+        TEST_ASSERT_EQ(0xf8, at(0, x));
+        TEST_ASSERT_EQ(0x1f, at(1, x));
+    }
+    TEST_ASSERT_EQ(6, count_set());
+
+    gfx_mono_fill_rect(&g, 3, 4, 1, 8, false);
+    TEST_ASSERT_EQ(0x08, at(0, 3));
+    TEST_ASSERT_EQ(0x10, at(1, 3));
+}
+
+static void test_fill_rect_clip(void) {
+    reset(false);
+    gfx_mono_fill_rect(&g, -2, -4, 4, 6, true);
+    TEST_ASSERT_EQ(0x03, at(0, 0));
+    TEST_ASSERT_EQ(0x03, at(0, 1));
+    TEST_ASSERT_EQ(2, count_set());
+
+    reset(false);
+    gfx_mono_fill_rect(&g, 14, 12, 10, 10, true);
+    TEST_ASSERT_EQ(0xf0, at(1, 14));
+    TEST_ASSERT_EQ(0xf0, at(1, 15));
+    TEST_ASSERT_EQ(2, count_set());
+
+    reset(false);
+    gfx_mono_fill_rect(&g, 16, 0, 4, 4, true);
+    gfx_mono_fill_rect(&g, 0, -8, 4, 8, true);
+    TEST_ASSERT_EQ(0, count_set());
+}
+
+static const uint8_t bitmap[] = { 0x81, 0x42, 0xff };
+
+static void test_blit_aligned(void) {
+    reset(false);
+    gfx_mono_blit(&g, 5, 8, bitmap, 3, 8, GFX_MONO_COPY);
+    TEST_ASSERT_EQ(0x81, at(1, 5));
+    TEST_ASSERT_EQ(0x42, at(1, 6));
+    TEST_ASSERT_EQ(0xff, at(1, 7));
+    TEST_ASSERT_EQ(3, count_set());
+}
+
+// Each column is shifted by y % 8 into two pages.
+static void test_blit_unaligned(void) {
+    reset(false);
+    gfx_mono_blit(&g, 5, 3, bitmap, 3, 8, GFX_MONO_OR);
+    TEST_ASSERT_EQ(0x08, at(0, 5));
+    TEST_ASSERT_EQ(0x04, at(1, 5));
+    TEST_ASSERT_EQ(0x10, at(0, 6));
+    TEST_ASSERT_EQ(0x02, at(1, 6));
+    TEST_ASSERT_EQ(0xf8, at(0, 7));
+    TEST_ASSERT_EQ(0x07, at(1, 7));
+    TEST_ASSERT_EQ(6, count_set());
+
+    // COPY overwrites only the rows of the bitmap.
+    static const uint8_t blank[] = { 0x00 };
+    reset(true);
+    gfx_mono_blit(&g, 0, 3, blank, 1, 8, GFX_MONO_COPY);
+    TEST_ASSERT_EQ(0x07, at(0, 0));
+    TEST_ASSERT_EQ(0xf8, at(1, 0));
+
+    // Rows below the height are not drawn.
+    reset(false);
+    gfx_mono_blit(&g, 0, 6, &bitmap[2], 1, 3, GFX_MONO_OR);
+    TEST_ASSERT_EQ(0xc0, at(0, 0));
+    TEST_ASSERT_EQ(0x01, at(1, 0));
+
+    reset(true);
+    gfx_mono_blit(&g, 0, 6, &bitmap[2], 1, 3, GFX_MONO_XOR);
+    TEST_ASSERT_EQ(0x3f, at(0, 0));
+    TEST_ASSERT_EQ(0xfe, at(1, 0));
+}
+
+static void test_blit_clip(void) {
+    // The top page is off the canvas, and the first column too.
+    reset(false);
+    gfx_mono_blit(&g, -1, -3, bitmap, 3, 8, GFX_MONO_OR);
+    TEST_ASSERT_EQ(0x08, at(0, 0));
+    TEST_ASSERT_EQ(0x1f, at(0, 1));
+    TEST_ASSERT_EQ(2, count_set());
+
+    // The bottom page and the last column are off the canvas.
+    reset(false);
+    gfx_mono_blit(&g, 14, 12, bitmap, 3, 8, GFX_MONO_OR);
+    TEST_ASSERT_EQ(0x10, at(1, 14));
+    TEST_ASSERT_EQ(0x20, at(1, 15));
+    TEST_ASSERT_EQ(2, count_set());
+
+    reset(false);
+    gfx_mono_blit(&g, 16, 0, bitmap, 3, 8, GFX_MONO_OR);
+    gfx_mono_blit(&g, -3, 0, bitmap, 3, 8, GFX_MONO_OR);
+    gfx_mono_blit(&g, 0, 16, bitmap, 3, 8, GFX_MONO_OR);
+    TEST_ASSERT_EQ(0, count_set());
+}
+
+// A font of 'A' to 'C', which are 1 to 3 columns wide.
+static const uint16_t font_offsets[] = { 0, 1, 3 };
+static const uint8_t font_widths[] = { 1, 2, 3 };
+static const uint8_t font_bitmaps[] = {
+    0x01,
+    0x03, 0x03,
+    0xe0, 0xe0, 0xe0,
+};
+static const gfx_font_t font = {
+    .height  = 8,
+    .first   = 'A',
+    .last    = 'C',
+    .spacing = 1,
+    .offsets = font_offsets,
+    .widths  = font_widths,
+    .bitmaps = font_bitmaps,
+};
+
+// Glyphs advance by their width and the spacing.
+static void test_draw_string(void) {
+    reset(false);
+    TEST_ASSERT_EQ(9, gfx_mono_draw_string(&g, 0, 0, &font, "ABC", GFX_MONO_OR));
+    TEST_ASSERT_EQ(9, gfx_font_text_width(&font, "ABC"));
+    static const uint8_t want[] = { 0x01, 0, 0x03, 0x03, 0, 0xe0, 0xe0, 0xe0, 0 };
+    for (int x = 0; x < sizeof(want); x++) {
+        TEST_ASSERT_EQ(want[x], at(0, x));
+    }
+
+    // Characters out of the font are drawn as the first glyph, as it has no '?'.
+    reset(false);
+    TEST_ASSERT_EQ(3, gfx_mono_draw_string(&g, 1, 0, &font, "z", GFX_MONO_OR));
+    TEST_ASSERT_EQ(0x01, at(0, 1));
+
+    // The string stops at the right edge.
+    reset(false);
+    TEST_ASSERT_EQ(18, gfx_mono_draw_string(&g, 14, 0, &font, "CCC", GFX_MONO_OR));
+    TEST_ASSERT_EQ(0xe0, at(0, 14));
+    TEST_ASSERT_EQ(0xe0, at(0, 15));
+}
+
+static void test_draw_string_unaligned(void) {
+    reset(false);
+    TEST_ASSERT_EQ(9, gfx_mono_draw_string(&g, 0, 4, &font, "ABC", GFX_MONO_OR));
+    TEST_ASSERT_EQ(0x10, at(0, 0));
+    TEST_ASSERT_EQ(0x00, at(1, 0));
+    TEST_ASSERT_EQ(0x30, at(0, 2));
+    TEST_ASSERT_EQ(0x00, at(0, 5));
+    TEST_ASSERT_EQ(0x0e, at(1, 5));
+    TEST_ASSERT_EQ(6, count_set());
+}
+
+// In COPY mode the spacing after a glyph is cleared.
+static void test_draw_char_copy(void) {
+    reset(true);
+    TEST_ASSERT_EQ(3, gfx_mono_draw_char(&g, 0, 4, &font, 'B', GFX_MONO_COPY));
+    TEST_ASSERT_EQ(0x3f, at(0, 0));
+    TEST_ASSERT_EQ(0xf0, at(1, 0));
+    TEST_ASSERT_EQ(0x0f, at(0, 2));
+    TEST_ASSERT_EQ(0xf0, at(1, 2));
+    TEST_ASSERT_EQ(0xff, at(0, 3));
+}
+
+int main(void) {
+    TEST_RUN(test_fill_rect);
+    TEST_RUN(test_fill_rect_clip);
+    TEST_RUN(test_blit_aligned);
+    TEST_RUN(test_blit_unaligned);
+    TEST_RUN(test_blit_clip);
+    TEST_RUN(test_draw_string);
+    TEST_RUN(test_draw_string_unaligned);
+    TEST_RUN(test_draw_char_copy);
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <string.h>
+
+#include "driver/i2c_dma.h"
+
+#include "sim.h"
+#include "test.h"
+
+// Transactions written by DMA to i2c0, and completed by the I2C IRQ.
+
+static uint16_t buf[8];
+static uint completed_count;
+static bool completed_ok;
+
+static void on_completed(i2c_dma_t *d, bool ok) {
+    completed_count++;
+    completed_ok = ok;
+}
+
+static i2c_dma_t d = {
+    .completed = on_completed,
+};
+
+static void test_transaction(void) {
+    static const uint8_t data[] = { 0x40, 0x01, 0x02, 0x03 };
+    uint n = sim_i2c_count();
+    TEST_ASSERT(i2c_dma_begin(&d));
+    i2c_dma_put_buf(&d, data, sizeof(data));
+    i2c_dma_put(&d, 0x04);
+    TEST_ASSERT(i2c_dma_start(&d, 0x3c));
+    TEST_ASSERT(i2c_dma_busy(&d));
+    TEST_ASSERT(!i2c_dma_begin(&d));
+    TEST_ASSERT(!i2c_dma_start(&d, 0x3c));
+
+    sim_advance(5 * SIM_I2C_BYTE_US);
+    TEST_ASSERT(!i2c_dma_busy(&d));
+    TEST_ASSERT_EQ(1, completed_count);
+    TEST_ASSERT(completed_ok);
+    TEST_ASSERT_EQ(n + 1, sim_i2c_count());
+    const sim_i2c_transaction_t *t = sim_i2c_get(0);
+    TEST_ASSERT_EQ(0x3c, t->addr);
+    TEST_ASSERT(!t->aborted);
+    TEST_ASSERT_EQ(5, t->len);
+    TEST_ASSERT(memcmp(t->data, data, sizeof(data)) == 0);
+    TEST_ASSERT_EQ(0x04, t->data[4]);
+}
+
+// A missing device fails the transaction, and the next one works.
+static void test_nack(void) {
+    completed_count = 0;
+    sim_i2c_nack(0x3d, true);
+    TEST_ASSERT(i2c_dma_begin(&d));
+    i2c_dma_put(&d, 0x00);
+    TEST_ASSERT(i2c_dma_start(&d, 0x3d));
+    sim_advance(100);
+    TEST_ASSERT_EQ(1, completed_count);
+    TEST_ASSERT(!completed_ok);
+    TEST_ASSERT(sim_i2c_get(0)->aborted);
+    TEST_ASSERT(d.failed);
+
+    TEST_ASSERT(i2c_dma_begin(&d));
+    i2c_dma_put(&d, 0x00);
+    TEST_ASSERT(i2c_dma_start(&d, 0x3c));
+    sim_advance(100);
+    TEST_ASSERT_EQ(2, completed_count);
+    TEST_ASSERT(completed_ok);
+    sim_i2c_nack(0x3d, false);
+}
+
+// Nothing is written when nothing is queued, or the buffer overflowed.
+static void test_overflow(void) {
+    uint n = sim_i2c_count();
+    TEST_ASSERT(i2c_dma_begin(&d));
+    TEST_ASSERT(!i2c_dma_start(&d, 0x3c));
+    static const uint8_t data[count_of(buf) + 1] = {0};
+    i2c_dma_put_buf(&d, data, sizeof(data));
+    TEST_ASSERT_EQ(sizeof(data), d.len);
+    TEST_ASSERT(!i2c_dma_start(&d, 0x3c));
+    TEST_ASSERT(!i2c_dma_busy(&d));
+    sim_advance(1000);
+    TEST_ASSERT_EQ(n, sim_i2c_count());
+}
+
+// Blocking writes of hardware_i2c work between transactions.
+static void test_blocking(void) {
+    static const uint8_t data[] = { 0x00, 0xaf };
+    uint n = sim_i2c_count();
+    TEST_ASSERT_EQ(2, i2c_write_blocking(i2c0, 0x3c, data, sizeof(data), false));
+    TEST_ASSERT_EQ(n + 1, sim_i2c_count());
+    TEST_ASSERT_EQ(0xaf, sim_i2c_get(0)->data[1]);
+}
+
+int main(void) {
+    sim_reset();
+    i2c_init(i2c0, 400 * 1000);
+    i2c_dma_init(&d, i2c0, buf, count_of(buf));
+
+    TEST_RUN(test_transaction);
+    TEST_RUN(test_nack);
+    TEST_RUN(test_overflow);
+    TEST_RUN(test_blocking);
+    return 0;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// A subset of hardware/address_mapped.h of the Pico SDK, for libraries built
+// into host tests. Registers are plain memory of sim.c, and read-only ones
+// are writable for it to set them.
+
+#include "pico.h"
+
+typedef volatile uint32_t io_rw_32;
+typedef volatile uint32_t io_ro_32;
+typedef volatile uint32_t io_wo_32;
@@ -0,0 +1,24 @@
+#pragma once
+
+// A subset of hardware/clocks.h of the Pico SDK, for libraries built into host
+// tests.
+
+#include "pico.h"
+
+enum clock_index {
+    clk_gpout0 = 0,
+    clk_gpout1,
+    clk_gpout2,
+    clk_gpout3,
+    clk_ref,
+    clk_sys,
+    clk_peri,
+    clk_usb,
+    clk_adc,
+    clk_rtc,
+    CLK_COUNT
+};
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index) {
+    return clk_index == clk_sys ? 125000000 : 48000000;
+}
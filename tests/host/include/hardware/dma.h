@@ -0,0 +1,94 @@
+#pragma once
+
+// A subset of hardware/dma.h of the Pico SDK, for libraries built into host
+// tests. A transfer completes after the time its peripheral would take (see
+// sim.h), and raises the IRQ of the channel. ints0 and ints1 are cleared for
+// the channel after the handler returns, as writing them would do.
+
+#include "hardware/address_mapped.h"
+#include "hardware/irq.h"
+
+#define NUM_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size {
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+typedef struct {
+    enum dma_channel_transfer_size size;
+    bool read_increment;
+    bool write_increment;
+    uint dreq;
+} dma_channel_config;
+
+typedef struct {
+    io_rw_32 intr;
+    io_rw_32 inte0;
+    io_rw_32 intf0;
+    io_rw_32 ints0;
+    io_rw_32 inte1;
+    io_rw_32 intf1;
+    io_rw_32 ints1;
+} dma_hw_t;
+
+extern dma_hw_t sim_dma_hw;
+
+#define dma_hw (&sim_dma_hw)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int dma_claim_unused_channel(bool required);
+
+void dma_channel_unclaim(uint channel);
+
+static inline dma_channel_config dma_channel_get_default_config(uint channel) {
+    (void)channel;
+    dma_channel_config c = {
+        .size = DMA_SIZE_32,
+        .read_increment = true,
+        .write_increment = false,
+        .dreq = 0x3f,
+    };
+    return c;
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size) {
+    c->size = size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) {
+    c->read_increment = incr;
+}
+
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) {
+    c->write_increment = incr;
+}
+
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) {
+    c->dreq = dreq;
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+        const volatile void *read_addr, uint transfer_count, bool trigger);
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger);
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger);
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count);
+
+void dma_channel_abort(uint channel);
+
+bool dma_channel_is_busy(uint channel);
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,78 @@
+#pragma once
+
+// A subset of hardware/gpio.h of the Pico SDK, for libraries built into host
+// tests. Pins are modeled by sim.c (see sim.h).
+
+#include "pico.h"
+
+#define NUM_BANK0_GPIOS 30
+
+enum gpio_dir {
+    GPIO_IN = 0,
+    GPIO_OUT = 1,
+};
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void gpio_init(uint gpio);
+
+void gpio_init_mask(uint gpio_mask);
+
+void gpio_set_function(uint gpio, enum gpio_function fn);
+
+void gpio_set_pulls(uint gpio, bool up, bool down);
+
+static inline void gpio_pull_up(uint gpio) {
+    gpio_set_pulls(gpio, true, false);
+}
+
+static inline void gpio_pull_down(uint gpio) {
+    gpio_set_pulls(gpio, false, true);
+}
+
+static inline void gpio_disable_pulls(uint gpio) {
+    gpio_set_pulls(gpio, false, false);
+}
+
+void gpio_set_dir_masked(uint32_t mask, uint32_t value);
+
+static inline void gpio_set_dir_out_masked(uint32_t mask) {
+    gpio_set_dir_masked(mask, mask);
+}
+
+static inline void gpio_set_dir_in_masked(uint32_t mask) {
+    gpio_set_dir_masked(mask, 0);
+}
+
+static inline void gpio_set_dir(uint gpio, bool out) {
+    gpio_set_dir_masked(1u << gpio, out ? 1u << gpio : 0);
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value);
+
+static inline void gpio_put(uint gpio, bool value) {
+    gpio_put_masked(1u << gpio, value ? 1u << gpio : 0);
+}
+
+uint32_t gpio_get_all(void);
+
+static inline bool gpio_get(uint gpio) {
+    return (gpio_get_all() >> gpio) & 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
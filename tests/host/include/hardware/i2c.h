@@ -0,0 +1,76 @@
+#pragma once
+
+// A subset of hardware/i2c.h of the Pico SDK, for libraries built into host
+// tests. Bytes written to IC_DATA_CMD make transactions, which end at STOP
+// and are captured by sim.c (see sim.h). raw_intr_stat always has STOP_DET,
+// as the simulated bus is never behind. Read-only registers are writable, for
+// sim.c to set them.
+
+#include "hardware/address_mapped.h"
+
+#define NUM_I2CS 2
+
+#define DREQ_I2C0_TX 32
+#define DREQ_I2C1_TX 34
+
+#define I2C_IC_DATA_CMD_STOP_BITS           0x00000200
+#define I2C_IC_DATA_CMD_RESTART_BITS        0x00000400
+#define I2C_IC_INTR_STAT_R_TX_ABRT_BITS     0x00000040
+#define I2C_IC_INTR_STAT_R_STOP_DET_BITS    0x00000200
+#define I2C_IC_INTR_MASK_M_TX_ABRT_BITS     0x00000040
+#define I2C_IC_INTR_MASK_M_STOP_DET_BITS    0x00000200
+#define I2C_IC_RAW_INTR_STAT_STOP_DET_BITS  0x00000200
+#define I2C_IC_DMA_CR_TDMAE_BITS            0x00000002
+
+typedef struct {
+    io_rw_32 tar;
+    io_rw_32 data_cmd;
+    io_rw_32 intr_stat;
+    io_rw_32 intr_mask;
+    io_rw_32 raw_intr_stat;
+    io_rw_32 clr_tx_abrt;
+    io_rw_32 clr_stop_det;
+    io_rw_32 enable;
+    io_rw_32 dma_cr;
+} i2c_hw_t;
+
+typedef struct i2c_inst {
+    i2c_hw_t *hw;
+    bool restart_on_next;
+} i2c_inst_t;
+
+extern i2c_inst_t sim_i2c_inst[NUM_I2CS];
+
+#define i2c0 (&sim_i2c_inst[0])
+#define i2c1 (&sim_i2c_inst[1])
+
+#ifndef i2c_default
+#define i2c_default i2c0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+
+static inline uint i2c_get_index(i2c_inst_t *i2c) {
+    return i2c == i2c1 ? 1 : 0;
+}
+
+// i2c_get_hw captures a byte written to IC_DATA_CMD since the last call.
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c);
+
+static inline uint i2c_get_dreq(i2c_inst_t *i2c, bool is_tx) {
+    return (i2c == i2c1 ? DREQ_I2C1_TX : DREQ_I2C0_TX) + (is_tx ? 0 : 1);
+}
+
+// i2c_get_write_available captures a byte written to IC_DATA_CMD since the
+// last call, and returns the depth of TX FIFO.
+size_t i2c_get_write_available(i2c_inst_t *i2c);
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+
+#ifdef __cplusplus
+}
+#endif
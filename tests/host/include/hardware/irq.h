@@ -0,0 +1,25 @@
+#pragma once
+
+// A subset of hardware/irq.h of the Pico SDK, for libraries built into host
+// tests. Handlers are called by sim.c when their events are due.
+
+#include "pico.h"
+
+#define DMA_IRQ_0   11
+#define DMA_IRQ_1   12
+#define I2C0_IRQ    23
+#define I2C1_IRQ    24
+
+typedef void (*irq_handler_t)(void);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+
+void irq_set_enabled(uint num, bool enabled);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,138 @@
+#pragma once
+
+// A subset of hardware/pio.h of the Pico SDK, for libraries built into host
+// tests. Programs are not run: words DMA writes to a TX FIFO are captured as
+// a frame (see sim.h), and the rest only keeps the configuration.
+
+#include "hardware/address_mapped.h"
+#include "hardware/gpio.h"
+
+#define NUM_PIOS 2
+#define NUM_PIO_STATE_MACHINES 4
+
+#define DREQ_PIO0_TX0 0
+#define DREQ_PIO1_TX0 8
+
+enum pio_fifo_join {
+    PIO_FIFO_JOIN_NONE = 0,
+    PIO_FIFO_JOIN_TX = 1,
+    PIO_FIFO_JOIN_RX = 2,
+};
+
+typedef struct {
+    io_wo_32 txf[NUM_PIO_STATE_MACHINES];
+    io_rw_32 rxf[NUM_PIO_STATE_MACHINES];
+    uint32_t claimed;
+    uint32_t enabled;
+    uint program_len;
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t sim_pio_hw[NUM_PIOS];
+
+#define pio0 (&sim_pio_hw[0])
+#define pio1 (&sim_pio_hw[1])
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+typedef struct {
+    uint wrap_target;
+    uint wrap;
+    uint sideset_bits;
+    uint sideset_base;
+    bool out_shift_right;
+    bool autopull;
+    uint pull_threshold;
+    enum pio_fifo_join join;
+    float clkdiv;
+} pio_sm_config;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline uint pio_get_index(PIO pio) {
+    return pio == pio1 ? 1 : 0;
+}
+
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx) {
+    return (pio == pio1 ? DREQ_PIO1_TX0 : DREQ_PIO0_TX0) + sm + (is_tx ? 0 : NUM_PIO_STATE_MACHINES);
+}
+
+int pio_claim_unused_sm(PIO pio, bool required);
+
+uint pio_add_program(PIO pio, const pio_program_t *program);
+
+static inline void pio_gpio_init(PIO pio, uint pin) {
+    gpio_set_function(pin, pio == pio1 ? GPIO_FUNC_PIO1 : GPIO_FUNC_PIO0);
+}
+
+static inline void pio_sm_set_consecutive_pindirs(PIO pio, uint sm, uint pin_base, uint pin_count, bool is_out) {
+    (void)pio;
+    (void)sm;
+    uint32_t mask = ((1u << pin_count) - 1) << pin_base;
+    gpio_set_dir_masked(mask, is_out ? mask : 0);
+}
+
+static inline pio_sm_config pio_get_default_sm_config(void) {
+    pio_sm_config c = {
+        .wrap = 31,
+        .out_shift_right = true,
+        .pull_threshold = 32,
+        .clkdiv = 1.0f,
+    };
+    return c;
+}
+
+static inline void sm_config_set_wrap(pio_sm_config *c, uint wrap_target, uint wrap) {
+    c->wrap_target = wrap_target;
+    c->wrap = wrap;
+}
+
+static inline void sm_config_set_sideset(pio_sm_config *c, uint bit_count, bool optional, bool pindirs) {
+    (void)optional;
+    (void)pindirs;
+    c->sideset_bits = bit_count;
+}
+
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, uint sideset_base) {
+    c->sideset_base = sideset_base;
+}
+
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, uint pull_threshold) {
+    c->out_shift_right = shift_right;
+    c->autopull = autopull;
+    c->pull_threshold = pull_threshold;
+}
+
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join) {
+    c->join = join;
+}
+
+static inline void sm_config_set_clkdiv(pio_sm_config *c, float div) {
+    c->clkdiv = div;
+}
+
+static inline void pio_sm_init(PIO pio, uint sm, uint initial_pc, const pio_sm_config *config) {
+    (void)pio;
+    (void)sm;
+    (void)initial_pc;
+    (void)config;
+}
+
+static inline void pio_sm_set_enabled(PIO pio, uint sm, bool enabled) {
+    if (enabled) {
+        pio->enabled |= 1u << sm;
+    } else {
+        pio->enabled &= ~(1u << sm);
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
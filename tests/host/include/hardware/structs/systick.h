@@ -0,0 +1,17 @@
+#pragma once
+
+// A subset of hardware/structs/systick.h of the Pico SDK, for libraries built
+// into host tests. The counter does not count on the host.
+
+#include "hardware/address_mapped.h"
+
+typedef struct {
+    io_rw_32 csr;
+    io_rw_32 rvr;
+    io_rw_32 cvr;
+    io_rw_32 calib;
+} systick_hw_t;
+
+extern systick_hw_t sim_systick_hw;
+
+#define systick_hw (&sim_systick_hw)
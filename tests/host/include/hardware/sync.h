@@ -0,0 +1,15 @@
+#pragma once
+
+// A subset of hardware/sync.h of the Pico SDK, for libraries built into host
+// tests. Simulated IRQs run only while the clock advances, so code under test
+// is never interrupted, and these do nothing.
+
+#include "pico.h"
+
+static inline uint32_t save_and_disable_interrupts(void) {
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status) {
+    (void)status;
+}
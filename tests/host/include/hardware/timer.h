@@ -0,0 +1,26 @@
+#pragma once
+
+// A subset of hardware/timer.h of the Pico SDK, for libraries built into host
+// tests. The clock is virtual, and busy waits advance it (see sim.h).
+
+#include "pico.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint64_t time_us_64(void);
+
+static inline uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+void busy_wait_us(uint64_t delay_us);
+
+static inline void busy_wait_us_32(uint32_t delay_us) {
+    busy_wait_us(delay_us);
+}
+
+#ifdef __cplusplus
+}
+#endif
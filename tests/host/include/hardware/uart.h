@@ -0,0 +1,50 @@
+#pragma once
+
+// A subset of hardware/uart.h of the Pico SDK, for libraries built into host
+// tests. Bytes written to dr by DMA are captured by sim.c, and bytes queued by
+// sim_uart_input() are received (see sim.h).
+
+#include "hardware/address_mapped.h"
+#include "hardware/gpio.h"
+
+#define NUM_UARTS 2
+
+#define DREQ_UART0_TX 20
+#define DREQ_UART1_TX 22
+
+typedef struct {
+    io_rw_32 dr;
+} uart_hw_t;
+
+typedef struct uart_inst uart_inst_t;
+
+extern uart_hw_t sim_uart_hw[NUM_UARTS];
+
+#define uart0 ((uart_inst_t *)&sim_uart_hw[0])
+#define uart1 ((uart_inst_t *)&sim_uart_hw[1])
+
+#ifndef uart_default
+#define uart_default uart0
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline uart_hw_t *uart_get_hw(uart_inst_t *uart) {
+    return (uart_hw_t *)uart;
+}
+
+static inline uint uart_get_dreq(uart_inst_t *uart, bool is_tx) {
+    return (uart == uart1 ? DREQ_UART1_TX : DREQ_UART0_TX) + (is_tx ? 0 : 1);
+}
+
+uint uart_init(uart_inst_t *uart, uint baudrate);
+
+bool uart_is_readable(uart_inst_t *uart);
+
+char uart_getc(uart_inst_t *uart);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+
+// A subset of hardware/watchdog.h of the Pico SDK, for libraries built into
+// host tests. The host never reboots by the watchdog.
+
+#include "pico.h"
+
+static inline bool watchdog_caused_reboot(void) {
+    return false;
+}
+
+static inline void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) {
+    (void)delay_ms;
+    (void)pause_on_debug;
+}
+
+static inline void watchdog_update(void) {}
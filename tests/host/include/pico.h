@@ -0,0 +1,31 @@
+#pragma once
+
+// A subset of pico.h of the Pico SDK, for libraries built into host tests.
+
+#include "pico/types.h"
+#include "pico/platform.h"
+
+// Libraries built for the host run on the simulation, not on a device.
+#define PICO_ON_DEVICE 0
+
+#define _u(x) x ## u
+
+#define PICO_OK                 0
+#define PICO_ERROR_GENERIC      -1
+#define PICO_ERROR_NO_DATA      -3
+
+#ifndef PICO_DEFAULT_UART_BAUD_RATE
+#define PICO_DEFAULT_UART_BAUD_RATE 115200
+#endif
+#ifndef PICO_DEFAULT_UART_TX_PIN
+#define PICO_DEFAULT_UART_TX_PIN 0
+#endif
+#ifndef PICO_DEFAULT_UART_RX_PIN
+#define PICO_DEFAULT_UART_RX_PIN 1
+#endif
+#ifndef PICO_DEFAULT_I2C_SDA_PIN
+#define PICO_DEFAULT_I2C_SDA_PIN 4
+#endif
+#ifndef PICO_DEFAULT_I2C_SCL_PIN
+#define PICO_DEFAULT_I2C_SCL_PIN 5
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+
+// A subset of pico/platform.h of the Pico SDK, for libraries built into host
+// tests. Sections of RAM are ordinary data on the host.
+
+#define __isr
+#define __not_in_flash_func(name) name
+#define __time_critical_func(name) name
+#define __uninitialized_ram(name) name
+
+static inline void tight_loop_contents(void) {}
+
+#ifndef MIN
+#define MIN(a, b) ((b) < (a) ? (b) : (a))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) < (b) ? (b) : (a))
+#endif
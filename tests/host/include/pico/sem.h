@@ -0,0 +1,40 @@
+#pragma once
+
+// A subset of pico/sem.h of the Pico SDK, for libraries built into host
+// tests. Nothing runs concurrently, so a semaphore is a counter.
+
+#include "pico.h"
+#include "pico/time.h"
+
+struct semaphore {
+    int16_t permits;
+    int16_t max_permits;
+};
+
+static inline void sem_init(struct semaphore *sem, int16_t initial_permits, int16_t max_permits) {
+    sem->permits = initial_permits;
+    sem->max_permits = max_permits;
+}
+
+static inline int sem_available(struct semaphore *sem) {
+    return sem->permits;
+}
+
+static inline bool sem_release(struct semaphore *sem) {
+    if (sem->permits >= sem->max_permits) {
+        return false;
+    }
+    sem->permits++;
+    return true;
+}
+
+// sem_acquire_timeout_ms does not wait, as nothing could release while
+// waiting.
+static inline bool sem_acquire_timeout_ms(struct semaphore *sem, uint32_t timeout_ms) {
+    (void)timeout_ms;
+    if (sem->permits <= 0) {
+        return false;
+    }
+    sem->permits--;
+    return true;
+}
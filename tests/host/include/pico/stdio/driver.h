@@ -0,0 +1,21 @@
+#pragma once
+
+// A subset of pico/stdio/driver.h of the Pico SDK, for libraries built into
+// host tests. Drivers are accepted, but stdio of the host is not redirected.
+
+#include "pico.h"
+
+typedef struct stdio_driver stdio_driver_t;
+
+struct stdio_driver {
+    void (*out_chars)(const char *buf, int len);
+    void (*out_flush)(void);
+    int (*in_chars)(char *buf, int len);
+    void (*set_chars_available_callback)(void (*fn)(void *), void *param);
+    stdio_driver_t *next;
+};
+
+static inline void stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled) {
+    (void)driver;
+    (void)enabled;
+}
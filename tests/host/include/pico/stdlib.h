@@ -0,0 +1,10 @@
+#pragma once
+
+// A subset of pico/stdlib.h of the Pico SDK, for libraries built into host
+// tests.
+
+#include "pico.h"
+#include "pico/time.h"
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+#include "hardware/uart.h"
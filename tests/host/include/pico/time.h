@@ -0,0 +1,37 @@
+#pragma once
+
+// A subset of pico/time.h of the Pico SDK, for libraries built into host
+// tests. Alarms fire on the virtual clock (see sim.h).
+
+#include "pico.h"
+#include "hardware/timer.h"
+
+typedef int32_t alarm_id_t;
+
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline void sleep_us(uint64_t us) {
+    busy_wait_us(us);
+}
+
+static inline void sleep_ms(uint32_t ms) {
+    busy_wait_us(ms * 1000ull);
+}
+
+// add_alarm_in_us calls back once, and the return value of callback is
+// ignored.
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+
+static inline alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    return add_alarm_in_us(ms * 1000ull, callback, user_data, fire_if_past);
+}
+
+bool cancel_alarm(alarm_id_t alarm_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,12 @@
+#pragma once
+
+// A subset of pico/types.h of the Pico SDK, for libraries built into host
+// tests.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
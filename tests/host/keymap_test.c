@@ -0,0 +1,64 @@
+#include "keymap_test.h"
+
+#include "test.h"
+
+#define KEY(usage) KEYMAP_ACTION(KEYMAP_KEY, usage)
+
+static void test_generated(void) {
+    TEST_ASSERT_EQ(4, KEYMAP_TEST_NUM_KEYS);
+    TEST_ASSERT_EQ(2, KEYMAP_TEST_NUM_LEDS);
+    TEST_ASSERT_EQ(3, KEYMAP_TEST_NUM_LAYERS);
+    TEST_ASSERT_EQ(1, keymap_test_sm_states[3].p0);
+    TEST_ASSERT_EQ(5, keymap_test_sm_states[3].p1);
+    TEST_ASSERT_EQ(1, keymap_test_key_to_led[0]);
+    TEST_ASSERT_EQ(-1, keymap_test_key_to_led[2]);
+    TEST_ASSERT(keymap_test_led_positions[0].x == 1.0f);
+}
+
+// Transparent actions are resolved against the layer below at build time.
+static void test_lookup(void) {
+    const keymap_t *m = &keymap_test;
+    TEST_ASSERT_EQ(KEY(0x04), keymap_lookup(m, 0x1, 0));
+    TEST_ASSERT_EQ(KEY(0x3A), keymap_lookup(m, 0x3, 0));
+    TEST_ASSERT_EQ(KEY(0xE1), keymap_lookup(m, 0x3, 1));
+    TEST_ASSERT_EQ(KEYMAP_ACTION(KEYMAP_LAYER_MOMENTARY, 1), keymap_lookup(m, 0x3, 2));
+    TEST_ASSERT_EQ(KEYMAP_ACTION(KEYMAP_NONE, 0), keymap_lookup(m, 0x5, 0));
+    TEST_ASSERT_EQ(KEY(0x2C), keymap_lookup(m, 0x7, 1));
+    TEST_ASSERT_EQ(KEYMAP_ACTION(KEYMAP_USER, 7), keymap_lookup(m, 0x7, 2));
+    TEST_ASSERT_EQ(KEYMAP_ACTION(KEYMAP_LAYER_TOGGLE, 2), keymap_lookup(m, 0x5, 3));
+}
+
+static void test_momentary(void) {
+    keymap_state_t s;
+    keymap_init(&s, &keymap_test);
+    keymap_event(&s, 2, true);
+    TEST_ASSERT_EQ(0x3, s.layers);
+    TEST_ASSERT_EQ(KEY(0x3A), keymap_event(&s, 0, true));
+    keymap_event(&s, 2, false);
+    TEST_ASSERT_EQ(0x1, s.layers);
+    // released as pressed, in the layer 1.
+    TEST_ASSERT_EQ(KEY(0x3A), keymap_event(&s, 0, false));
+    TEST_ASSERT_EQ(KEY(0x04), keymap_event(&s, 0, true));
+}
+
+static void test_toggle(void) {
+    keymap_state_t s;
+    keymap_init(&s, &keymap_test);
+    keymap_event(&s, 3, true);
+    keymap_event(&s, 3, false);
+    TEST_ASSERT_EQ(0x5, s.layers);
+    TEST_ASSERT_EQ(KEY(0x2C), keymap_event(&s, 1, true));
+    keymap_event(&s, 1, false);
+    TEST_ASSERT_EQ(KEYMAP_ACTION(KEYMAP_LAYER_TOGGLE, 2), keymap_event(&s, 3, true));
+    keymap_event(&s, 3, false);
+    TEST_ASSERT_EQ(0x1, s.layers);
+    TEST_ASSERT_EQ(KEYMAP_ACTION(KEYMAP_NONE, 0), keymap_event(&s, 4, true));
+}
+
+int main(void) {
+    TEST_RUN(test_generated);
+    TEST_RUN(test_lookup);
+    TEST_RUN(test_momentary);
+    TEST_RUN(test_toggle);
+    return 0;
+}
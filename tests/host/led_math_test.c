@@ -0,0 +1,76 @@
+#include <stdlib.h>
+
+#include "led/math.h"
+
+#include "test.h"
+
+// The float and fixed implementations of led/math.h must give the same
+// colors and levels, within TOLERANCE of 255.
+
+#define TOLERANCE 1
+
+static void assert_near(int want, int got, const char *what, float x, float y, uint64_t t) {
+    if (abs(want - got) > TOLERANCE) {
+        fprintf(stderr, "%s at (%g, %g), %llu: float %d, fixed %d\n", what, x, y, (unsigned long long)t, want, got);
+        exit(1);
+    }
+}
+
+static void test_q16(void) {
+    const float xs[] = { 0.0f, -0.0f, 1.0f, -1.0f, 0.2f, -0.7f, 1.5e-5f, 1e-10f, 12345.678f, -32767.5f };
+    for (uint i = 0; i < count_of(xs); i++) {
+        TEST_ASSERT_EQ((int32_t)(xs[i] * 65536), led_math_q16(xs[i]));
+    }
+    TEST_ASSERT_EQ(INT32_MAX, led_math_q16(40000.0f));
+}
+
+static void test_isqrt(void) {
+    for (uint32_t r = 0; r < 65536; r += 7) {
+        TEST_ASSERT_EQ(r, led_math_isqrt(r * r));
+        TEST_ASSERT_EQ(r, led_math_isqrt(r * r + r));
+    }
+}
+
+// Through a cycle at positions over the keyboard.
+static void test_rainbow(void) {
+    for (uint64_t now = 0; now < (2 << 22); now += 4099) {
+        for (float x = 0.0f; x < 1.3f; x += 0.05f) {
+            ws2812_color_t f = led_math_rainbow_float(x, now);
+            ws2812_color_t q = led_math_rainbow_fixed(x, now);
+            assert_near(f.r, q.r, "r", x, 0, now);
+            assert_near(f.g, q.g, "g", x, 0, now);
+            assert_near(f.b, q.b, "b", x, 0, now);
+        }
+    }
+    ws2812_color_t c = led_math_rainbow_fixed(0.0f, 0);
+    TEST_ASSERT_EQ(255, c.r);
+    TEST_ASSERT_EQ(0, c.g);
+    TEST_ASSERT_EQ(0, c.b);
+}
+
+// Around the center through the duration and after it.
+static void test_push(void) {
+    const led_pos_t center = { 0.4f, 0.6f };
+    for (uint64_t elapsed = 0; elapsed < 1200000; elapsed += 9973) {
+        for (int i = -80; i <= 80; i++) {
+            for (int j = -80; j <= 80; j++) {
+                led_pos_t pos = { center.x + i * 0.01f, center.y + j * 0.01f };
+                assert_near(led_math_push_float(&pos, &center, elapsed),
+                    led_math_push_fixed(&pos, &center, elapsed), "level", pos.x, pos.y, elapsed);
+            }
+        }
+    }
+    const led_pos_t near = { 0.6f, 0.6f }, far = { 1.2f, 0.6f };
+    TEST_ASSERT_EQ(255, led_math_push_fixed(&center, &center, 0));
+    TEST_ASSERT(led_math_push_fixed(&near, &center, 0) > 0);
+    TEST_ASSERT_EQ(0, led_math_push_fixed(&near, &center, 1000000));
+    TEST_ASSERT_EQ(0, led_math_push_fixed(&far, &center, 0));
+}
+
+int main(void) {
+    TEST_RUN(test_q16);
+    TEST_RUN(test_isqrt);
+    TEST_RUN(test_rainbow);
+    TEST_RUN(test_push);
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include <string.h>
+
+#include "log/ring.h"
+
+#include "sim.h"
+#include "test.h"
+
+// The ring of LOG_RING_LEN=8 records, sent to the UART sink by DMA.
+
+#define RECORD_US (sizeof(log_ring_record_t) * SIM_UART_BYTE_US)
+
+static uint uart_offset;
+
+// next_record takes a record sent since the last one.
+static log_ring_record_t next_record(void) {
+    uint len;
+    const uint8_t *out = sim_uart_output(&len);
+    TEST_ASSERT(uart_offset + sizeof(log_ring_record_t) <= len);
+    log_ring_record_t r;
+    memcpy(&r, out + uart_offset, sizeof(r));
+    uart_offset += sizeof(r);
+    TEST_ASSERT_EQ(LOG_RING_SYNC, r.sync);
+    return r;
+}
+
+static uint sent_records(void) {
+    uint len;
+    sim_uart_output(&len);
+    return (len - uart_offset) / sizeof(log_ring_record_t);
+}
+
+static const char fmt_early[] = "early %u\n";
+static const char fmt_args[] = "args %u %u %u %u %u\n";
+static const char fmt_burst[] = "burst %u\n";
+
+// Records written before log_ring_init are sent by it.
+static void test_early(void) {
+    TEST_ASSERT_EQ(1, log_ring_stats()->written);
+    TEST_ASSERT_EQ(0, sent_records());
+    log_ring_init();
+    sim_advance(RECORD_US);
+    TEST_ASSERT_EQ(1, sent_records());
+    log_ring_record_t r = next_record();
+    TEST_ASSERT_EQ(1, r.len);
+    TEST_ASSERT_EQ(0, r.seq);
+    TEST_ASSERT_EQ((uint32_t)(uintptr_t)fmt_early, r.fmt);
+    TEST_ASSERT_EQ(123, r.time);
+    TEST_ASSERT_EQ(42, r.args[0]);
+}
+
+static void test_args(void) {
+    uint32_t time = sim_now();
+    LOG_RING(fmt_args, 1, 2, 3, 4, 5);
+    // the record is sent after the time of the UART.
+    sim_advance(RECORD_US - 1);
+    TEST_ASSERT_EQ(0, sent_records());
+    sim_advance(1);
+    log_ring_record_t r = next_record();
+    TEST_ASSERT_EQ(5, r.len);
+    TEST_ASSERT_EQ(1, r.seq);
+    TEST_ASSERT_EQ(time, r.time);
+    for (uint i = 0; i < LOG_RING_MAX_ARGS; i++) {
+        TEST_ASSERT_EQ(i + 1, r.args[i]);
+    }
+}
+
+// Records over the ring are dropped without blocking, and counted. seq
+// skips dropped ones.
+static void test_overflow(void) {
+    log_ring_stats_t before = *log_ring_stats();
+    uint64_t start = sim_now();
+    for (uint i = 0; i < LOG_RING_LEN + 2; i++) {
+        LOG_RING(fmt_burst, i);
+    }
+    TEST_ASSERT_EQ(start, sim_now());
+    TEST_ASSERT_EQ(0, log_ring_space());
+    TEST_ASSERT_EQ(before.written + LOG_RING_LEN, log_ring_stats()->written);
+    TEST_ASSERT_EQ(before.dropped + 2, log_ring_stats()->dropped);
+
+    LOG_RING(fmt_early, 0);
+    TEST_ASSERT_EQ(before.dropped + 3, log_ring_stats()->dropped);
+    // a record sent makes room for one.
+    sim_advance(RECORD_US);
+    TEST_ASSERT_EQ(1, log_ring_space());
+    LOG_RING(fmt_args, 1, 2, 3, 4, 5);
+
+    sim_advance((LOG_RING_LEN + 1) * RECORD_US);
+    TEST_ASSERT_EQ(LOG_RING_LEN + 1, sent_records());
+    TEST_ASSERT_EQ(LOG_RING_LEN, log_ring_space());
+    for (uint i = 0; i < LOG_RING_LEN; i++) {
+        log_ring_record_t r = next_record();
+        TEST_ASSERT_EQ((uint32_t)(uintptr_t)fmt_burst, r.fmt);
+        TEST_ASSERT_EQ(2 + i, r.seq);
+        TEST_ASSERT_EQ(i, r.args[0]);
+    }
+    log_ring_record_t r = next_record();
+    TEST_ASSERT_EQ((uint32_t)(uintptr_t)fmt_args, r.fmt);
+    TEST_ASSERT_EQ(2 + LOG_RING_LEN + 3, r.seq);
+}
+
+// Text is split into records of up to 20 bytes.
+static void test_text(void) {
+    static const char text[] = "a line longer than a record\n";
+    log_ring_text(text, sizeof(text) - 1);
+    sim_advance(2 * RECORD_US);
+    log_ring_record_t r = next_record();
+    TEST_ASSERT_EQ(LOG_RING_TEXT | 20, r.len);
+    TEST_ASSERT_EQ(0, r.fmt);
+    TEST_ASSERT(memcmp(r.args, text, 20) == 0);
+    r = next_record();
+    TEST_ASSERT_EQ(LOG_RING_TEXT | (sizeof(text) - 1 - 20), r.len);
+    TEST_ASSERT(memcmp(r.args, text + 20, sizeof(text) - 1 - 20) == 0);
+    TEST_ASSERT_EQ(0, sent_records());
+}
+
+int main(void) {
+    sim_reset();
+    sim_advance(123);
+    LOG_RING(fmt_early, 42);
+
+    TEST_RUN(test_early);
+    TEST_RUN(test_args);
+    TEST_RUN(test_overflow);
+    TEST_RUN(test_text);
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include <string.h>
+
+#include "keymap/resolver.h"
+#include "keymap_resolver.h"
+
+#include "test.h"
+
+// Keys of resolver_test.json.
+enum {
+    K_A_LSFT,
+    K_S,
+    K_SPACE_L1,
+    K_D,
+    K_F,
+    K_J,
+    K_K,
+};
+
+#define KEY(usage) KEYMAP_ACTION(KEYMAP_KEY, usage)
+
+// Usages on tap in layer 0.
+static const uint8_t tap_usages[] = { 0x04, 0x16, 0x2C, 0x07, 0x09, 0x0D, 0x0E };
+
+typedef struct {
+    keymap_action_t action;
+    bool on;
+    uint64_t when;
+} output_t;
+
+static output_t outputs[256];
+static uint outputs_len;
+
+static void on_emit(keymap_resolver_t *r, keymap_action_t action, bool on, uint64_t when) {
+    TEST_ASSERT(outputs_len < count_of(outputs));
+    outputs[outputs_len++] = (output_t){ action, on, when };
+}
+
+static keymap_resolver_t resolver;
+
+static void setup(void) {
+    resolver.emit = on_emit;
+    keymap_resolver_init(&resolver, &keymap_resolver);
+    outputs_len = 0;
+}
+
+typedef struct {
+    uint32_t ms;
+    uint8_t key;
+    bool on;
+} trace_t;
+
+// replay feeds events at their times, and runs the task every 1ms between
+// them as the scheduler does.
+static uint64_t replay(const trace_t *trace, uint n) {
+    uint64_t now = 0;
+    for (uint i = 0; i < n; i++) {
+        uint64_t t = trace[i].ms * 1000ull;
+        while (now + 1000 <= t) {
+            now += 1000;
+            keymap_resolver_task(&resolver, now);
+        }
+        now = t;
+        keymap_resolver_event(&resolver, trace[i].key, trace[i].on, now);
+    }
+    for (uint i = 0; i < 1000; i++) {
+        now += 1000;
+        keymap_resolver_task(&resolver, now);
+    }
+    TEST_ASSERT_EQ(0, resolver.queue_len);
+    return now;
+}
+
+static void assert_outputs(const output_t *want, uint n) {
+    TEST_ASSERT_EQ(n, outputs_len);
+    for (uint i = 0; i < n; i++) {
+        TEST_ASSERT_EQ(want[i].action, outputs[i].action);
+        TEST_ASSERT_EQ(want[i].on, outputs[i].on);
+    }
+}
+
+// Keys which are neither tap-hold nor in combos are never held back.
+static void test_immediate(void) {
+    setup();
+    keymap_resolver_event(&resolver, K_S, true, 100);
+    TEST_ASSERT_EQ(1, outputs_len);
+    TEST_ASSERT_EQ(100, outputs[0].when);
+    keymap_resolver_event(&resolver, K_S, false, 200);
+    TEST_ASSERT_EQ(2, outputs_len);
+    TEST_ASSERT_EQ(2, resolver.stats.immediate);
+    TEST_ASSERT_EQ(0, resolver.stats.held);
+}
+
+static void test_tap(void) {
+    setup();
+    keymap_resolver_event(&resolver, K_A_LSFT, true, 0);
+    TEST_ASSERT_EQ(0, outputs_len);
+    TEST_ASSERT_EQ(KEYMAP_TAPPING_TERM_US, keymap_resolver_deadline(&resolver));
+    keymap_resolver_event(&resolver, K_A_LSFT, false, 50000);
+    assert_outputs((output_t[]){
+        { KEY(0x04), true }, { KEY(0x04), false },
+    }, 2);
+    // decided on the release.
+    TEST_ASSERT_EQ(50000, resolver.stats.max_latency);
+    TEST_ASSERT_EQ(UINT64_MAX, keymap_resolver_deadline(&resolver));
+}
+
+static void test_hold_by_term(void) {
+    setup();
+    keymap_resolver_event(&resolver, K_A_LSFT, true, 0);
+    keymap_resolver_task(&resolver, KEYMAP_TAPPING_TERM_US - 1);
+    TEST_ASSERT_EQ(0, outputs_len);
+    keymap_resolver_task(&resolver, KEYMAP_TAPPING_TERM_US);
+    TEST_ASSERT_EQ(1, outputs_len);
+    keymap_resolver_event(&resolver, K_S, true, 300000);
+    keymap_resolver_event(&resolver, K_S, false, 350000);
+    keymap_resolver_event(&resolver, K_A_LSFT, false, 400000);
+    assert_outputs((output_t[]){
+        { KEY(0xE1), true }, { KEY(0x16), true }, { KEY(0x16), false }, { KEY(0xE1), false },
+    }, 4);
+}
+
+// A key pressed and released within the tapping term makes a hold.
+static void test_permissive_hold(void) {
+    setup();
+    replay((trace_t[]){
+        { 0, K_A_LSFT, true }, { 30, K_S, true }, { 60, K_S, false }, { 90, K_A_LSFT, false },
+    }, 4);
+    assert_outputs((output_t[]){
+        { KEY(0xE1), true }, { KEY(0x16), true }, { KEY(0x16), false }, { KEY(0xE1), false },
+    }, 4);
+    // S was held from 30 to its release at 60.
+    TEST_ASSERT_EQ(60000, resolver.stats.max_latency);
+}
+
+// Keys after a layer-tap key held are resolved in the layer.
+static void test_layer_tap(void) {
+    setup();
+    replay((trace_t[]){
+        { 0, K_SPACE_L1, true }, { 20, K_S, true }, { 40, K_S, false }, { 60, K_SPACE_L1, false },
+        { 80, K_S, true }, { 90, K_S, false },
+    }, 6);
+    keymap_action_t mo1 = KEYMAP_ACTION(KEYMAP_LAYER_MOMENTARY, 1);
+    assert_outputs((output_t[]){
+        { mo1, true }, { KEY(0x1E), true }, { KEY(0x1E), false }, { mo1, false },
+        { KEY(0x16), true }, { KEY(0x16), false },
+    }, 6);
+    TEST_ASSERT_EQ(1, resolver.state.layers);
+}
+
+static void test_combo(void) {
+    setup();
+    replay((trace_t[]){
+        { 0, K_D, true }, { 10, K_F, true }, { 100, K_F, false }, { 110, K_D, false },
+    }, 4);
+    assert_outputs((output_t[]){ { KEY(0x29), true }, { KEY(0x29), false } }, 2);
+}
+
+// The combo of J and K waits for F of a larger combo until the term.
+static void test_combo_larger(void) {
+    setup();
+    replay((trace_t[]){
+        { 0, K_J, true }, { 5, K_K, true }, { 100, K_K, false }, { 110, K_J, false },
+        { 200, K_F, true }, { 205, K_J, true }, { 210, K_K, true },
+        { 300, K_F, false }, { 301, K_J, false }, { 302, K_K, false },
+    }, 10);
+    assert_outputs((output_t[]){
+        { KEY(0x2B), true }, { KEY(0x2B), false },
+        { KEYMAP_ACTION(KEYMAP_USER, 1), true }, { KEYMAP_ACTION(KEYMAP_USER, 1), false },
+    }, 4);
+    TEST_ASSERT(outputs[0].when == 5000);
+}
+
+// Keys of a combo pressed apart are keys.
+static void test_combo_apart(void) {
+    setup();
+    replay((trace_t[]){
+        { 0, K_D, true }, { 50, K_F, true }, { 60, K_D, false }, { 120, K_F, false },
+    }, 4);
+    assert_outputs((output_t[]){
+        { KEY(0x07), true }, { KEY(0x09), true }, { KEY(0x07), false }, { KEY(0x09), false },
+    }, 4);
+    // D was decided at the term, by the task.
+    TEST_ASSERT_EQ(KEYMAP_COMBO_TERM_US, resolver.stats.max_latency);
+}
+
+// A full queue forces decisions, and loses no events. Presses of S repeat,
+// as chattering does.
+static void test_overflow(void) {
+    setup();
+    keymap_resolver_event(&resolver, K_A_LSFT, true, 0);
+    for (uint i = 0; i < KEYMAP_RESOLVER_QUEUE_LEN; i++) {
+        keymap_resolver_event(&resolver, K_S, true, 1000 + i);
+    }
+    TEST_ASSERT_EQ(1, resolver.stats.overflows);
+    TEST_ASSERT_EQ(KEY(0xE1), outputs[0].action);
+    TEST_ASSERT_EQ(1 + KEYMAP_RESOLVER_QUEUE_LEN, outputs_len);
+}
+
+//----------------------------------------------------------------------------
+// Typing traces
+
+// type_rolling makes a trace of keys typed at wpm (5 keys per word), each
+// held for hold ms. Keys roll over the next ones when hold is longer than the
+// interval.
+static uint type_rolling(trace_t *trace, const uint8_t *keys, uint n, uint wpm, uint32_t hold) {
+    uint32_t interval = 60 * 1000 / (wpm * 5);
+    uint len = 0;
+    // merge presses and releases in order of time.
+    uint next_release = 0;
+    for (uint i = 0; i < n; i++) {
+        uint32_t t = i * interval;
+        while (next_release < i && next_release * interval + hold <= t) {
+            trace[len++] = (trace_t){ next_release * interval + hold, keys[next_release], false };
+            next_release++;
+        }
+        trace[len++] = (trace_t){ t, keys[i], true };
+    }
+    for (; next_release < n; next_release++) {
+        trace[len++] = (trace_t){ next_release * interval + hold, keys[next_release], false };
+    }
+    return len;
+}
+
+// At realistic speeds with rolls, all tap-hold keys are taps and no combos
+// fire. Outputs are in the order of the trace.
+static void test_typing(void) {
+    static const uint8_t text[] = {
+        K_A_LSFT, K_S, K_D, K_F, K_SPACE_L1, K_J, K_K, K_A_LSFT, K_SPACE_L1, K_D,
+        K_S, K_A_LSFT, K_F, K_J, K_SPACE_L1, K_K, K_D, K_F, K_A_LSFT, K_S,
+    };
+    static const uint wpms[] = { 40, 80, 120 };
+    static const uint32_t holds[] = { 60, 100, 140 };
+    trace_t trace[2 * count_of(text)];
+    for (uint w = 0; w < count_of(wpms); w++) {
+        for (uint h = 0; h < count_of(holds); h++) {
+            setup();
+            uint n = type_rolling(trace, text, count_of(text), wpms[w], holds[h]);
+            replay(trace, n);
+            TEST_ASSERT_EQ(n, outputs_len);
+            for (uint i = 0; i < n; i++) {
+                TEST_ASSERT_EQ(KEY(tap_usages[trace[i].key]), outputs[i].action);
+                TEST_ASSERT_EQ(trace[i].on, outputs[i].on);
+            }
+            TEST_ASSERT(resolver.stats.max_latency <= KEYMAP_TAPPING_TERM_US);
+            printf("  %3u wpm, hold %3u ms: held %u, avg %llu us, max %u us\n",
+                    wpms[w], holds[h], resolver.stats.held,
+                    resolver.stats.held > 0 ? (unsigned long long)(resolver.stats.sum_latency / resolver.stats.held) : 0,
+                    resolver.stats.max_latency);
+        }
+    }
+}
+
+int main(void) {
+    TEST_RUN(test_immediate);
+    TEST_RUN(test_tap);
+    TEST_RUN(test_hold_by_term);
+    TEST_RUN(test_permissive_hold);
+    TEST_RUN(test_layer_tap);
+    TEST_RUN(test_combo);
+    TEST_RUN(test_combo_larger);
+    TEST_RUN(test_combo_apart);
+    TEST_RUN(test_overflow);
+    TEST_RUN(test_typing);
+    return 0;
+}
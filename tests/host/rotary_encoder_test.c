@@ -0,0 +1,92 @@
+#include "driver/rotary_encoder.h"
+
+#include "sim.h"
+#include "test.h"
+
+// An encoder on simulated pins, turned by quadrature words.
+
+#define PIN_A 2
+#define PIN_B 3
+
+static const uint8_t cw[] = { 1, 3, 2, 0 };
+static const uint8_t ccw[] = { 2, 3, 1, 0 };
+
+static int changed_sum;
+static uint changed_count;
+
+static void on_changed(rotary_encoder_t *re, uint64_t when, int8_t delta) {
+    changed_sum += delta;
+    changed_count++;
+}
+
+static rotary_encoder_t re = {
+    .changed = on_changed,
+};
+
+// turn sets words phase_us apart, and returns the sum of deltas of the task
+// polled every 50us.
+static int turn(const uint8_t *words, uint n, uint32_t phase_us) {
+    int sum = 0;
+    for (uint i = 0; i < n; i++) {
+        sim_encoder_set(PIN_A, PIN_B, words[i]);
+        for (uint32_t t = 0; t < phase_us; t += 50) {
+            sum += rotary_encoder_task(&re, sim_now());
+            sim_advance(50);
+        }
+    }
+    return sum;
+}
+
+static void clear(void) {
+    changed_sum = 0;
+    changed_count = 0;
+}
+
+static void test_clockwise(void) {
+    clear();
+    TEST_ASSERT_EQ(1, turn(cw, count_of(cw), 1000));
+    TEST_ASSERT_EQ(1, changed_sum);
+    TEST_ASSERT_EQ(1, changed_count);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_EQ(1, turn(cw, count_of(cw), 500));
+    }
+    TEST_ASSERT_EQ(4, changed_sum);
+}
+
+static void test_counterclockwise(void) {
+    clear();
+    TEST_ASSERT_EQ(-1, turn(ccw, count_of(ccw), 1000));
+    TEST_ASSERT_EQ(-1, changed_sum);
+    TEST_ASSERT_EQ(1, changed_count);
+}
+
+// Going back before B is connected is not a rotation.
+static void test_incomplete(void) {
+    clear();
+    static const uint8_t back[] = { 1, 0 };
+    TEST_ASSERT_EQ(0, turn(back, count_of(back), 1000));
+    TEST_ASSERT_EQ(0, changed_count);
+}
+
+// Words shorter than 250us are chatter, and ignored.
+static void test_chatter(void) {
+    clear();
+    static const uint8_t chatter[] = { 1, 0, 1, 0, 1 };
+    TEST_ASSERT_EQ(0, turn(chatter, count_of(chatter), 50));
+    // the first word was taken, and the rest of the detent completes it.
+    TEST_ASSERT_EQ(1, turn(cw + 1, count_of(cw) - 1, 1000));
+    TEST_ASSERT_EQ(1, changed_count);
+}
+
+int main(void) {
+    sim_reset();
+    rotary_encoder_init(&re, PIN_A, PIN_B);
+    sim_advance(1000);
+    TEST_ASSERT_EQ(0, rotary_encoder_task(&re, sim_now()));
+
+    TEST_RUN(test_clockwise);
+    TEST_RUN(test_counterclockwise);
+    TEST_RUN(test_incomplete);
+    TEST_RUN(test_chatter);
+    return 0;
+}
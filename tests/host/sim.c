@@ -0,0 +1,675 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim.h"
+
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/structs/systick.h"
+#include "hardware/uart.h"
+
+// Events run in order of time, and of scheduling at the same time. An event
+// may schedule others, and may advance the clock by a busy wait.
+
+#define SIM_EVENTS 32
+
+// IC_DATA_CMD holds this when the CPU wrote nothing since the last capture.
+#define SIM_I2C_EMPTY 0xffffffffu
+
+typedef enum {
+    SIM_EVENT_NONE = 0,
+    SIM_EVENT_ALARM,
+    SIM_EVENT_DMA,
+} sim_event_kind_t;
+
+typedef struct {
+    sim_event_kind_t kind;
+    uint64_t at;
+    uint64_t seq;
+    alarm_id_t id;
+    alarm_callback_t callback;
+    void *user_data;
+    uint channel;
+} sim_event_t;
+
+typedef struct {
+    bool claimed;
+    bool busy;
+    bool irq0;
+    bool irq1;
+    dma_channel_config config;
+    volatile void *write_addr;
+    const volatile void *read_addr;
+    uint32_t count;
+    alarm_id_t event;
+} sim_dma_channel_t;
+
+typedef struct {
+    bool active;
+    sim_i2c_transaction_t t;
+} sim_i2c_bus_t;
+
+systick_hw_t sim_systick_hw;
+dma_hw_t sim_dma_hw;
+pio_hw_t sim_pio_hw[NUM_PIOS];
+uart_hw_t sim_uart_hw[NUM_UARTS];
+static i2c_hw_t sim_i2c_hw[NUM_I2CS];
+i2c_inst_t sim_i2c_inst[NUM_I2CS] = {
+    { &sim_i2c_hw[0], false },
+    { &sim_i2c_hw[1], false },
+};
+
+static uint64_t sim_time;
+static sim_event_t sim_events[SIM_EVENTS];
+static uint64_t sim_event_seq;
+static alarm_id_t sim_next_id;
+
+static irq_handler_t sim_irq_handlers[32];
+static uint32_t sim_irq_enabled;
+
+static uint32_t sim_gpio_oe;
+static uint32_t sim_gpio_out;
+static uint32_t sim_gpio_pull_up;
+static uint32_t sim_gpio_drive_low;
+static uint32_t sim_gpio_drive_high;
+// pins connected to each pin by closed switches.
+static uint32_t sim_gpio_switches[32];
+
+static sim_dma_channel_t sim_dma_channels[NUM_DMA_CHANNELS];
+
+static sim_pio_frame_t sim_pio_frames[SIM_PIO_FRAMES];
+static uint sim_pio_frames_len;
+
+static sim_i2c_bus_t sim_i2c_buses[NUM_I2CS];
+static sim_i2c_transaction_t sim_i2c_transactions[SIM_I2C_TRANSACTIONS];
+static uint sim_i2c_transactions_len;
+static uint8_t sim_i2c_nacked[128];
+
+static uint8_t sim_uart_out[SIM_UART_MAX];
+static uint sim_uart_out_len;
+static char sim_uart_in[256];
+static uint sim_uart_in_head;
+static uint sim_uart_in_tail;
+
+//////////////////////////////////////////////////////////////////////////////
+// Events
+
+static alarm_id_t sim_schedule(sim_event_kind_t kind, uint64_t at) {
+    for (uint i = 0; i < SIM_EVENTS; i++) {
+        sim_event_t *e = &sim_events[i];
+        if (e->kind != SIM_EVENT_NONE) {
+            continue;
+        }
+        memset(e, 0, sizeof(*e));
+        e->kind = kind;
+        e->at = at;
+        e->seq = sim_event_seq++;
+        e->id = ++sim_next_id;
+        return e->id;
+    }
+    fprintf(stderr, "sim: too many events\n");
+    abort();
+}
+
+static sim_event_t *sim_find_event(alarm_id_t id) {
+    for (uint i = 0; i < SIM_EVENTS; i++) {
+        if (sim_events[i].kind != SIM_EVENT_NONE && sim_events[i].id == id) {
+            return &sim_events[i];
+        }
+    }
+    return NULL;
+}
+
+static void sim_raise_irq(uint num) {
+    if ((sim_irq_enabled & (1u << num)) != 0 && sim_irq_handlers[num] != NULL) {
+        sim_irq_handlers[num]();
+    }
+}
+
+static void sim_dma_complete(uint channel);
+
+static void sim_run_event(sim_event_t *e) {
+    sim_event_t run = *e;
+    e->kind = SIM_EVENT_NONE;
+    switch (run.kind) {
+        case SIM_EVENT_ALARM:
+            run.callback(run.id, run.user_data);
+            break;
+        case SIM_EVENT_DMA:
+            sim_dma_complete(run.channel);
+            break;
+        default:
+            break;
+    }
+}
+
+uint64_t sim_now(void) {
+    return sim_time;
+}
+
+void sim_advance(uint64_t us) {
+    uint64_t until = sim_time + us;
+    while (true) {
+        sim_event_t *next = NULL;
+        for (uint i = 0; i < SIM_EVENTS; i++) {
+            sim_event_t *e = &sim_events[i];
+            if (e->kind == SIM_EVENT_NONE || e->at > until) {
+                continue;
+            }
+            if (next == NULL || e->at < next->at || (e->at == next->at && e->seq < next->seq)) {
+                next = e;
+            }
+        }
+        if (next == NULL) {
+            break;
+        }
+        if (next->at > sim_time) {
+            sim_time = next->at;
+        }
+        sim_run_event(next);
+    }
+    if (until > sim_time) {
+        sim_time = until;
+    }
+}
+
+uint64_t time_us_64(void) {
+    return sim_time;
+}
+
+void busy_wait_us(uint64_t delay_us) {
+    sim_advance(delay_us);
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    (void)fire_if_past;
+    alarm_id_t id = sim_schedule(SIM_EVENT_ALARM, sim_time + us);
+    sim_event_t *e = sim_find_event(id);
+    e->callback = callback;
+    e->user_data = user_data;
+    return id;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    sim_event_t *e = sim_find_event(alarm_id);
+    if (e == NULL || e->kind != SIM_EVENT_ALARM) {
+        return false;
+    }
+    e->kind = SIM_EVENT_NONE;
+    return true;
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler) {
+    sim_irq_handlers[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled) {
+    if (enabled) {
+        sim_irq_enabled |= 1u << num;
+    } else {
+        sim_irq_enabled &= ~(1u << num);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// GPIO
+
+void gpio_init(uint gpio) {
+    gpio_set_dir_masked(1u << gpio, 0);
+    gpio_put_masked(1u << gpio, 0);
+}
+
+void gpio_init_mask(uint gpio_mask) {
+    for (uint i = 0; i < 32; i++) {
+        if (gpio_mask & (1u << i)) {
+            gpio_init(i);
+        }
+    }
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_set_pulls(uint gpio, bool up, bool down) {
+    (void)down;
+    if (up) {
+        sim_gpio_pull_up |= 1u << gpio;
+    } else {
+        sim_gpio_pull_up &= ~(1u << gpio);
+    }
+}
+
+void gpio_set_dir_masked(uint32_t mask, uint32_t value) {
+    sim_gpio_oe = (sim_gpio_oe & ~mask) | (value & mask);
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value) {
+    sim_gpio_out = (sim_gpio_out & ~mask) | (value & mask);
+}
+
+uint32_t gpio_get_all(void) {
+    uint32_t in = ~sim_gpio_oe;
+    uint32_t level = (sim_gpio_out & sim_gpio_oe) | (sim_gpio_pull_up & in);
+    level = (level & ~(sim_gpio_drive_low & in)) | (sim_gpio_drive_high & in);
+    // a pin driven low pulls inputs connected by closed switches low.
+    uint32_t low = (sim_gpio_oe & ~sim_gpio_out) | (sim_gpio_drive_low & in);
+    for (uint i = 0; i < 32; i++) {
+        if (low & (1u << i)) {
+            level &= ~(sim_gpio_switches[i] & in);
+        }
+    }
+    return level & ((1u << NUM_BANK0_GPIOS) - 1);
+}
+
+void sim_switch(uint p0, uint p1, bool closed) {
+    if (closed) {
+        sim_gpio_switches[p0] |= 1u << p1;
+        sim_gpio_switches[p1] |= 1u << p0;
+    } else {
+        sim_gpio_switches[p0] &= ~(1u << p1);
+        sim_gpio_switches[p1] &= ~(1u << p0);
+    }
+}
+
+void sim_gpio_drive(uint gpio, int level) {
+    sim_gpio_drive_low &= ~(1u << gpio);
+    sim_gpio_drive_high &= ~(1u << gpio);
+    if (level == 0) {
+        sim_gpio_drive_low |= 1u << gpio;
+    } else if (level > 0) {
+        sim_gpio_drive_high |= 1u << gpio;
+    }
+}
+
+uint32_t sim_gpio_outputs(void) {
+    return sim_gpio_oe;
+}
+
+void sim_encoder_set(uint a, uint b, uint word) {
+    sim_gpio_drive(a, (word & 1) ? 0 : -1);
+    sim_gpio_drive(b, (word & 2) ? 0 : -1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// I2C
+
+static void sim_i2c_end(uint index, bool aborted) {
+    sim_i2c_bus_t *bus = &sim_i2c_buses[index];
+    if (!bus->active) {
+        return;
+    }
+    bus->t.aborted = aborted || sim_i2c_nacked[bus->t.addr & 0x7f];
+    sim_i2c_transactions[sim_i2c_transactions_len++ % SIM_I2C_TRANSACTIONS] = bus->t;
+    bus->active = false;
+}
+
+// sim_i2c_put adds a word of IC_DATA_CMD to the transaction of the bus.
+static void sim_i2c_put(uint index, uint32_t data_cmd) {
+    sim_i2c_bus_t *bus = &sim_i2c_buses[index];
+    if (!bus->active) {
+        memset(&bus->t, 0, sizeof(bus->t));
+        bus->t.at = sim_time;
+        bus->t.addr = sim_i2c_hw[index].tar;
+        bus->active = true;
+    }
+    if (bus->t.len < SIM_I2C_DATA_MAX) {
+        bus->t.data[bus->t.len] = data_cmd & 0xff;
+    }
+    bus->t.len++;
+    if (data_cmd & I2C_IC_DATA_CMD_STOP_BITS) {
+        sim_i2c_end(index, false);
+    }
+}
+
+// sim_i2c_capture takes a word written to IC_DATA_CMD by the CPU. It returns
+// true if there was one.
+static bool sim_i2c_capture(uint index) {
+    i2c_hw_t *hw = &sim_i2c_hw[index];
+    uint32_t data_cmd = hw->data_cmd;
+    if (data_cmd == SIM_I2C_EMPTY) {
+        return false;
+    }
+    hw->data_cmd = SIM_I2C_EMPTY;
+    sim_i2c_put(index, data_cmd);
+    return true;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    (void)i2c;
+    return baudrate;
+}
+
+i2c_hw_t *i2c_get_hw(i2c_inst_t *i2c) {
+    sim_i2c_capture(i2c_get_index(i2c));
+    return i2c->hw;
+}
+
+size_t i2c_get_write_available(i2c_inst_t *i2c) {
+    if (sim_i2c_capture(i2c_get_index(i2c))) {
+        sim_advance(SIM_I2C_BYTE_US);
+    }
+    return 16;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    uint index = i2c_get_index(i2c);
+    sim_i2c_capture(index);
+    sim_i2c_hw[index].tar = addr;
+    for (size_t i = 0; i < len; i++) {
+        sim_i2c_put(index, src[i] | (i == len - 1 && !nostop ? I2C_IC_DATA_CMD_STOP_BITS : 0));
+    }
+    sim_advance((len + 1) * SIM_I2C_BYTE_US);
+    return sim_i2c_nacked[addr & 0x7f] ? PICO_ERROR_GENERIC : (int)len;
+}
+
+void sim_i2c_nack(uint8_t addr, bool nack) {
+    sim_i2c_nacked[addr & 0x7f] = nack;
+}
+
+uint sim_i2c_count(void) {
+    for (uint i = 0; i < NUM_I2CS; i++) {
+        sim_i2c_capture(i);
+    }
+    return sim_i2c_transactions_len;
+}
+
+const sim_i2c_transaction_t *sim_i2c_get(uint back) {
+    uint n = sim_i2c_count();
+    if (back >= n || back >= SIM_I2C_TRANSACTIONS) {
+        return NULL;
+    }
+    return &sim_i2c_transactions[(n - 1 - back) % SIM_I2C_TRANSACTIONS];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// UART
+
+uint uart_init(uart_inst_t *uart, uint baudrate) {
+    (void)uart;
+    return baudrate;
+}
+
+bool uart_is_readable(uart_inst_t *uart) {
+    (void)uart;
+    return sim_uart_in_head != sim_uart_in_tail;
+}
+
+char uart_getc(uart_inst_t *uart) {
+    (void)uart;
+    if (sim_uart_in_head == sim_uart_in_tail) {
+        return 0;
+    }
+    return sim_uart_in[sim_uart_in_tail++ % sizeof(sim_uart_in)];
+}
+
+void sim_uart_input(const char *s) {
+    while (*s != '\0') {
+        sim_uart_in[sim_uart_in_head++ % sizeof(sim_uart_in)] = *s++;
+    }
+}
+
+const uint8_t *sim_uart_output(uint *len) {
+    *len = sim_uart_out_len;
+    return sim_uart_out;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// PIO
+
+int pio_claim_unused_sm(PIO pio, bool required) {
+    for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+        if ((pio->claimed & (1u << sm)) == 0) {
+            pio->claimed |= 1u << sm;
+            return sm;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "sim: no PIO state machine\n");
+        abort();
+    }
+    return -1;
+}
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    uint offset = pio->program_len;
+    pio->program_len += program->length;
+    return offset;
+}
+
+uint sim_pio_frame_count(void) {
+    return sim_pio_frames_len;
+}
+
+const sim_pio_frame_t *sim_pio_frame(uint back) {
+    if (back >= sim_pio_frames_len || back >= SIM_PIO_FRAMES) {
+        return NULL;
+    }
+    return &sim_pio_frames[(sim_pio_frames_len - 1 - back) % SIM_PIO_FRAMES];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// DMA
+
+int dma_claim_unused_channel(bool required) {
+    for (uint i = 0; i < NUM_DMA_CHANNELS; i++) {
+        if (!sim_dma_channels[i].claimed) {
+            sim_dma_channels[i].claimed = true;
+            return i;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "sim: no DMA channel\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(uint channel) {
+    sim_dma_channels[channel].claimed = false;
+}
+
+static uint32_t sim_dma_read(const sim_dma_channel_t *ch, uint32_t i) {
+    uint32_t at = ch->config.read_increment ? i : 0;
+    switch (ch->config.size) {
+        case DMA_SIZE_8:
+            return ((const volatile uint8_t *)ch->read_addr)[at];
+        case DMA_SIZE_16:
+            return ((const volatile uint16_t *)ch->read_addr)[at];
+        default:
+            return ((const volatile uint32_t *)ch->read_addr)[at];
+    }
+}
+
+// sim_dma_unit_us returns the time the target takes per transfer.
+static uint32_t sim_dma_unit_us(const sim_dma_channel_t *ch) {
+    for (uint i = 0; i < NUM_PIOS; i++) {
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+            if (ch->write_addr == &sim_pio_hw[i].txf[sm]) {
+                return SIM_WS2812_WORD_US;
+            }
+        }
+    }
+    for (uint i = 0; i < NUM_I2CS; i++) {
+        if (ch->write_addr == &sim_i2c_hw[i].data_cmd) {
+            return SIM_I2C_BYTE_US;
+        }
+    }
+    for (uint i = 0; i < NUM_UARTS; i++) {
+        if (ch->write_addr == &sim_uart_hw[i].dr) {
+            return SIM_UART_BYTE_US;
+        }
+    }
+    return 0;
+}
+
+static void sim_dma_start(uint channel) {
+    sim_dma_channel_t *ch = &sim_dma_channels[channel];
+    if (ch->busy) {
+        cancel_alarm(ch->event);
+    }
+    ch->busy = true;
+    ch->event = sim_schedule(SIM_EVENT_DMA, sim_time + (uint64_t)ch->count * sim_dma_unit_us(ch));
+    sim_find_event(ch->event)->channel = channel;
+}
+
+// sim_dma_write delivers the transfer to the sink of the target.
+static void sim_dma_write(sim_dma_channel_t *ch) {
+    for (uint i = 0; i < NUM_PIOS; i++) {
+        for (uint sm = 0; sm < NUM_PIO_STATE_MACHINES; sm++) {
+            if (ch->write_addr != &sim_pio_hw[i].txf[sm]) {
+                continue;
+            }
+            sim_pio_frame_t *f = &sim_pio_frames[sim_pio_frames_len++ % SIM_PIO_FRAMES];
+            f->at = sim_time;
+            f->len = ch->count < SIM_PIO_FRAME_MAX ? ch->count : SIM_PIO_FRAME_MAX;
+            for (uint32_t j = 0; j < f->len; j++) {
+                f->words[j] = sim_dma_read(ch, j);
+            }
+            return;
+        }
+    }
+    for (uint i = 0; i < NUM_I2CS; i++) {
+        if (ch->write_addr != &sim_i2c_hw[i].data_cmd) {
+            continue;
+        }
+        i2c_hw_t *hw = &sim_i2c_hw[i];
+        sim_i2c_capture(i);
+        for (uint32_t j = 0; j < ch->count; j++) {
+            sim_i2c_put(i, sim_dma_read(ch, j));
+        }
+        // STOP is generated on abort too.
+        bool aborted = sim_i2c_nacked[hw->tar & 0x7f];
+        sim_i2c_end(i, aborted);
+        hw->intr_stat = (I2C_IC_INTR_STAT_R_STOP_DET_BITS |
+                (aborted ? I2C_IC_INTR_STAT_R_TX_ABRT_BITS : 0)) & hw->intr_mask;
+        if (hw->intr_stat != 0) {
+            sim_raise_irq(i == 0 ? I2C0_IRQ : I2C1_IRQ);
+        }
+        hw->intr_stat = 0;
+        return;
+    }
+    for (uint i = 0; i < NUM_UARTS; i++) {
+        if (ch->write_addr != &sim_uart_hw[i].dr) {
+            continue;
+        }
+        for (uint32_t j = 0; j < ch->count && sim_uart_out_len < SIM_UART_MAX; j++) {
+            sim_uart_out[sim_uart_out_len++] = sim_dma_read(ch, j);
+        }
+        return;
+    }
+}
+
+static void sim_dma_complete(uint channel) {
+    sim_dma_channel_t *ch = &sim_dma_channels[channel];
+    ch->busy = false;
+    sim_dma_write(ch);
+    uint32_t mask = 1u << channel;
+    if (ch->irq0) {
+        dma_hw->ints0 |= mask;
+        sim_raise_irq(DMA_IRQ_0);
+        dma_hw->ints0 &= ~mask;
+    }
+    if (ch->irq1) {
+        dma_hw->ints1 |= mask;
+        sim_raise_irq(DMA_IRQ_1);
+        dma_hw->ints1 &= ~mask;
+    }
+}
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+        const volatile void *read_addr, uint transfer_count, bool trigger) {
+    sim_dma_channel_t *ch = &sim_dma_channels[channel];
+    ch->config = *config;
+    ch->write_addr = write_addr;
+    ch->read_addr = read_addr;
+    ch->count = transfer_count;
+    if (trigger) {
+        sim_dma_start(channel);
+    }
+}
+
+void dma_channel_set_read_addr(uint channel, const volatile void *read_addr, bool trigger) {
+    sim_dma_channels[channel].read_addr = read_addr;
+    if (trigger) {
+        sim_dma_start(channel);
+    }
+}
+
+void dma_channel_set_trans_count(uint channel, uint32_t trans_count, bool trigger) {
+    sim_dma_channels[channel].count = trans_count;
+    if (trigger) {
+        sim_dma_start(channel);
+    }
+}
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count) {
+    sim_dma_channels[channel].read_addr = read_addr;
+    sim_dma_channels[channel].count = transfer_count;
+    sim_dma_start(channel);
+}
+
+void dma_channel_abort(uint channel) {
+    sim_dma_channel_t *ch = &sim_dma_channels[channel];
+    if (ch->busy) {
+        cancel_alarm(ch->event);
+        ch->busy = false;
+    }
+}
+
+bool dma_channel_is_busy(uint channel) {
+    return sim_dma_channels[channel].busy;
+}
+
+void dma_channel_set_irq0_enabled(uint channel, bool enabled) {
+    sim_dma_channels[channel].irq0 = enabled;
+}
+
+void dma_channel_set_irq1_enabled(uint channel, bool enabled) {
+    sim_dma_channels[channel].irq1 = enabled;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+// Reset
+
+void sim_reset(void) {
+    sim_time = 0;
+    memset(sim_events, 0, sizeof(sim_events));
+    sim_event_seq = 0;
+    sim_next_id = 0;
+    memset(sim_irq_handlers, 0, sizeof(sim_irq_handlers));
+    sim_irq_enabled = 0;
+
+    sim_gpio_oe = 0;
+    sim_gpio_out = 0;
+    sim_gpio_pull_up = 0;
+    sim_gpio_drive_low = 0;
+    sim_gpio_drive_high = 0;
+    memset(sim_gpio_switches, 0, sizeof(sim_gpio_switches));
+
+    memset(&sim_systick_hw, 0, sizeof(sim_systick_hw));
+    memset(&sim_dma_hw, 0, sizeof(sim_dma_hw));
+    memset(sim_dma_channels, 0, sizeof(sim_dma_channels));
+    memset(sim_pio_hw, 0, sizeof(sim_pio_hw));
+    memset(sim_pio_frames, 0, sizeof(sim_pio_frames));
+    sim_pio_frames_len = 0;
+
+    memset(sim_i2c_hw, 0, sizeof(sim_i2c_hw));
+    for (uint i = 0; i < NUM_I2CS; i++) {
+        sim_i2c_hw[i].data_cmd = SIM_I2C_EMPTY;
+        sim_i2c_hw[i].raw_intr_stat = I2C_IC_RAW_INTR_STAT_STOP_DET_BITS;
+    }
+    memset(sim_i2c_buses, 0, sizeof(sim_i2c_buses));
+    sim_i2c_transactions_len = 0;
+    memset(sim_i2c_nacked, 0, sizeof(sim_i2c_nacked));
+
+    memset(sim_uart_hw, 0, sizeof(sim_uart_hw));
+    sim_uart_out_len = 0;
+    sim_uart_in_head = 0;
+    sim_uart_in_tail = 0;
+}
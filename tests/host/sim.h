@@ -0,0 +1,110 @@
+#pragma once
+
+#include <pico/types.h>
+
+// Simulation of the RP2040 for host tests, behind the subset of Pico SDK
+// headers in include/. Drivers are compiled from their sources as is.
+//
+//  - Time is a virtual microsecond clock. It moves only by sim_advance() and
+//    by busy waits and sleeps of the code under test, and events due meanwhile
+//    (alarms and DMA completions) run in order, as IRQs would.
+//  - GPIO is a pin model. Outputs drive their level, inputs read their pull,
+//    and switches of a key matrix connect two pins, so a selected row pulls
+//    the columns of closed switches low. Pins may be driven from outside too,
+//    as an encoder does.
+//  - DMA completes after the time the peripheral would take, and writes to
+//    sinks: WS2812 frames from PIO TX FIFOs, I2C transactions from IC_DATA_CMD
+//    and bytes from the UART. Writes to IC_DATA_CMD by the CPU are captured
+//    at the next i2c_get_hw() or i2c_get_write_available(), which drivers call
+//    around each of them.
+
+//////////////////////////////////////////////////////////////////////////////
+// Configurations
+
+// Max number of frames and transactions kept by sinks. Older ones are
+// dropped.
+#define SIM_PIO_FRAMES          16
+#define SIM_PIO_FRAME_MAX       64
+#define SIM_I2C_TRANSACTIONS    64
+#define SIM_I2C_DATA_MAX        1100
+#define SIM_UART_MAX            (64 * 1024)
+
+// Time to send a unit, which delays the completion of DMA.
+#define SIM_WS2812_WORD_US      30
+#define SIM_I2C_BYTE_US         23
+#define SIM_UART_BYTE_US        87
+
+//////////////////////////////////////////////////////////////////////////////
+// Types
+
+typedef struct {
+    uint64_t at;
+    uint len;
+    uint32_t words[SIM_PIO_FRAME_MAX];
+} sim_pio_frame_t;
+
+typedef struct {
+    uint64_t at;
+    uint8_t addr;
+    // NACKed by sim_i2c_nack().
+    bool aborted;
+    uint len;
+    uint8_t data[SIM_I2C_DATA_MAX];
+} sim_i2c_transaction_t;
+
+//////////////////////////////////////////////////////////////////////////////
+// Functions
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// sim_reset powers the simulation on: the clock goes back to 0, every pin,
+// channel and IRQ is released and every sink is emptied. Drivers keep their
+// own state in static variables, so a test program calls it once, before
+// initializing drivers.
+void sim_reset(void);
+
+uint64_t sim_now(void);
+
+// sim_advance moves the clock, and runs events due on the way.
+void sim_advance(uint64_t us);
+
+// sim_switch opens or closes a switch between p0 and p1.
+void sim_switch(uint p0, uint p1, bool closed);
+
+// sim_gpio_drive drives a pin from outside, low or high, or releases it by
+// level -1.
+void sim_gpio_drive(uint gpio, int level);
+
+// sim_gpio_outputs returns pins set to output.
+uint32_t sim_gpio_outputs(void);
+
+// sim_encoder_set connects pins a and b of an encoder to the common pin by a
+// 2-bit word, A at bit 0 and B at bit 1. A clockwise detent is 1, 3, 2, 0 and
+// a counterclockwise one is 2, 3, 1, 0.
+void sim_encoder_set(uint a, uint b, uint word);
+
+// sim_pio_frame_count returns the number of frames written to PIO TX FIFOs,
+// and sim_pio_frame returns one of the last SIM_PIO_FRAMES, 0 being the
+// latest.
+uint sim_pio_frame_count(void);
+const sim_pio_frame_t *sim_pio_frame(uint back);
+
+// sim_i2c_count returns the number of I2C transactions, and sim_i2c_get
+// returns one of the last SIM_I2C_TRANSACTIONS, 0 being the latest.
+uint sim_i2c_count(void);
+const sim_i2c_transaction_t *sim_i2c_get(uint back);
+
+// sim_i2c_nack makes transactions to addr abort, as a missing device does.
+void sim_i2c_nack(uint8_t addr, bool nack);
+
+// sim_uart_output returns bytes sent by the UART.
+const uint8_t *sim_uart_output(uint *len);
+
+// sim_uart_input queues bytes to be received by the UART.
+void sim_uart_input(const char *s);
+
+#ifdef __cplusplus
+}
+#endif
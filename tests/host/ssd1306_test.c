@@ -0,0 +1,161 @@
+#include <string.h>
+
+#include "driver/ssd1306.h"
+
+#include "sim.h"
+#include "test.h"
+
+// A 128x32 panel on i2c0. Blocking functions write IC_DATA_CMD by the CPU,
+// and asynchronous ones by DMA, and both end up in the I2C sink.
+
+#define WIDTH   128
+#define HEIGHT  32
+#define BUF_LEN SSD1306_BUF_LEN(WIDTH, HEIGHT)
+
+static uint8_t fb[SSD1306_BUF_PREFIX_LEN + BUF_LEN];
+static uint8_t shadow[BUF_LEN];
+
+static ssd1306_t d = {
+    .addr   = SSD1306_I2C_ADDR,
+    .width  = WIDTH,
+    .height = HEIGHT,
+    .fb     = fb,
+    .shadow = shadow,
+};
+
+// assert_commands asserts that t has commands of the list, or each preceded
+// by the control byte 0x80 when paired.
+static void assert_commands(const sim_i2c_transaction_t *t, const uint8_t *cmds, uint n, bool paired) {
+    TEST_ASSERT_EQ(SSD1306_I2C_ADDR, t->addr);
+    TEST_ASSERT(!t->aborted);
+    if (paired) {
+        TEST_ASSERT(t->len >= 2 * n);
+        for (uint i = 0; i < n; i++) {
+            TEST_ASSERT_EQ(0x80, t->data[2 * i]);
+            TEST_ASSERT_EQ(cmds[i], t->data[2 * i + 1]);
+        }
+    } else {
+        TEST_ASSERT_EQ(n + 1, t->len);
+        TEST_ASSERT_EQ(0x00, t->data[0]);
+        TEST_ASSERT(memcmp(t->data + 1, cmds, n) == 0);
+    }
+}
+
+// Initialization sends commands, and renders the cleared frame.
+static void test_init(void) {
+    TEST_ASSERT_EQ(4, sim_i2c_count());
+    const sim_i2c_transaction_t *t = sim_i2c_get(3);
+    TEST_ASSERT_EQ(0x00, t->data[0]);
+    TEST_ASSERT_EQ(SSD1306_SET_DISP, t->data[1]);
+    TEST_ASSERT_EQ(SSD1306_SET_DISP | 0x01, t->data[t->len - 1]);
+
+    static const uint8_t window[] = { SSD1306_SET_COL_ADDR, 0, WIDTH - 1, SSD1306_SET_PAGE_ADDR, 0, 3 };
+    assert_commands(sim_i2c_get(2), window, sizeof(window), false);
+
+    t = sim_i2c_get(1);
+    TEST_ASSERT_EQ(1 + BUF_LEN, t->len);
+    TEST_ASSERT_EQ(0x40, t->data[0]);
+    for (uint i = 1; i < t->len; i++) {
+        TEST_ASSERT_EQ(0, t->data[i]);
+    }
+
+    static const uint8_t start_line[] = { SSD1306_SET_DISP_START_LINE };
+    assert_commands(sim_i2c_get(0), start_line, 1, false);
+    TEST_ASSERT(memcmp(d.buf, d.shadow, BUF_LEN) == 0);
+}
+
+// Close changes in a page are sent as a span, in a transaction by DMA.
+static void test_render_diff(void) {
+    uint n = sim_i2c_count();
+    TEST_ASSERT(!ssd1306_render_diff_async(&d));
+    d.buf[1 * WIDTH + 10] = 0xff;
+    d.buf[1 * WIDTH + 20] = 0x0f;
+    TEST_ASSERT(ssd1306_render_diff_async(&d));
+    TEST_ASSERT(ssd1306_busy(&d));
+    sim_advance(1000);
+    TEST_ASSERT(!ssd1306_busy(&d));
+    TEST_ASSERT_EQ(n + 1, sim_i2c_count());
+
+    const sim_i2c_transaction_t *t = sim_i2c_get(0);
+    static const uint8_t window[] = { SSD1306_SET_COL_ADDR, 10, 20, SSD1306_SET_PAGE_ADDR, 1, 1 };
+    assert_commands(t, window, sizeof(window), true);
+    TEST_ASSERT_EQ(2 * sizeof(window) + 1 + 11, t->len);
+    TEST_ASSERT_EQ(0x40, t->data[2 * sizeof(window)]);
+    TEST_ASSERT(memcmp(t->data + 2 * sizeof(window) + 1, d.buf + WIDTH + 10, 11) == 0);
+
+    TEST_ASSERT(!ssd1306_render_diff_async(&d));
+    TEST_ASSERT(memcmp(d.buf, d.shadow, BUF_LEN) == 0);
+}
+
+// A span failed by NACK is sent again.
+static void test_render_diff_nack(void) {
+    d.buf[3 * WIDTH + 127] = 0x01;
+    sim_i2c_nack(SSD1306_I2C_ADDR, true);
+    TEST_ASSERT(ssd1306_render_diff_async(&d));
+    sim_advance(1000);
+    TEST_ASSERT(sim_i2c_get(0)->aborted);
+    sim_i2c_nack(SSD1306_I2C_ADDR, false);
+
+    uint n = sim_i2c_count();
+    TEST_ASSERT(ssd1306_render_diff_async(&d));
+    sim_advance(1000);
+    TEST_ASSERT_EQ(n + 1, sim_i2c_count());
+    const sim_i2c_transaction_t *t = sim_i2c_get(0);
+    TEST_ASSERT(!t->aborted);
+    TEST_ASSERT_EQ(0x01, t->data[t->len - 1]);
+    TEST_ASSERT(!ssd1306_render_diff_async(&d));
+}
+
+// A bitmap is decompressed into the stream.
+static void test_render_bitmap(void) {
+    static const uint8_t data[] = { 0x82, 0xaa };
+    static const gfx_bitmap_t b = { .width = 4, .height = 8, .flags = GFX_BITMAP_RLE, .size = sizeof(data), .data = data };
+    uint n = sim_i2c_count();
+    ssd1306_render_bitmap(&d, &b, 8, 2);
+    TEST_ASSERT_EQ(n + 2, sim_i2c_count());
+    static const uint8_t window[] = { SSD1306_SET_COL_ADDR, 8, 11, SSD1306_SET_PAGE_ADDR, 2, 2 };
+    assert_commands(sim_i2c_get(1), window, sizeof(window), false);
+    static const uint8_t want[] = { 0x40, 0xaa, 0xaa, 0xaa, 0xaa };
+    const sim_i2c_transaction_t *t = sim_i2c_get(0);
+    TEST_ASSERT_EQ(sizeof(want), t->len);
+    TEST_ASSERT(memcmp(t->data, want, sizeof(want)) == 0);
+}
+
+// Asynchronous initialization sends the same commands by DMA, and then the
+// whole frame by spans, as RAM of the panel is unknown.
+static void test_init_async(void) {
+    // the commands of ssd1306_init, followed by 3 transactions to render.
+    ssd1306_init(&d);
+    sim_i2c_transaction_t want = *sim_i2c_get(3);
+
+    uint n = sim_i2c_count();
+    d.buf[0] = 0xff;
+    TEST_ASSERT(ssd1306_init_async(&d));
+    TEST_ASSERT(!ssd1306_init_async(&d));
+    sim_advance(1000);
+    TEST_ASSERT_EQ(n + 1, sim_i2c_count());
+    const sim_i2c_transaction_t *t = sim_i2c_get(0);
+    TEST_ASSERT_EQ(want.len, t->len);
+    TEST_ASSERT(memcmp(want.data, t->data, t->len) == 0);
+    TEST_ASSERT_EQ(0, d.buf[0]);
+
+    while (ssd1306_render_diff_async(&d)) {
+        sim_advance(10 * 1000);
+    }
+    TEST_ASSERT_EQ(n + 1 + HEIGHT / SSD1306_PAGE_HEIGHT, sim_i2c_count());
+    TEST_ASSERT(memcmp(d.buf, d.shadow, BUF_LEN) == 0);
+}
+
+int main(void) {
+    sim_reset();
+    i2c_init(i2c0, 400 * 1000);
+    d.i2c = i2c0;
+    ssd1306_init(&d);
+
+    TEST_RUN(test_init);
+    TEST_RUN(test_render_diff);
+    TEST_RUN(test_render_diff_nack);
+    TEST_RUN(test_render_bitmap);
+    TEST_RUN(test_init_async);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#include "driver/switch_matrix.hpp"
+
+#include "keymap_yuiop29re.h"
+
+// switch_matrix_fixed for the matrix of yuiop29re, scanned by
+// switch_matrix_test.c along with switch_matrix_task.
+
+static constexpr switch_matrix_pin_t sm_pins[] = KEYMAP_YUIOP29RE_PINS;
+
+SWITCH_MATRIX_FIXED_DEFINE(sm_fixed, sm_pins)
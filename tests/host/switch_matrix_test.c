@@ -0,0 +1,224 @@
+#include <string.h>
+
+#include "driver/switch_matrix.h"
+#include "hardware/gpio.h"
+
+#include "sim.h"
+#include "test.h"
+
+#include "keymap_yuiop29re.h"
+
+// The matrix of yuiop29re is scanned by switch_matrix_task (sm_c) and by
+// switch_matrix_fixed (sm_f, switch_matrix_fixed.cpp) at the same times, and
+// both must report the same events.
+
+#define NUM_KEYS KEYMAP_YUIOP29RE_NUM_KEYS
+
+SWITCH_MATRIX_FIXED_DECLARE(sm_fixed)
+
+typedef struct {
+    uint64_t when;
+    uint index;
+    bool on;
+    bool suppressed;
+} event_t;
+
+typedef struct {
+    event_t events[256];
+    uint len;
+} recorded_t;
+
+static recorded_t rec_c, rec_f;
+
+static void record(switch_matrix_t *sm, uint64_t when, uint index, bool on, bool suppressed) {
+    recorded_t *r = sm->user;
+    TEST_ASSERT(r->len < count_of(r->events));
+    r->events[r->len++] = (event_t){ when, index, on, suppressed };
+}
+
+static void on_changed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on) {
+    record(sm, when, state_index, on, false);
+}
+
+static void on_suppressed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on, uint64_t last_changed) {
+    TEST_ASSERT(when - last_changed < sm->debounce_interval);
+    record(sm, when, state_index, on, true);
+}
+
+static switch_matrix_stats_t stats_c[NUM_KEYS], stats_f[NUM_KEYS];
+
+static switch_matrix_t sm_c = {
+    .num        = NUM_KEYS,
+    .states     = keymap_yuiop29re_sm_states,
+    .stats      = stats_c,
+    .user       = &rec_c,
+    .changed    = on_changed,
+    .suppressed = on_suppressed,
+};
+
+static switch_matrix_t sm_f = {
+    .stats      = stats_f,
+    .user       = &rec_f,
+    .changed    = on_changed,
+    .suppressed = on_suppressed,
+};
+
+static void press(uint index, bool closed) {
+    const switch_matrix_state_t *st = &keymap_yuiop29re_sm_states[index];
+    sim_switch(st->p0, st->p1, closed);
+}
+
+// run calls both tasks every 100us for us.
+static void run(uint64_t us) {
+    uint64_t until = sim_now() + us;
+    while (sim_now() < until) {
+        uint64_t now = sim_now();
+        switch_matrix_task(&sm_c, now);
+        sm_fixed_task(&sm_f, now);
+        sim_advance(100);
+    }
+}
+
+static void clear(void) {
+    rec_c.len = 0;
+    rec_f.len = 0;
+    switch_matrix_reset_stats(&sm_c);
+    switch_matrix_reset_stats(&sm_f);
+}
+
+static void assert_same_events(void) {
+    TEST_ASSERT_EQ(rec_c.len, rec_f.len);
+    for (uint i = 0; i < rec_c.len; i++) {
+        TEST_ASSERT_EQ(rec_c.events[i].when, rec_f.events[i].when);
+        TEST_ASSERT_EQ(rec_c.events[i].index, rec_f.events[i].index);
+        TEST_ASSERT_EQ(rec_c.events[i].on, rec_f.events[i].on);
+        TEST_ASSERT_EQ(rec_c.events[i].suppressed, rec_f.events[i].suppressed);
+    }
+    TEST_ASSERT(memcmp(stats_c, stats_f, sizeof(stats_c)) == 0);
+}
+
+// A press and a release are reported once each.
+static void test_press_release(void) {
+    clear();
+    press(7, true);
+    run(2000);
+    TEST_ASSERT_EQ(1, rec_c.len);
+    TEST_ASSERT_EQ(7, rec_c.events[0].index);
+    TEST_ASSERT(rec_c.events[0].on);
+    TEST_ASSERT(!rec_c.events[0].suppressed);
+
+    run(30 * 1000);
+    press(7, false);
+    run(2000);
+    TEST_ASSERT_EQ(2, rec_c.len);
+    TEST_ASSERT_EQ(7, rec_c.events[1].index);
+    TEST_ASSERT(!rec_c.events[1].on);
+    TEST_ASSERT_EQ(1, stats_c[7].presses);
+    TEST_ASSERT_EQ(1, stats_c[7].releases);
+    assert_same_events();
+    run(20 * 1000);
+}
+
+// A release within the debounce interval is suppressed on each scan, and
+// accepted after the interval.
+static void test_bounce(void) {
+    clear();
+    press(3, true);
+    run(1000);
+    press(3, false);
+    run(20 * 1000);
+    TEST_ASSERT(rec_c.len > 2);
+    TEST_ASSERT(rec_c.events[0].on);
+    TEST_ASSERT(rec_c.events[1].suppressed);
+    const event_t *last = &rec_c.events[rec_c.len - 1];
+    TEST_ASSERT(!last->on);
+    TEST_ASSERT(!last->suppressed);
+    TEST_ASSERT(last->when - rec_c.events[0].when >= sm_c.debounce_interval);
+    TEST_ASSERT_EQ(rec_c.len - 2, stats_c[3].bounces);
+    assert_same_events();
+}
+
+// Switches changed at once are reported in the order of state index,
+// including ones on the same row and column.
+static void test_many(void) {
+    clear();
+    const uint keys[] = { 29, 0, 5, 6, 11, 24, 28 };
+    for (uint i = 0; i < count_of(keys); i++) {
+        press(keys[i], true);
+    }
+    run(1000);
+    TEST_ASSERT_EQ(count_of(keys), rec_c.len);
+    for (uint i = 1; i < rec_c.len; i++) {
+        TEST_ASSERT(rec_c.events[i - 1].index < rec_c.events[i].index);
+        TEST_ASSERT(rec_c.events[i].on);
+    }
+    run(20 * 1000);
+    for (uint i = 0; i < count_of(keys); i++) {
+        press(keys[i], false);
+    }
+    run(1000);
+    TEST_ASSERT_EQ(2 * count_of(keys), rec_c.len);
+    assert_same_events();
+    run(20 * 1000);
+}
+
+// While idle, a pressed switch pulls its p1 pin low without scanning, and
+// the scan after idle reports it.
+static void test_idle(void) {
+    clear();
+    uint32_t wake_c = switch_matrix_idle_enter(&sm_c);
+    uint32_t wake_f = sm_fixed_idle_enter(&sm_f);
+    TEST_ASSERT_EQ(wake_c, wake_f);
+    TEST_ASSERT_EQ(0x3f0, wake_c);
+    TEST_ASSERT_EQ(wake_c, gpio_get_all() & wake_c);
+    press(13, true);
+    TEST_ASSERT_EQ(wake_c & ~(1u << keymap_yuiop29re_sm_states[13].p1), gpio_get_all() & wake_c);
+
+    switch_matrix_idle_exit(&sm_c);
+    sm_fixed_idle_exit(&sm_f);
+    TEST_ASSERT_EQ(0, sim_gpio_outputs());
+    uint64_t now = sim_now();
+    switch_matrix_task(&sm_c, now);
+    sm_fixed_task(&sm_f, now);
+    TEST_ASSERT_EQ(1, rec_c.len);
+    TEST_ASSERT_EQ(13, rec_c.events[0].index);
+    assert_same_events();
+    press(13, false);
+    run(30 * 1000);
+}
+
+// A scan runs regardless of scan_interval, which gates only the task.
+static void test_scan(void) {
+    clear();
+    press(20, true);
+    uint64_t now = sim_now();
+    switch_matrix_task(&sm_c, now);
+    sm_fixed_task(&sm_f, now);
+    TEST_ASSERT_EQ(0, rec_c.len);
+    switch_matrix_scan(&sm_c, now);
+    sm_fixed_scan(&sm_f, now);
+    TEST_ASSERT_EQ(1, rec_c.len);
+    TEST_ASSERT_EQ(20, rec_c.events[0].index);
+    assert_same_events();
+    run(20 * 1000);
+    press(20, false);
+    run(30 * 1000);
+}
+
+int main(void) {
+    sim_reset();
+    switch_matrix_init(&sm_c);
+    sm_fixed_init(&sm_f);
+    TEST_ASSERT_EQ(NUM_KEYS, sm_f.num);
+    TEST_ASSERT_EQ(sm_c.debounce_interval, sm_f.debounce_interval);
+    // past the debounce interval from the initial states.
+    run(20 * 1000);
+    TEST_ASSERT_EQ(0, rec_c.len);
+
+    TEST_RUN(test_press_release);
+    TEST_RUN(test_bounce);
+    TEST_RUN(test_many);
+    TEST_RUN(test_idle);
+    TEST_RUN(test_scan);
+    return 0;
+}
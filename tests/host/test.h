@@ -0,0 +1,27 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimal assertions for host tests. A failure prints the location and exits
+// with non-zero status, which fails ctest.
+
+#define TEST_ASSERT(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: %s: assertion failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+        exit(1); \
+    } \
+} while (0)
+
+#define TEST_ASSERT_EQ(want, got) do { \
+    long long w_ = (long long)(want), g_ = (long long)(got); \
+    if (w_ != g_) { \
+        fprintf(stderr, "%s:%d: %s: %s: want %lld, got %lld\n", __FILE__, __LINE__, __func__, #got, w_, g_); \
+        exit(1); \
+    } \
+} while (0)
+
+#define TEST_RUN(fn) do { \
+    fn(); \
+    printf("ok %s\n", #fn); \
+} while (0)
@@ -0,0 +1,283 @@
+#include <string.h>
+
+#include "usb/keyboard.h"
+
+#include "test.h"
+
+// Fake endpoint: reports are recorded, and the endpoint is busy from a send
+// until fake_complete().
+
+static bool fake_ready;
+static bool fake_busy;
+static bool fake_boot;
+static usb_keyboard_report_t fake_sent[64];
+static usb_keyboard_nkro_report_t fake_sent_nkro[64];
+static uint fake_sent_len;
+
+void usb_keyboard_port_init(void) {
+    fake_ready = true;
+    fake_busy = false;
+    fake_boot = false;
+    fake_sent_len = 0;
+}
+
+void usb_keyboard_port_task(void) {
+}
+
+bool usb_keyboard_port_ready(void) {
+    return fake_ready && !fake_busy;
+}
+
+bool usb_keyboard_port_boot(void) {
+    return fake_boot;
+}
+
+bool usb_keyboard_port_send(const void *report, uint16_t len) {
+    TEST_ASSERT(fake_sent_len < count_of(fake_sent));
+    if (fake_boot) {
+        TEST_ASSERT_EQ(sizeof(usb_keyboard_report_t), len);
+        memcpy(&fake_sent[fake_sent_len++], report, len);
+    } else {
+        TEST_ASSERT_EQ(sizeof(usb_keyboard_nkro_report_t), len);
+        memcpy(&fake_sent_nkro[fake_sent_len++], report, len);
+    }
+    fake_busy = true;
+    return true;
+}
+
+static void fake_complete(uint64_t now) {
+    fake_busy = false;
+    usb_keyboard_sent(now);
+}
+
+static void assert_keys(const usb_keyboard_report_t *r, uint8_t modifier, const uint8_t *keys, uint n) {
+    TEST_ASSERT_EQ(modifier, r->modifier);
+    for (uint i = 0; i < count_of(r->keycode); i++) {
+        TEST_ASSERT_EQ(i < n ? keys[i] : 0, r->keycode[i]);
+    }
+}
+
+// usb_keyboard_init with the boot protocol.
+static void init_boot(void) {
+    usb_keyboard_init();
+    fake_boot = true;
+}
+
+static void assert_nkro(const usb_keyboard_nkro_report_t *r, uint8_t modifier, const uint8_t *keys, uint n) {
+    usb_keyboard_nkro_report_t want = { .modifier = modifier };
+    for (uint i = 0; i < n; i++) {
+        want.bitmap[keys[i] / 8] |= 1 << (keys[i] % 8);
+    }
+    TEST_ASSERT_EQ(want.modifier, r->modifier);
+    for (uint i = 0; i < count_of(want.bitmap); i++) {
+        TEST_ASSERT_EQ(want.bitmap[i], r->bitmap[i]);
+    }
+}
+
+static void test_send_immediately(void) {
+    init_boot();
+    usb_keyboard_press(0x04, 100);
+    TEST_ASSERT_EQ(1, fake_sent_len);
+    TEST_ASSERT_EQ(0, usb_keyboard_pending());
+    assert_keys(&fake_sent[0], 0, (uint8_t[]){ 0x04 }, 1);
+    fake_complete(350);
+
+    usb_keyboard_release(0x04, 1000);
+    TEST_ASSERT_EQ(2, fake_sent_len);
+    assert_keys(&fake_sent[1], 0, NULL, 0);
+    fake_complete(1100);
+
+    const usb_keyboard_stats_t *st = usb_keyboard_stats();
+    TEST_ASSERT_EQ(2, st->count);
+    TEST_ASSERT_EQ(100, st->min);
+    TEST_ASSERT_EQ(250, st->max);
+    TEST_ASSERT_EQ(350, st->sum);
+}
+
+// Events in a same frame are sent in order. The release of 0x04 merges into
+// the report of the press of 0x05.
+static void test_queue_in_order(void) {
+    init_boot();
+    fake_ready = false;
+    usb_keyboard_press(0x04, 10);
+    usb_keyboard_press(0x05, 20);
+    usb_keyboard_release(0x04, 30);
+    usb_keyboard_release(0x05, 40);
+    TEST_ASSERT_EQ(0, fake_sent_len);
+    TEST_ASSERT_EQ(3, usb_keyboard_pending());
+
+    fake_ready = true;
+    usb_keyboard_task(1000);
+    TEST_ASSERT_EQ(1, fake_sent_len);
+    usb_keyboard_task(1001);
+    TEST_ASSERT_EQ(1, fake_sent_len);
+    for (uint i = 0; i < 3; i++) {
+        fake_complete(1000 * (i + 2));
+    }
+    TEST_ASSERT_EQ(3, fake_sent_len);
+    TEST_ASSERT_EQ(0, usb_keyboard_pending());
+    assert_keys(&fake_sent[0], 0, (uint8_t[]){ 0x04 }, 1);
+    assert_keys(&fake_sent[1], 0, (uint8_t[]){ 0x05 }, 1);
+    assert_keys(&fake_sent[2], 0, NULL, 0);
+    TEST_ASSERT_EQ(1, usb_keyboard_stats()->coalesced);
+    // the merged report counts from its first event at 20.
+    TEST_ASSERT_EQ((2000 - 10) + (3000 - 20) + (4000 - 40), usb_keyboard_stats()->sum);
+}
+
+static void test_modifiers(void) {
+    init_boot();
+    usb_keyboard_press(0xE1, 0);
+    fake_complete(1);
+    usb_keyboard_press(0xE4, 0);
+    fake_complete(2);
+    usb_keyboard_press(0x1C, 0);
+    fake_complete(3);
+    usb_keyboard_release(0xE1, 0);
+    fake_complete(4);
+    TEST_ASSERT_EQ(4, fake_sent_len);
+    assert_keys(&fake_sent[0], 0x02, NULL, 0);
+    assert_keys(&fake_sent[1], 0x12, NULL, 0);
+    assert_keys(&fake_sent[2], 0x12, (uint8_t[]){ 0x1C }, 1);
+    assert_keys(&fake_sent[3], 0x10, (uint8_t[]){ 0x1C }, 1);
+}
+
+static void test_rollover(void) {
+    init_boot();
+    for (uint8_t k = 0x04; k < 0x0B; k++) {
+        usb_keyboard_press(k, 0);
+        fake_complete(1);
+    }
+    TEST_ASSERT_EQ(7, fake_sent_len);
+    assert_keys(&fake_sent[5], 0, (uint8_t[]){ 4, 5, 6, 7, 8, 9 }, 6);
+    assert_keys(&fake_sent[6], 0, (uint8_t[]){ 1, 1, 1, 1, 1, 1 }, 6);
+    usb_keyboard_release(0x04, 0);
+    assert_keys(&fake_sent[7], 0, (uint8_t[]){ 5, 6, 7, 8, 9, 10 }, 6);
+}
+
+// A full queue merges new states into the last report, the final state is
+// kept.
+static void test_overflow(void) {
+    init_boot();
+    fake_ready = false;
+    for (uint i = 0; i < USB_KEYBOARD_QUEUE_LEN + 3; i++) {
+        if (i % 2 == 0) {
+            usb_keyboard_press(0x04, i);
+        } else {
+            usb_keyboard_release(0x04, i);
+        }
+    }
+    TEST_ASSERT_EQ(USB_KEYBOARD_QUEUE_LEN, usb_keyboard_pending());
+    TEST_ASSERT_EQ(3, usb_keyboard_stats()->overflows);
+
+    fake_ready = true;
+    usb_keyboard_task(0);
+    while (fake_busy) {
+        fake_complete(1000);
+    }
+    TEST_ASSERT_EQ(USB_KEYBOARD_QUEUE_LEN, fake_sent_len);
+    // the last event was a press.
+    assert_keys(&fake_sent[fake_sent_len - 1], 0, (uint8_t[]){ 0x04 }, 1);
+}
+
+static void test_nkro(void) {
+    usb_keyboard_init();
+    for (uint8_t k = 0x04; k < 0x0C; k++) {
+        usb_keyboard_press(k, 0);
+        fake_complete(1);
+    }
+    usb_keyboard_press(0xDF, 0);
+    fake_complete(1);
+    usb_keyboard_release(0x07, 0);
+    fake_complete(1);
+    TEST_ASSERT_EQ(10, fake_sent_len);
+    assert_nkro(&fake_sent_nkro[7], 0, (uint8_t[]){ 4, 5, 6, 7, 8, 9, 10, 11 }, 8);
+    assert_nkro(&fake_sent_nkro[9], 0, (uint8_t[]){ 4, 5, 6, 8, 9, 10, 11, 0xDF }, 8);
+}
+
+// Events which change nothing send no reports.
+static void test_nkro_unchanged(void) {
+    usb_keyboard_init();
+    usb_keyboard_press(0x04, 0);
+    fake_complete(1);
+    usb_keyboard_press(0x04, 0);
+    usb_keyboard_release(0x05, 0);
+    usb_keyboard_press(0xE8, 0);
+    usb_keyboard_press(0, 0);
+    TEST_ASSERT_EQ(1, fake_sent_len);
+    TEST_ASSERT_EQ(0, usb_keyboard_pending());
+}
+
+// A fast roll while the host is not polling: presses are in separate reports
+// in order, and releases merge into them.
+static void test_nkro_roll(void) {
+    usb_keyboard_init();
+    fake_ready = false;
+    usb_keyboard_press(0x04, 0);
+    usb_keyboard_press(0x05, 0);
+    usb_keyboard_release(0x04, 0);
+    usb_keyboard_release(0x05, 0);
+    usb_keyboard_press(0x06, 0);
+    usb_keyboard_release(0x06, 0);
+    TEST_ASSERT_EQ(4, usb_keyboard_pending());
+    TEST_ASSERT_EQ(2, usb_keyboard_stats()->coalesced);
+
+    fake_ready = true;
+    usb_keyboard_task(0);
+    while (fake_busy) {
+        fake_complete(1000);
+    }
+    TEST_ASSERT_EQ(4, fake_sent_len);
+    assert_nkro(&fake_sent_nkro[0], 0, (uint8_t[]){ 0x04 }, 1);
+    assert_nkro(&fake_sent_nkro[1], 0, (uint8_t[]){ 0x05 }, 1);
+    assert_nkro(&fake_sent_nkro[2], 0, (uint8_t[]){ 0x06 }, 1);
+    assert_nkro(&fake_sent_nkro[3], 0, NULL, 0);
+}
+
+// Taps in a frame are not lost, and modifiers are not merged.
+static void test_nkro_tap_and_modifier(void) {
+    usb_keyboard_init();
+    fake_ready = false;
+    usb_keyboard_press(0xE1, 0);
+    usb_keyboard_press(0x04, 0);
+    usb_keyboard_release(0x04, 0);
+    usb_keyboard_release(0xE1, 0);
+    TEST_ASSERT_EQ(4, usb_keyboard_pending());
+    TEST_ASSERT_EQ(0, usb_keyboard_stats()->coalesced);
+
+    fake_ready = true;
+    usb_keyboard_task(0);
+    while (fake_busy) {
+        fake_complete(1000);
+    }
+    TEST_ASSERT_EQ(4, fake_sent_len);
+    assert_nkro(&fake_sent_nkro[0], 0x02, NULL, 0);
+    assert_nkro(&fake_sent_nkro[1], 0x02, (uint8_t[]){ 0x04 }, 1);
+    assert_nkro(&fake_sent_nkro[2], 0x02, NULL, 0);
+    assert_nkro(&fake_sent_nkro[3], 0x00, NULL, 0);
+}
+
+// Switching the protocol sends current state in the new one.
+static void test_resend(void) {
+    usb_keyboard_init();
+    usb_keyboard_press(0x04, 0);
+    fake_complete(1);
+    fake_boot = true;
+    usb_keyboard_resend(2);
+    fake_complete(3);
+    TEST_ASSERT_EQ(2, fake_sent_len);
+    assert_keys(&fake_sent[1], 0, (uint8_t[]){ 0x04 }, 1);
+}
+
+int main(void) {
+    TEST_RUN(test_send_immediately);
+    TEST_RUN(test_queue_in_order);
+    TEST_RUN(test_modifiers);
+    TEST_RUN(test_rollover);
+    TEST_RUN(test_overflow);
+    TEST_RUN(test_nkro);
+    TEST_RUN(test_nkro_unchanged);
+    TEST_RUN(test_nkro_roll);
+    TEST_RUN(test_nkro_tap_and_modifier);
+    TEST_RUN(test_resend);
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <string.h>
+
+#include "driver/ws2812_array.h"
+#include "driver/ws2812_color.h"
+
+#include "sim.h"
+#include "test.h"
+
+// An array of 4 LEDs, limited to 10mA at 5mA per channel, which is 510 in
+// total of levels.
+
+static uint resetdelay_completed;
+
+void ws2812_array_resetdelay_completed(void) {
+    resetdelay_completed++;
+}
+
+static uint32_t grb(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint32_t)g << 24 | (uint32_t)r << 16 | (uint32_t)b << 8;
+}
+
+// A frame is sent in GRB order, and another is taken after the DMA and the
+// reset delay.
+static void test_frame(void) {
+    ws2812_array_set_rgb(0, 10, 20, 30);
+    ws2812_array_set_rgb(3, 1, 2, 3);
+    uint64_t start = sim_now();
+    TEST_ASSERT(ws2812_array_task(start));
+    TEST_ASSERT(!ws2812_array_dirty);
+
+    ws2812_array_set_rgb(1, 4, 5, 6);
+    TEST_ASSERT(!ws2812_array_task(sim_now()));
+    sim_advance(4 * SIM_WS2812_WORD_US);
+    TEST_ASSERT_EQ(1, sim_pio_frame_count());
+    const sim_pio_frame_t *f = sim_pio_frame(0);
+    TEST_ASSERT_EQ(start + 4 * SIM_WS2812_WORD_US, f->at);
+    TEST_ASSERT_EQ(4, f->len);
+    TEST_ASSERT_EQ(grb(10, 20, 30), f->words[0]);
+    TEST_ASSERT_EQ(0, f->words[1]);
+    TEST_ASSERT_EQ(0, f->words[2]);
+    TEST_ASSERT_EQ(grb(1, 2, 3), f->words[3]);
+
+    // the reset delay is 100us.
+    sim_advance(99);
+    TEST_ASSERT_EQ(0, resetdelay_completed);
+    TEST_ASSERT(!ws2812_array_task(sim_now()));
+    sim_advance(1);
+    TEST_ASSERT_EQ(1, resetdelay_completed);
+    TEST_ASSERT(ws2812_array_task(sim_now()));
+    sim_advance(4 * SIM_WS2812_WORD_US + 100);
+    TEST_ASSERT_EQ(2, sim_pio_frame_count());
+    TEST_ASSERT_EQ(grb(4, 5, 6), sim_pio_frame(0)->words[1]);
+    TEST_ASSERT_EQ(2, resetdelay_completed);
+}
+
+// Nothing is sent while states are not changed.
+static void test_clean(void) {
+    uint n = sim_pio_frame_count();
+    TEST_ASSERT(!ws2812_array_task(sim_now()));
+    sim_advance(1000);
+    TEST_ASSERT_EQ(n, sim_pio_frame_count());
+}
+
+// Levels over the limit are scaled down to it, and the states are kept.
+static void test_autocap(void) {
+    for (int i = 0; i < ws2812_array_num(); i++) {
+        ws2812_array_set_rgb(i, 255, 255, 255);
+    }
+    TEST_ASSERT(ws2812_array_task(sim_now()));
+    sim_advance(1000);
+    const sim_pio_frame_t *f = sim_pio_frame(0);
+    uint total = 0;
+    for (uint i = 0; i < f->len; i++) {
+        // 255 * 510 / 3060
+        TEST_ASSERT_EQ(grb(42, 42, 42), f->words[i]);
+        total += 3 * 42;
+    }
+    TEST_ASSERT(total <= 510);
+    TEST_ASSERT_EQ(255, ws2812_array_states[0].rgb.r);
+
+    // levels within the limit are sent as is.
+    for (int i = 0; i < ws2812_array_num(); i++) {
+        ws2812_array_set_rgb(i, 0, 0, 0);
+    }
+    ws2812_array_set_rgb(2, 200, 100, 210);
+    TEST_ASSERT(ws2812_array_task(sim_now()));
+    sim_advance(1000);
+    TEST_ASSERT_EQ(grb(200, 100, 210), sim_pio_frame(0)->words[2]);
+}
+
+// ws2812_color_scale rounds down as a division of each channel does.
+static void test_color_scale(void) {
+    for (uint32_t den = 2; den < 30000; den += 97) {
+        for (uint32_t num = 1; num < den && num < (1 << 16); num += 1 + den / 7) {
+            uint32_t f = ws2812_color_scale_factor(num, den);
+            for (uint v = 0; v < 256; v++) {
+                TEST_ASSERT_EQ(v * num / den, ws2812_color_scale8(v, num, den, f));
+            }
+        }
+    }
+}
+
+// Both kernels of ws2812_color_scale give the same colors.
+static void test_color_scale_kernels(void) {
+    ws2812_state_t a[64], b[64];
+    for (int i = 0; i < count_of(a); i++) {
+        a[i].rgb = (ws2812_color_t){ .r = i * 4, .g = 255 - i, .b = i * 37 };
+    }
+    memcpy(b, a, sizeof(b));
+    ws2812_color_scale_factor_kernel(a, count_of(a), 1234, 4321);
+    ws2812_color_scale_divide_kernel(b, count_of(b), 1234, 4321);
+    for (int i = 0; i < count_of(a); i++) {
+        TEST_ASSERT_EQ(b[i].rgb.r, a[i].rgb.r);
+        TEST_ASSERT_EQ(b[i].rgb.g, a[i].rgb.g);
+        TEST_ASSERT_EQ(b[i].rgb.b, a[i].rgb.b);
+    }
+}
+
+int main(void) {
+    sim_reset();
+    ws2812_array_init();
+    TEST_ASSERT_EQ(4, ws2812_array_num());
+
+    TEST_RUN(test_frame);
+    TEST_RUN(test_clean);
+    TEST_RUN(test_autocap);
+    TEST_RUN(test_color_scale);
+    TEST_RUN(test_color_scale_kernels);
+    return 0;
+}
@@ -2,9 +2,10 @@
 
 #include "pico/stdlib.h"
 #include "driver/rotary_encoder.h"
+#include "log/ring.h"
 
 int main() {
-    stdio_init_all();
+    log_ring_init();
     printf("\nYUIOP29RE: Rotaly Encoder monitor\n");
 
     rotary_encoder_t re1;
@@ -16,7 +17,7 @@ int main() {
         int delta = rotary_encoder_task(&re1, now);
         if (delta != 0) {
             re_sum = (re_sum + delta + 24) % 24;
-            printf("RE: delta=%-2d sum=%-2d at %llu\n", delta, re_sum, now);
+            LOG_RING("RE: delta=%-2d sum=%-2d at %llu\n", delta, re_sum, LOG_RING_U64(now));
         }
         tight_loop_contents();
     }
@@ -0,0 +1,7 @@
+#include "driver/switch_matrix.hpp"
+
+#include "keymap_yuiop29re.h"
+
+static constexpr switch_matrix_pin_t sm2_pins[] = KEYMAP_YUIOP29RE_PINS;
+
+SWITCH_MATRIX_FIXED_DEFINE(sm2_fixed, sm2_pins)
@@ -2,74 +2,55 @@
 
 #include "pico/stdlib.h"
 #include "driver/switch_matrix.h"
+#include "log/ring.h"
+#include "perf/probe.h"
 
-enum {
-    ROW1 = 14,
-    ROW2 = 13,
-    ROW3 = 12,
-    ROW4 = 11,
-    ROW5 = 10,
+#include "keymap_yuiop29re.h"
 
-    COL1 =  4,
-    COL2 =  5,
-    COL3 =  6,
-    COL4 =  7,
-    COL5 =  8,
-    COL6 =  9,
-};
+// The matrix is scanned by switch_matrix_task (sm1) and by switch_matrix_fixed
+// (sm2, fixed.cpp) in turn, and both log changes, which should be the same.
+// Send 'p' to the console to dump cycle counts of both scans (sm_scan and
+// sm_scan_fixed), and 'r' to reset them.
+SWITCH_MATRIX_FIXED_DECLARE(sm2_fixed)
 
-static switch_matrix_state_t sm_states[] = {
-    { ROW1, COL1 },
-    { ROW1, COL2 },
-    { ROW1, COL3 },
-    { ROW1, COL4 },
-    { ROW1, COL5 },
-    { ROW1, COL6 },
-
-    { ROW2, COL1 },
-    { ROW2, COL2 },
-    { ROW2, COL3 },
-    { ROW2, COL4 },
-    { ROW2, COL5 },
-    { ROW2, COL6 },
-
-    { ROW3, COL1 },
-    { ROW3, COL2 },
-    { ROW3, COL3 },
-    { ROW3, COL4 },
-    { ROW3, COL5 },
-    { ROW3, COL6 },
-
-    { ROW4, COL1 },
-    { ROW4, COL2 },
-    { ROW4, COL3 },
-    { ROW4, COL4 },
-    { ROW4, COL5 },
-    { ROW4, COL6 },
-
-    { ROW5, COL2 },
-    { ROW5, COL3 },
-    { ROW5, COL4 },
-    { ROW5, COL5 },
-    { ROW5, COL6 },
+static void on_sm2_changed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on) {
+    LOG_RING("switch_matrix_fixed: state_index=%-2u %-3s when=%llu\n", state_index, on ? "ON" : "OFF", LOG_RING_U64(when));
+}
 
-    { ROW5, COL1 },
-};
+static void on_sm2_suppressed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on, uint64_t last_changed) {
+    LOG_RING("switch_matrix_fixed: state_index=%-2u %-3s when=%llu elapsed=%lu (suppressed)\n", state_index, on ? "ON" : "OFF", LOG_RING_U64(when), (uint32_t)(when - last_changed));
+}
 
 int main() {
-    stdio_init_all();
+    log_ring_init();
+    PERF_PROBE_INIT();
     printf("\nYUIOP29RE: Switch Matrix monitor\n");
 
     switch_matrix_t sm1 = {
-        .num    = count_of(sm_states),
-        .states = &sm_states[0],
+        .num    = KEYMAP_YUIOP29RE_NUM_KEYS,
+        .states = keymap_yuiop29re_sm_states,
         .user   = (void *)1,
     };
     switch_matrix_init(&sm1);
 
+    switch_matrix_t sm2 = {
+        .user       = (void *)2,
+        .changed    = on_sm2_changed,
+        .suppressed = on_sm2_suppressed,
+    };
+    sm2_fixed_init(&sm2);
+
     while(true) {
         uint64_t now = time_us_64();
         switch_matrix_task(&sm1, now);
+        sm2_fixed_task(&sm2, now);
+        int c = getchar_timeout_us(0);
+        if (c == 'p') {
+            perf_probe_dump_request();
+        } else if (c == 'r') {
+            perf_probe_reset_all();
+        }
+        perf_probe_dump_task();
         tight_loop_contents();
     }
 }
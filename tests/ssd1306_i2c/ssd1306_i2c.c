@@ -11,8 +11,8 @@
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
-#include "raspberry26x32.h"
-#include "ssd1306_font.h"
+#include "gfx_bitmap_raspberry26x32.h"
+#include "gfx_font_8x8.h"
 
 /* Example code to talk to an SSD1306-based OLED display
 
@@ -188,7 +188,7 @@ void SSD1306_scroll(bool on) {
         0x00, // dummy byte
         0x00, // start page 0
         0x00, // time interval
-        0x03, // end page 3 SSD1306_NUM_PAGES ??
+        SSD1306_NUM_PAGES - 1, // end page
         0x00, // dummy byte
         0xFF, // dummy byte
         SSD1306_SET_SCROLL | (on ? 0x01 : 0) // Start/stop scrolling
@@ -264,14 +264,12 @@ static void DrawLine(uint8_t *buf, int x0, int y0, int x1, int y1, bool on) {
     }
 }
 
-static inline int GetFontIndex(uint8_t ch) {
-    if (ch >= 'A' && ch <='Z') {
-        return  ch - 'A' + 1;
+static inline const uint8_t *GetGlyph(uint8_t ch) {
+    const gfx_font_t *f = &gfx_font_8x8;
+    if (ch < f->first || ch > f->last) {
+        ch = ' '; // Not got that char so space.
     }
-    else if (ch >= '0' && ch <='9') {
-        return  ch - '0' + 27;
-    }
-    else return  0; // Not got that char so space.
+    return f->bitmaps + f->offsets[ch - f->first];
 }
 
 static void WriteChar(uint8_t *buf, int16_t x, int16_t y, uint8_t ch) {
@@ -282,11 +280,11 @@ static void WriteChar(uint8_t *buf, int16_t x, int16_t y, uint8_t ch) {
     y = y/8;
 
     ch = toupper(ch);
-    int idx = GetFontIndex(ch);
+    const uint8_t *glyph = GetGlyph(ch);
     int fb_idx = y * 128 + x;
 
     for (int i=0;i<8;i++) {
-        buf[fb_idx++] = font[idx * 8 + i];
+        buf[fb_idx++] = glyph[i];
     }
 }
 
@@ -355,20 +353,20 @@ int main() {
     // render 3 cute little raspberries
     struct render_area area = {
         start_page : 0,
-        end_page : (IMG_HEIGHT / SSD1306_PAGE_HEIGHT)  - 1
+        end_page : (gfx_bitmap_raspberry26x32.height / SSD1306_PAGE_HEIGHT)  - 1
     };
 
 restart:
 
     area.start_col = 0;
-    area.end_col = IMG_WIDTH - 1;
+    area.end_col = gfx_bitmap_raspberry26x32.width - 1;
 
     calc_render_area_buflen(&area);
 
-    uint8_t offset = 5 + IMG_WIDTH; // 5px padding
+    uint8_t offset = 5 + gfx_bitmap_raspberry26x32.width; // 5px padding
 
     for (int i = 0; i < 3; i++) {
-        render(raspberry26x32, &area);
+        render((uint8_t *)gfx_bitmap_raspberry26x32.data, &area);
         area.start_col += offset;
         area.end_col += offset;
     }
@@ -1,426 +1,783 @@
-#define PERFCOUNT_LED_MATRIX_TASK       0
 #define FEATURE_LED_WHILE_PRESSING      0
 #define FEATURE_RAINBOW                 1
+#define FEATURE_SWITCH_MATRIX_FIXED     1
 
 #include <stdio.h>
 #include <string.h>
-#include <math.h>
 
 #include "pico/stdlib.h"
 #include "driver/rotary_encoder.h"
+#include "driver/ssd1306.h"
 #include "driver/switch_matrix.h"
 #include "driver/ws2812_array.h"
+#include "flight/recorder.h"
+#include "gfx/mono.h"
+#include "keymap/keymap.h"
+#include "keymap/resolver.h"
+#include "led/effect.h"
+#include "led/matrix.h"
+#include "log/ring.h"
+#include "perf/hot.h"
+#include "perf/probe.h"
+#include "task/scheduler.h"
+#include "usb/keyboard.h"
 
 #include "hardware/i2c.h"
-#include "ssd1306.h"
+#include "hardware/irq.h"
+#include "hardware/watchdog.h"
+#include "gfx_bitmap_splash.h"
+#include "gfx_font_5x7.h"
+#include "keymap_yuiop29re.h"
 
-enum {
-    ROW1 = 14,
-    ROW2 = 13,
-    ROW3 = 12,
-    ROW4 = 11,
-    ROW5 = 10,
-
-    COL1 =  4,
-    COL2 =  5,
-    COL3 =  6,
-    COL4 =  7,
-    COL5 =  8,
-    COL6 =  9,
-};
-
-static switch_matrix_state_t sm_states[] = {
-    { ROW1, COL1 },
-    { ROW1, COL2 },
-    { ROW1, COL3 },
-    { ROW1, COL4 },
-    { ROW1, COL5 },
-    { ROW1, COL6 },
-
-    { ROW2, COL1 },
-    { ROW2, COL2 },
-    { ROW2, COL3 },
-    { ROW2, COL4 },
-    { ROW2, COL5 },
-    { ROW2, COL6 },
-
-    { ROW3, COL1 },
-    { ROW3, COL2 },
-    { ROW3, COL3 },
-    { ROW3, COL4 },
-    { ROW3, COL5 },
-    { ROW3, COL6 },
-
-    { ROW4, COL1 },
-    { ROW4, COL2 },
-    { ROW4, COL3 },
-    { ROW4, COL4 },
-    { ROW4, COL5 },
-    { ROW4, COL6 },
-
-    { ROW5, COL2 },
-    { ROW5, COL3 },
-    { ROW5, COL4 },
-    { ROW5, COL5 },
-    { ROW5, COL6 },
-
-    { ROW5, COL1 },
-};
+PERF_PROBE_DEFINE(oled_task);
 
 static int re_sum = 0;
 
-static uint8_t oled_buf[SSD1306_BUF_LEN] = {0};
+// Size of the panel. 128x64 panels work too.
+#define OLED_WIDTH  128
+#define OLED_HEIGHT 32
+#define OLED_PAGES  (OLED_HEIGHT / SSD1306_PAGE_HEIGHT)
+
+// 400 is usual, but often these can be overclocked to improve display response.
+// Tested at 1000 on both 32 and 84 pixel height devices and it worked.
+#define OLED_I2C_CLK 400
+
+static uint8_t oled_fb[SSD1306_BUF_PREFIX_LEN + SSD1306_BUF_LEN(OLED_WIDTH, OLED_HEIGHT)];
 
-struct render_area oled_frame = {
-    .start_col = 0,
-    .end_col = SSD1306_WIDTH - 1,
-    .start_page = 0,
-    .end_page = SSD1306_NUM_PAGES - 1
+// What the panel shows now.
+static uint8_t oled_shadow[SSD1306_BUF_LEN(OLED_WIDTH, OLED_HEIGHT)];
+
+static ssd1306_t oled = {
+    .i2c    = i2c_default,
+    .addr   = SSD1306_I2C_ADDR,
+    .width  = OLED_WIDTH,
+    .height = OLED_HEIGHT,
+    .fb     = oled_fb,
+    .shadow = oled_shadow,
 };
 
-static void oled_init() {
-    i2c_init(i2c_default, SSD1306_I2C_CLK * 1000);
+static gfx_mono_t oled_canvas;
+
+// Interval to move the display start line a row, while scrolling up.
+#define OLED_SCROLL_STEP_US (20 * 1000)
+
+// Upper limit of time spent by an oled_task() call. The work is split into
+// slices of a few microseconds (a glyph, a span), and oled_task() runs them
+// until the budget is used up, so it may overrun by a slice at most.
+#ifndef OLED_TASK_BUDGET_US
+#define OLED_TASK_BUDGET_US 100
+#endif
+
+static bool oled_dirty = false;
+
+static void oled_init_bus() {
+    i2c_init(i2c_default, OLED_I2C_CLK * 1000);
     gpio_set_function(PICO_DEFAULT_I2C_SDA_PIN, GPIO_FUNC_I2C);
     gpio_set_function(PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C);
     gpio_pull_up(PICO_DEFAULT_I2C_SDA_PIN);
     gpio_pull_up(PICO_DEFAULT_I2C_SCL_PIN);
-    SSD1306_init();
+}
+
+// oled_init starts to initialize the panel in background. It returns false
+// while the I2C controller is busy.
+static bool oled_init() {
+    if (!ssd1306_init_async(&oled)) {
+        return false;
+    }
 
-    calc_render_area_buflen(&oled_frame);
-    memset(oled_buf, 0, SSD1306_BUF_LEN);
-    render(oled_buf, &oled_frame);
+    gfx_mono_init(&oled_canvas, oled.buf, oled.width, oled.height);
+    // the splash is sent by oled_task(), a span per slice.
+    gfx_mono_draw_bitmap(&oled_canvas, 0, 0, &gfx_bitmap_splash, GFX_MONO_COPY);
+    oled_dirty = true;
+    return true;
 }
 
-static void oled_task(uint64_t now) {
-    static int mode = 0;
-    static uint64_t wait = 0;
-    static int last_re_sum = -1;
-    static char re_msg[30] = {0};
+// Stages to show a line of the RE sum log. The line is formatted, rasterized
+// a glyph per slice, and then transmitted a span per slice.
+typedef enum {
+    OLED_LOG_IDLE,
+    OLED_LOG_FORMAT,
+    OLED_LOG_RASTER,
+} oled_log_stage_t;
+
+static int oled_mode = 0;
+static uint64_t oled_wait = 0;
+
+static oled_log_stage_t oled_log_stage = OLED_LOG_IDLE;
+static int oled_last_re_sum = -1;
+static char oled_log_msg[32] = {0};
+static int oled_log_pos = 0;
+static int oled_log_x = 0;
+
+// oled_format_log formats a log line without floating point.
+static void oled_format_log(uint64_t now) {
+    uint32_t centisec = (uint32_t)(now / 10000);
+    snprintf(oled_log_msg, sizeof(oled_log_msg), "RE sum %d at %lu.%02lu s",
+            oled_last_re_sum, (unsigned long)(centisec / 100), (unsigned long)(centisec % 100));
+}
 
-    if (wait > 0 && wait > now) {
-        return;
+// oled_slice runs a slice of the display pipeline. It returns true when the
+// next slice can run immediately, or false when it waits for the I2C transfer
+// or time.
+static bool oled_slice(uint64_t now) {
+    switch (oled_log_stage) {
+        case OLED_LOG_FORMAT:
+            oled_format_log(now);
+            oled_log_pos = 0;
+            oled_log_x = 0;
+            oled_log_stage = OLED_LOG_RASTER;
+            return true;
+        case OLED_LOG_RASTER:
+            char ch = oled_log_msg[oled_log_pos];
+            if (ch == 0 || oled_log_x >= OLED_WIDTH) {
+                oled_log_stage = OLED_LOG_IDLE;
+                oled_dirty = true;
+                return true;
+            }
+            oled_log_x += gfx_mono_draw_char(&oled_canvas, oled_log_x, OLED_HEIGHT - SSD1306_PAGE_HEIGHT, &gfx_font_5x7, ch, GFX_MONO_COPY);
+            oled_log_pos++;
+            return true;
+        default:
+            break;
+    }
+
+    // Never wait for the display, retry at next call.
+    if (ssd1306_busy(&oled)) {
+        return false;
+    }
+    if (oled_dirty) {
+        oled_dirty = ssd1306_render_diff_async(&oled);
+        return !oled_dirty;
     }
-    wait = 0;
-    switch (mode) {
+    switch (oled_mode) {
         case 0:
-            SSD1306_send_cmd(SSD1306_SET_ALL_ON);
-            mode = 1;
-            wait = now + 500 * 1000;
-            break;
+            // slide the splash out by the controller.
+            if (ssd1306_hscroll_start_async(&oled, 0, OLED_PAGES - 1, true, 0x07)) {
+                oled_mode = 1;
+                oled_wait = now + 2000 * 1000;
+            }
+            return false;
         case 1:
-            static int count_1 = 0;
-            SSD1306_send_cmd(SSD1306_SET_ENTIRE_ON);
-            if (++count_1 >= 3) {
-                mode = 2;
-                break;
+            if (ssd1306_scroll_stop_async(&oled)) {
+                oled_dirty = true;
+                oled_mode = 2;
             }
-            mode = 0;
-            wait = now + 500 * 1000;
-            break;
+            return false;
         case 2:
-            if (last_re_sum == re_sum) {
-                break;
+            // log changes of RE sum, scrolling up by the start line.
+            if (ssd1306_scroll_step_async(&oled)) {
+                oled_wait = now + OLED_SCROLL_STEP_US;
+                return false;
             }
-            last_re_sum = re_sum;
-            snprintf(re_msg, sizeof(re_msg), "RE sum %-2d", re_sum);
-            WriteString(oled_buf, 0, 0, re_msg);
-            float sec = (float)now / 1000000;
-            snprintf(re_msg, sizeof(re_msg), "    at %.2f", sec);
-            WriteString(oled_buf, 0, 9, re_msg);
-            render(oled_buf, &oled_frame);
-            break;
+            if (oled_last_re_sum == re_sum) {
+                return false;
+            }
+            if (oled_last_re_sum < 0) {
+                gfx_mono_clear(&oled_canvas, false);
+            } else if (!ssd1306_scroll_up(&oled)) {
+                return false;
+            }
+            oled_last_re_sum = re_sum;
+            oled_log_stage = OLED_LOG_FORMAT;
+            return true;
     }
+    return false;
 }
 
-typedef struct {
-    float x;
-    float y;
-} led_pos_t;
-
-static led_pos_t led_positions[] = {
-    { 0.0, 0.8 }, { 0.2, 0.8 }, { 0.4, 0.8 }, { 0.6, 0.8 }, { 0.8, 0.8 },
-    { 1.0, 0.8 }, { 1.0, 0.6 }, { 0.8, 0.6 }, { 0.6, 0.6 }, { 0.4, 0.6 },
-    { 0.2, 0.6 }, { 0.0, 0.6 }, { 0.0, 0.4 }, { 0.2, 0.4 }, { 0.4, 0.4 },
-    { 0.6, 0.4 }, { 0.8, 0.4 }, { 1.0, 0.4 }, { 1.0, 0.2 }, { 0.8, 0.2 },
-    { 0.6, 0.2 }, { 0.4, 0.2 }, { 0.2, 0.2 }, { 0.0, 0.2 }, { 0.1, 0.0 },
-    { 0.3, 0.0 }, { 0.5, 0.0 }, { 0.7, 0.0 }, { 0.9, 0.0 },
-};
+static void oled_task(uint64_t now) {
+    if (oled_wait > 0 && oled_wait > now) {
+        return;
+    }
+    oled_wait = 0;
+    PERF_PROBE_SCOPE(oled_task);
+    uint32_t start = time_us_32();
+    while (oled_slice(now) && time_us_32() - start < OLED_TASK_BUDGET_US) {
+        // continue
+    }
+}
 
-const uint64_t frac_base_max = (1 << 22) - 1;
+static led_effect_push_t push_effects[KEYMAP_YUIOP29RE_NUM_LEDS] = {0};
 
-typedef void (*led_matrix_get_color_cb)(void *data, int idx, ws2812_color_t *c, led_pos_t *pos, uint64_t now);
+// User actions of the keymap.
+enum {
+    USER_RAINBOW,
+    USER_FLIGHT_DUMP,
+};
 
-typedef struct {
-    led_matrix_get_color_cb     fn;
-    void                        *data;
-} led_matrix_get_color_t;
+static void on_keymap_action(keymap_resolver_t *r, keymap_action_t action, bool on, uint64_t when);
 
-led_matrix_get_color_t led_matrix_get_color = {
-    .fn   = NULL,
-    .data = NULL
+// Actions of switches are resolved by timestamps, so tap-hold keys and combos
+// delay only the events which are ambiguous.
+static keymap_resolver_t keymap = {
+    .emit = on_keymap_action,
 };
 
-void led_matrix_get_color_call(led_matrix_get_color_t *getter, int idx, ws2812_color_t *c, led_pos_t *pos, uint64_t now) {
-    if (getter != NULL && getter->fn != NULL) {
-        getter->fn(getter->data, idx, c, pos, now);
+static void idle_on_activity(uint64_t when);
+
+static void on_sm_changed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on) {
+    idle_on_activity(when);
+    keymap_resolver_event(&keymap, state_index, on, when);
+    LOG_RING("sm%d_changed: state_index=%-2u %-3s when=%llu\n", (int)sm->user, state_index, on ? "ON" : "OFF", LOG_RING_U64(when));
+    int led_index = state_index < KEYMAP_YUIOP29RE_NUM_KEYS ? keymap_yuiop29re_key_to_led[state_index] : -1;
+    if (led_index >= 0) {
+#if FEATURE_LED_WHILE_PRESSING
+        if (on) {
+            led_effect_push_t effect = { .led_index=led_index, .start=when };
+            push_effects[led_index] = effect;
+            led_matrix_provider_add(led_effect_push, (void *)&push_effects[led_index]);
+        } else {
+            int i = led_matrix_provider_has(led_effect_push, (void *)&push_effects[led_index]);
+            if (i >= 0) {
+                led_matrix_provider_remove(i);
+            }
+        }
+#else
+        if (on) {
+            int i = led_matrix_provider_has(led_effect_push, (void *)&push_effects[led_index]);
+            if (i >= 0) {
+                led_matrix_provider_remove(i);
+            } else {
+                led_effect_push_t effect = { .led_index=led_index, .start=when };
+                push_effects[led_index] = effect;
+                led_matrix_provider_add(led_effect_push, (void *)&push_effects[led_index]);
+            }
+        }
+#endif
+    }
+}
+
+static void on_keymap_action(keymap_resolver_t *r, keymap_action_t action, bool on, uint64_t when) {
+    if (KEYMAP_KIND(action) == KEYMAP_KEY) {
+        if (on) {
+            usb_keyboard_press(KEYMAP_ARG(action), when);
+        } else {
+            usb_keyboard_release(KEYMAP_ARG(action), when);
+        }
+        return;
+    }
+    if (action == KEYMAP_ACTION(KEYMAP_USER, USER_RAINBOW) && on) {
+#if FEATURE_RAINBOW
+        static led_matrix_get_color_cb cb = led_effect_vertical_rainbow;
+#else
+        static led_matrix_get_color_cb cb = led_effect_white;
+#endif
+        int i = led_matrix_provider_has(cb, NULL);
+        if (i < 0) {
+            led_matrix_provider_add(cb, NULL);
+        } else {
+            led_matrix_provider_remove(i);
+        }
+    }
+    if (action == KEYMAP_ACTION(KEYMAP_USER, USER_FLIGHT_DUMP) && on) {
+        flight_recorder_trigger(FLIGHT_RECORDER_TRIGGER_USER);
     }
 }
 
-static void add_color(ws2812_color_t *c, uint8_t r, uint8_t g, uint8_t b);
+static int update_re_count(int sum, int delta, int max_count) {
+    return (sum + delta + max_count) % max_count;
+}
 
-static void get_white_color(void *data, int idx, ws2812_color_t *c, led_pos_t *pos, uint64_t now) {
-    add_color(c, 255, 255, 255);
+static void on_re_changed(rotary_encoder_t *re, uint64_t when, int8_t delta) {
+    idle_on_activity(when);
+    re_sum = update_re_count(re_sum, delta, ROTALY_ENCODER_1_COUNT);
+    LOG_RING("re1_changed: delta=%-2d sum=%-2d when=%llu\n", delta, re_sum, LOG_RING_U64(when));
 }
 
-void led_matrix_task(uint64_t now) {
-    static uint64_t last = 0;
-    if (now - last < 10000) {
-        return;
-    }
+static task_scheduler_t scheduler;
 
-#if PERFCOUNT_LED_MATRIX_TASK
-    static uint64_t sum   = 0;
-    static uint64_t count = 0;
-    uint64_t start = time_us_64();
+static switch_matrix_stats_t sm1_stats[KEYMAP_YUIOP29RE_NUM_KEYS];
+static switch_matrix_t sm1;
+
+// Console dumps are printed to the log ring, which drops what is written
+// faster than the UART sends it. So the perf task prints a row per run, and
+// only while the ring has room for a row beyond this many records.
+#ifndef CONSOLE_DUMP_RESERVE
+#define CONSOLE_DUMP_RESERVE 16
 #endif
 
-    last = now;
-    ws2812_array_dirty = true;
-    memset(ws2812_array_states, 0, sizeof(ws2812_array_states));
-    for (int i = 0; i < count_of(led_positions); i++) {
-        led_matrix_get_color_call(&led_matrix_get_color, i, &ws2812_array_states[i].rgb, &led_positions[i], now);
-    }
+// The switch printed next by switch_matrix_dump_task.
+static uint sm1_dump_pos = count_of(sm1_stats);
 
-#if PERFCOUNT_LED_MATRIX_TASK
-    sum += time_us_64() - start;
-    if (count++ >= 100) {
-        printf("led_matrix_task: performance %llu\n", sum / count);
-        sum = 0;
-        count = 0;
-    }
-#endif
+// switch_matrix_dump_request prints the header of switches which were pressed
+// or bounced, to find the ones wearing out. The switches are printed by
+// switch_matrix_dump_task later.
+static void switch_matrix_dump_request(void) {
+    printf("sm1: key presses hold(us) bounces min(us) <128 <256 <512 <1k <2k <4k <8k more\n");
+    sm1_dump_pos = 0;
 }
 
-static void add_color(ws2812_color_t *c, uint8_t r, uint8_t g, uint8_t b) {
-    c->r = MAX(c->r, r);
-    c->g = MAX(c->g, g);
-    c->b = MAX(c->b, b);
+// switch_matrix_dump_task prints a switch per call, in a printf to be a
+// single text of the log ring. It returns true while switches remain.
+static bool switch_matrix_dump_task(void) {
+    while (sm1_dump_pos < count_of(sm1_stats)) {
+        uint i = sm1_dump_pos++;
+        const switch_matrix_stats_t *st = &sm1_stats[i];
+        if (st->presses == 0 && st->bounces == 0) {
+            continue;
+        }
+        char hist[SWITCH_MATRIX_BOUNCE_HIST_NUM * 6 + 1];
+        uint n = 0;
+        for (uint b = 0; b < SWITCH_MATRIX_BOUNCE_HIST_NUM; b++) {
+            n += snprintf(hist + n, sizeof(hist) - n, " %4u", st->bounce_hist[b]);
+        }
+        printf("sm1: %3u %7lu %8lu %7lu %7lu%s\n", i, st->presses, switch_matrix_mean_hold(st),
+                st->bounces, st->bounces > 0 ? st->min_bounce : 0, hist);
+        return true;
+    }
+    return false;
 }
 
-static inline float fract(float x) {
-    return x - (int)x;
+static void usb_keyboard_dump(void) {
+    const usb_keyboard_stats_t *st = usb_keyboard_stats();
+    printf("usb: reports=%lu latency(us) min=%lu avg=%llu max=%lu coalesced=%lu overflows=%lu pending=%u\n",
+            st->count, st->min, st->count > 0 ? st->sum / st->count : 0,
+            st->max, st->coalesced, st->overflows, usb_keyboard_pending());
+    const keymap_resolver_stats_t *ks = &keymap.stats;
+    printf("keymap: immediate=%lu held=%lu latency(us) avg=%llu max=%lu overflows=%lu\n",
+            ks->immediate, ks->held, ks->held > 0 ? ks->sum_latency / ks->held : 0,
+            ks->max_latency, ks->overflows);
 }
 
-static void get_vertical_rainbow_color(void *data, int idx, ws2812_color_t *c, led_pos_t *pos, uint64_t now) {
-    const uint8_t L = 255;
-    float frac = (float)(now & frac_base_max) / (float)frac_base_max;
-    float hue = fract(frac + pos->x / 8.0) * 6.0;
-    uint8_t v = (uint8_t)(fract(hue) * L);
-    uint8_t L_v = L - v;
-    switch (((int)hue) % 6) {
-        case 0: add_color(c, L,   v,   0  ); break;
-        case 1: add_color(c, L_v, L,   0  ); break;
-        case 2: add_color(c, 0,   L,   v  ); break;
-        case 3: add_color(c, 0,   L_v, L  ); break;
-        case 4: add_color(c, v,   0,   L  ); break;
-        case 5: add_color(c, L,   0,   L_v); break;
+// perf_task dumps all probes when 'p' is received from the console, and
+// resets them when 'r' is received. It dumps the flight recorder first, once
+// triggered. Commands are read only while the log ring has room.
+static void perf_task(uint64_t now) {
+    if (log_ring_space() <= CONSOLE_DUMP_RESERVE) {
+        return;
+    }
+    if (flight_recorder_dump_task()) {
+        return;
+    }
+#if PERF_PROBE_ENABLED
+    if (perf_probe_dump_task()) {
+        return;
+    }
+#endif
+    if (task_scheduler_dump_task(&scheduler) || switch_matrix_dump_task()) {
+        return;
+    }
+    switch (getchar_timeout_us(0)) {
+#if PERF_PROBE_ENABLED
+        case 'p':
+            perf_probe_dump_request();
+            break;
+#endif
+        case 't':
+            task_scheduler_dump_request(&scheduler);
+            break;
+        case 'u':
+            usb_keyboard_dump();
+            break;
+        case 'c':
+            switch_matrix_dump_request();
+            break;
+        case 'f':
+            flight_recorder_trigger(FLIGHT_RECORDER_TRIGGER_USER);
+            break;
+        case 'l':
+            printf("log: written=%lu dropped=%lu\n", log_ring_stats()->written, log_ring_stats()->dropped);
+            break;
+        case 'r':
+#if PERF_PROBE_ENABLED
+            perf_probe_reset_all();
+#endif
+            task_scheduler_reset_stats(&scheduler);
+            usb_keyboard_reset_stats();
+            keymap_resolver_reset_stats(&keymap);
+            switch_matrix_reset_stats(&sm1);
+            break;
     }
 }
 
-#define GETTERS_MAX 30
+static rotary_encoder_t re1 = {
+    .user    = (void *)0,
+    .changed = on_re_changed,
+};
+
+// sm1 is scanned by switch_matrix_fixed for the pins of the keymap, defined
+// in matrix.cpp, or by the C driver.
+#if FEATURE_SWITCH_MATRIX_FIXED
+SWITCH_MATRIX_FIXED_DECLARE(sm1_fixed)
+#define sm1_init        sm1_fixed_init
+#define sm1_scan        sm1_fixed_scan
+#define sm1_idle_enter  sm1_fixed_idle_enter
+#define sm1_idle_exit   sm1_fixed_idle_exit
+#else
+#define sm1_init        switch_matrix_init
+#define sm1_scan        switch_matrix_scan
+#define sm1_idle_enter  switch_matrix_idle_enter
+#define sm1_idle_exit   switch_matrix_idle_exit
+#endif
 
-typedef struct {
-    led_matrix_get_color_t colors[GETTERS_MAX];
-} getters_t;
+static switch_matrix_t sm1 = {
+    .num     = KEYMAP_YUIOP29RE_NUM_KEYS,
+#if !FEATURE_SWITCH_MATRIX_FIXED
+    .states  = keymap_yuiop29re_sm_states,
+#endif
+    .stats   = sm1_stats,
+    .user    = (void *)1,
+    .changed = on_sm_changed,
+};
 
-static getters_t color_getters = {0};
+// Adapters of tasks for the scheduler. The scheduler is the only gate of
+// periods, so they call entry points which run regardless of the interval
+// of the driver.
 
-void color_getters_get_color(void *data, int idx, ws2812_color_t *c, led_pos_t *pos, uint64_t now) {
-    getters_t *p = (getters_t*)data;
-    for (int i = 0; i < GETTERS_MAX; i++) {
-        led_matrix_get_color_call(&p->colors[i], idx, c, pos, now);
-    }
+static void run_rotary_encoder(task_t *t, uint64_t now) {
+    rotary_encoder_task(t->user, now);
 }
 
-int color_provider_has(led_matrix_get_color_cb fn, void *data) {
-    for (int i = 0; i < GETTERS_MAX; i++) {
-        if (color_getters.colors[i].fn == fn && color_getters.colors[i].data == data) {
-            return i;
-        }
+// A gap between scans longer than this freezes the flight recorder, as keys
+// may be missed.
+#ifndef FLIGHT_TRIGGER_SCAN_GAP_US
+#define FLIGHT_TRIGGER_SCAN_GAP_US (5 * 1000)
+#endif
+
+// When the matrix was scanned last, or 0 after idle.
+static uint64_t sm1_last_run = 0;
+
+// When the matrix was scanned first, by the timer which starts at reset.
+static uint64_t sm1_first_run = 0;
+
+static void run_switch_matrix(task_t *t, uint64_t now) {
+    if (sm1_first_run == 0) {
+        sm1_first_run = now;
+        LOG_RING("boot: reset to first scan %lu us\n", (uint32_t)now);
+    }
+    if (sm1_last_run != 0 && now - sm1_last_run > FLIGHT_TRIGGER_SCAN_GAP_US) {
+        FLIGHT_RECORDER_PUT(USER, 0, 0, (uint32_t)(now - sm1_last_run));
+        flight_recorder_trigger(FLIGHT_RECORDER_TRIGGER_LATENCY);
     }
-    return -1;
+    sm1_last_run = now;
+    sm1_scan(t->user, now);
+    keymap_resolver_task(&keymap, now);
 }
 
-int color_provider_add(led_matrix_get_color_cb fn, void *data) {
-    for (int i = 0; i < GETTERS_MAX; i++) {
-        if (color_getters.colors[i].fn == NULL) {
-            color_getters.colors[i].fn   = fn;
-            color_getters.colors[i].data = data;
-            return i;
-        }
-    }
-    return -1;
+// The watchdog resets when the main loop stops, and the flight recorder keeps
+// what happened before. It is fed by the USB task, which runs even while idle.
+#ifndef WATCHDOG_TIMEOUT_MS
+#define WATCHDOG_TIMEOUT_MS 500
+#endif
+
+static void run_usb_keyboard(task_t *t, uint64_t now) {
+    watchdog_update();
+    usb_keyboard_task(now);
 }
 
-void color_provider_remove(int i) {
-    if (i >= 0 && i < GETTERS_MAX) {
-        color_getters.colors[i].fn   = NULL;
-        color_getters.colors[i].data = NULL;
-    }
+static void run_led_matrix(task_t *t, uint64_t now) {
+    led_matrix_render(now);
+}
+
+static void run_ws2812_array(task_t *t, uint64_t now) {
+    ws2812_array_task(now);
 }
 
-static float time_reduction(float x, float t) {
-    if (x >= 1.0)
-        return 1.0;
-    float denom = 1.0 - t;
-    if (denom < 1e-7)
-        denom = 1e-7;
-    float k = 1.0 / denom;
-    // A fast approximation of powf(x, k)
-    union { float f; int32_t i; } u;
-    u.f = x;
-    u.i = (int32_t)(k * (u.i - 0x3f7a3bea) + 0x3f7a3bea);
-    return u.f;
+static void run_oled(task_t *t, uint64_t now) {
+    oled_task(now);
 }
 
-typedef struct {
-    int led_index;
-    uint64_t start;
+static void run_perf(task_t *t, uint64_t now) {
+    perf_task(now);
+}
+
+static void idle_task(task_t *t, uint64_t now);
+static void boot_task(task_t *t, uint64_t now);
+
+enum {
+    TASK_RE1,
+    TASK_SM1,
+    TASK_USB,
+    TASK_LED_MATRIX,
+    TASK_WS2812,
+    TASK_OLED,
+    TASK_PERF,
+    TASK_BOOT,
+    TASK_IDLE,
+};
+
+// Inputs are polled with strict priority over LEDs and the display.
+// Budgets are in microseconds, send 't' to the console to see overruns.
+static task_t tasks[] = {
+    [TASK_RE1] = {
+        .name     = "re1",
+        .fn       = run_rotary_encoder,
+        .user     = &re1,
+        .period   = 100,
+        .priority = TASK_PRIORITY_INPUT,
+        .budget   = 20,
+    },
+    [TASK_SM1] = {
+        .name     = "sm1",
+        .fn       = run_switch_matrix,
+        .user     = &sm1,
+        .period   = 500,
+        .priority = TASK_PRIORITY_INPUT,
+        .budget   = 100,
+    },
+    // Reports are sent as soon as the endpoint is free, from the completion
+    // callback which runs in tud_task(). So this runs more often than the
+    // host polls (1ms).
+    [TASK_USB] = {
+        .name     = "usb",
+        .fn       = run_usb_keyboard,
+        .period   = 100,
+        .priority = TASK_PRIORITY_INPUT,
+        .budget   = 50,
+    },
+    [TASK_LED_MATRIX] = {
+        .name     = "led_matrix",
+        .fn       = run_led_matrix,
+        .period   = 10 * 1000,
+        .priority = TASK_PRIORITY_OUTPUT,
+        .budget   = 1000,
+    },
+    [TASK_WS2812] = {
+        .name     = "ws2812",
+        .fn       = run_ws2812_array,
+        .period   = 1000,
+        .priority = TASK_PRIORITY_OUTPUT,
+        .budget   = 100,
+    },
+    [TASK_OLED] = {
+        .name     = "oled",
+        .fn       = run_oled,
+        .period   = 1000,
+        .priority = TASK_PRIORITY_OUTPUT,
+        .budget   = OLED_TASK_BUDGET_US + 20,
+    },
+    [TASK_PERF] = {
+        .name     = "perf",
+        .fn       = run_perf,
+        .period   = 10 * 1000,
+        .priority = TASK_PRIORITY_BACKGROUND,
+    },
+    [TASK_BOOT] = {
+        .name     = "boot",
+        .fn       = boot_task,
+        .period   = 1000,
+        .priority = TASK_PRIORITY_OUTPUT,
+        .budget   = 200,
+    },
+    [TASK_IDLE] = {
+        .name     = "idle",
+        .fn       = idle_task,
+        .period   = 100 * 1000,
+        .priority = TASK_PRIORITY_BACKGROUND,
+    },
+};
 
-    uint64_t cached_start;
-    uint64_t cached_now;
-    float cached_t;
-} push_effect_t;
+//////////////////////////////////////////////////////////////////////////////
+// Idle
 
-push_effect_t push_effects[29] = {0};
+// Time without any input before idle. LEDs and the OLED are blanked, and
+// tasks but USB are suspended until a switch or the rotary encoder is
+// touched. The CPU sleeps in WFE until a GPIO edge, a USB event or the
+// watchdog feed.
+#ifndef IDLE_TIMEOUT_MS
+#define IDLE_TIMEOUT_MS (5 * 60 * 1000)
+#endif
 
-// A fast approximation of powf(0.2, x)
-static float fast_pow_02(float x) {
-    if (x < 1e-7) {
-        return 1.0f;
+// Period of the USB task while idle. It runs on USB events, woken by
+// usb_keyboard_event(), and otherwise only to feed the watchdog.
+#define IDLE_USB_PERIOD (WATCHDOG_TIMEOUT_MS * 1000 / 2)
+
+typedef enum {
+    IDLE_ACTIVE,
+    IDLE_BLANKING,
+    IDLE_SLEEPING,
+} idle_state_t;
+
+static idle_state_t idle_state = IDLE_ACTIVE;
+static uint64_t idle_last_activity = 0;
+static uint32_t idle_wake_pins = 0;
+// Wake pins which were low at sleep, by a held switch or the rotary encoder
+// resting with A or B low. They wake on the rising edge instead.
+static uint32_t idle_wake_low = 0;
+static uint32_t idle_usb_period;
+
+// When a GPIO edge woke up, until the first input event is reported.
+static volatile uint64_t idle_woken_at = 0;
+
+static void idle_on_activity(uint64_t when) {
+    idle_last_activity = when;
+    if (idle_woken_at != 0) {
+        LOG_RING("idle: woken to first event %lu us\n", (uint32_t)(when - idle_woken_at));
+        idle_woken_at = 0;
     }
-    float y = x * -2.321928f;
-    union { float f; int i; } u;
-    u.i = (int)((1 << 23) * (y + 126.942695f));
-    return u.f;
 }
 
-static void light_effect_on_switch_press(void *data, int idx, ws2812_color_t *c, led_pos_t *pos, uint64_t now) {
-    push_effect_t *p = (push_effect_t *)data;
-    led_pos_t *center = &led_positions[p->led_index];
-    float dx = pos->x - center->x;
-    float dy = pos->y - center->y;
-    float r = sqrtf(dx * dx + dy * dy);
-    if (p->cached_now != now || p->cached_start != p->start) {
-        p->cached_start = p->start;
-        p->cached_now = now;
-        p->cached_t = MIN((float)(now - p->start) / 1e6, 1);
-    }
-    float f = time_reduction(fast_pow_02(r / 0.2), p->cached_t);
-    uint8_t v = (uint8_t)(255 * f);
-    if (v > 0) {
-        add_color(c, v, v, v);
+static void idle_on_gpio(uint gpio, uint32_t events) {
+    if (idle_state != IDLE_SLEEPING || idle_woken_at != 0) {
+        return;
     }
+    idle_woken_at = time_us_64();
+    task_resume(&tasks[TASK_IDLE]);
 }
 
-static int sm_to_led_index[] = {
-     0,  1,  2,  3,  4,  5,
-    11, 10,  9,  8,  7,  6,
-    12, 13, 14, 15, 16, 17,
-    23, 22, 21, 20, 19, 18,
-      24, 25, 26, 27, 28,
-};
+void usb_keyboard_event(void) {
+    if (idle_state == IDLE_SLEEPING) {
+        task_wake(&tasks[TASK_USB]);
+    }
+}
 
-static void on_sm_changed(switch_matrix_t *sm, uint64_t when, uint state_index, bool on) {
-    printf("sm%d_changed: state_index=%-2d %-3s when=%llu\n", (int)sm->user, state_index, on ? "ON" : "OFF", when);
-    if (state_index < count_of(sm_to_led_index)) {
-        int led_index = sm_to_led_index[state_index];
-#if FEATURE_LED_WHILE_PRESSING
-        if (on) {
-            push_effect_t effect = { .led_index=led_index, .start=when };
-            push_effects[led_index] = effect;
-            color_provider_add(light_effect_on_switch_press, (void *)&push_effects[led_index]);
-        } else {
-            int i = color_provider_has(light_effect_on_switch_press, (void *)&push_effects[led_index]);
-            if (i >= 0) {
-                color_provider_remove(i);
-            }
+static void idle_set_wake(bool enabled) {
+    for (uint gpio = 0; gpio < 32; gpio++) {
+        if (idle_wake_pins & (1u << gpio)) {
+            uint32_t edge = (idle_wake_low & (1u << gpio)) ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+            // discard edges latched by scanning.
+            gpio_acknowledge_irq(gpio, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE);
+            gpio_set_irq_enabled(gpio, edge, enabled);
         }
-#else
-        if (on) {
-            int i = color_provider_has(light_effect_on_switch_press, (void *)&push_effects[led_index]);
-            if (i >= 0) {
-                color_provider_remove(i);
-            } else {
-                push_effect_t effect = { .led_index=led_index, .start=when };
-                push_effects[led_index] = effect;
-                color_provider_add(light_effect_on_switch_press, (void *)&push_effects[led_index]);
-            }
-        }
-#endif
     }
-    if (state_index == 29 && on) {
-#if FEATURE_RAINBOW
-        static led_matrix_get_color_cb cb = get_vertical_rainbow_color;
-#else
-        static led_matrix_get_color_cb cb = get_white_color;
-#endif
-        int i = color_provider_has(cb, NULL);
-        if (i < 0) {
-            color_provider_add(cb, NULL);
-        } else {
-            color_provider_remove(i);
+}
+
+static void idle_sleep(void) {
+    for (int i = 0; i < count_of(tasks); i++) {
+        // the host expects answers to its requests even while idle.
+        if (i != TASK_USB) {
+            task_suspend(&tasks[i]);
         }
     }
+    idle_usb_period = tasks[TASK_USB].period;
+    tasks[TASK_USB].period = IDLE_USB_PERIOD;
+    idle_wake_pins = sm1_idle_enter(&sm1) |
+        (1u << ROTALY_ENCODER_1_PIN_A) | (1u << ROTALY_ENCODER_1_PIN_B);
+    idle_woken_at = 0;
+    idle_state = IDLE_SLEEPING;
+    sm1_last_run = 0;
+    // Each pin is armed for the edge it can still make, so pins low at sleep
+    // don't wake at once.
+    idle_wake_low = ~gpio_get_all() & idle_wake_pins;
+    idle_set_wake(true);
+    // A pin changed before enabling the IRQ makes no edge.
+    if ((~gpio_get_all() & idle_wake_pins) != idle_wake_low) {
+        idle_on_gpio(0, 0);
+    }
 }
 
-static int update_re_count(int sum, int delta, int max_count) {
-    return (sum + delta + max_count) % max_count;
+static void idle_wake(uint64_t now) {
+    idle_set_wake(false);
+    sm1_idle_exit(&sm1);
+    // scan now, to report the switch which woke up before it is released.
+    sm1_scan(&sm1, now);
+    ssd1306_send_cmd(&oled, SSD1306_SET_DISP | 0x01);
+    tasks[TASK_USB].period = idle_usb_period;
+    for (int i = 0; i < count_of(tasks); i++) {
+        task_resume(&tasks[i]);
+    }
+    idle_last_activity = now;
+    idle_state = IDLE_ACTIVE;
+    if (idle_woken_at != 0) {
+        LOG_RING("idle: woken, scanned in %lu us\n", (uint32_t)(time_us_64() - idle_woken_at));
+    }
 }
 
-static void on_re_changed(rotary_encoder_t *re, uint64_t when, int8_t delta) {
-    re_sum = update_re_count(re_sum, delta, ROTALY_ENCODER_1_COUNT);
-    printf("re1_changed: delta=%-2d sum=%-2d when=%llu\n", delta, re_sum, when);
-}
+static bool boot_done(void);
 
-int main() {
-    stdio_init_all();
-    printf("\nYUIOP29RE: testfirm\n");
+static void idle_task(task_t *t, uint64_t now) {
+    switch (idle_state) {
+        case IDLE_ACTIVE:
+            if (!boot_done() || now - idle_last_activity < IDLE_TIMEOUT_MS * 1000ull) {
+                break;
+            }
+            LOG_RING("idle: sleep\n");
+            task_suspend(&tasks[TASK_LED_MATRIX]);
+            task_suspend(&tasks[TASK_OLED]);
+            memset(ws2812_array_states, 0, sizeof(ws2812_array_states));
+            ws2812_array_dirty = true;
+            idle_state = IDLE_BLANKING;
+            break;
+        case IDLE_BLANKING:
+            // wait for the LEDs and the OLED to be blanked.
+            if (ws2812_array_dirty || ssd1306_busy(&oled)) {
+                break;
+            }
+            ssd1306_send_cmd(&oled, SSD1306_SET_DISP);
+            idle_sleep();
+            break;
+        case IDLE_SLEEPING:
+            idle_wake(now);
+            break;
+    }
+}
 
-    rotary_encoder_t re1 = {
-        .user    = (void *)0,
-        .changed = on_re_changed,
-    };
-    rotary_encoder_init(&re1, ROTALY_ENCODER_1_PIN_A, ROTALY_ENCODER_1_PIN_B);
+//////////////////////////////////////////////////////////////////////////////
+// Boot
 
-    switch_matrix_t sm1 = {
-        .num     = count_of(sm_states),
-        .states  = &sm_states[0],
-        .user    = (void *)1,
-        .changed = on_sm_changed,
-    };
-    switch_matrix_init(&sm1);
+// Inputs are scanned from the first run of the scheduler, and outputs come
+// up after that in background, a stage per run of the boot task, so none of
+// them delays the first scan. Events meanwhile are queued by the keymap
+// resolver and the USB keyboard as usual.
+typedef enum {
+    BOOT_LEDS,
+    BOOT_OLED_BUS,
+    BOOT_OLED,
+    BOOT_DONE,
+} boot_stage_t;
 
-    ws2812_array_init();
+// Tasks which wait for the boot.
+static const int boot_tasks[] = { TASK_LED_MATRIX, TASK_WS2812, TASK_OLED };
 
-    led_matrix_get_color.data = &color_getters;
-    led_matrix_get_color.fn = color_getters_get_color;
+static boot_stage_t boot_stage = BOOT_LEDS;
 
-    oled_init();
+static bool boot_done(void) {
+    return boot_stage == BOOT_DONE;
+}
 
-    while(true) {
-        uint64_t now = time_us_64();
+static void boot_task(task_t *t, uint64_t now) {
+    switch (boot_stage) {
+        case BOOT_LEDS:
+            ws2812_array_init();
+            led_matrix_init(keymap_yuiop29re_led_positions, KEYMAP_YUIOP29RE_NUM_LEDS);
+            task_resume(&tasks[TASK_LED_MATRIX]);
+            task_resume(&tasks[TASK_WS2812]);
+            boot_stage = BOOT_OLED_BUS;
+            break;
+        case BOOT_OLED_BUS:
+            oled_init_bus();
+            boot_stage = BOOT_OLED;
+            break;
+        case BOOT_OLED:
+            if (!oled_init()) {
+                break;
+            }
+            task_resume(&tasks[TASK_OLED]);
+            boot_stage = BOOT_DONE;
+            LOG_RING("boot: reset to outputs %lu us\n", (uint32_t)now);
+            break;
+        case BOOT_DONE:
+            break;
+    }
+    // resumed by idle_wake() too, then suspends again.
+    if (boot_done()) {
+        task_suspend(t);
+    }
+}
 
-        rotary_encoder_task(&re1, now);
+int main() {
+    log_ring_init();
+    flight_recorder_init();
+    PERF_PROBE_INIT();
+    printf("\nYUIOP29RE: testfirm\n");
 
-        switch_matrix_task(&sm1, now);
+    rotary_encoder_init(&re1, ROTALY_ENCODER_1_PIN_A, ROTALY_ENCODER_1_PIN_B);
 
-        led_matrix_task(now);
+    keymap_resolver_init(&keymap, &keymap_yuiop29re);
+    sm1_init(&sm1);
 
-        ws2812_array_task(now);
+    usb_keyboard_init();
 
-        oled_task(now);
+    gpio_set_irq_callback(idle_on_gpio);
+    irq_set_enabled(IO_IRQ_BANK0, true);
 
-        tight_loop_contents();
+    task_scheduler_init(&scheduler);
+    for (int i = 0; i < count_of(tasks); i++) {
+        task_scheduler_add(&scheduler, &tasks[i]);
+    }
+    for (int i = 0; i < count_of(boot_tasks); i++) {
+        task_suspend(&tasks[boot_tasks[i]]);
     }
+    idle_last_activity = time_us_64();
+    watchdog_enable(WATCHDOG_TIMEOUT_MS, true);
+    task_scheduler_run(&scheduler);
 }
@@ -0,0 +1,10 @@
+#include "driver/switch_matrix.hpp"
+
+#include "keymap_yuiop29re.h"
+
+// The switch matrix of the keymap, specialized at compile time. main.c scans
+// it when FEATURE_SWITCH_MATRIX_FIXED is 1.
+
+static constexpr switch_matrix_pin_t sm1_pins[] = KEYMAP_YUIOP29RE_PINS;
+
+SWITCH_MATRIX_FIXED_DEFINE(sm1_fixed, sm1_pins)